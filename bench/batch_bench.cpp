@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк загрузки неупорядоченных пачек в xi::RBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// В дерево вливается несколько пачек случайных ключей: поэлементными \c insert()
+/// и через \c insertBatch() без пула и с пулом потоков.
+///
+/// Запуск: batch_bench [размер пачки] [число пачек]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include "bench_common.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Вставляет пачки поэлементно; повторы пропускаются. */
+static void insertEach(RBTree<std::uint64_t> &tree, const std::vector<std::uint64_t> &batch)
+{
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        try
+        {
+            tree.insert(batch[i]);
+        }
+        catch (const std::invalid_argument &)
+        {
+            // повтор случайного ключа — пропускаем
+        }
+    }
+}
+
+
+/** \brief Замеряет загрузку всех пачек и печатает строку. */
+template<typename Load>
+void runCase(const char *name, const std::vector<std::vector<std::uint64_t> > &batches, Load load)
+{
+    RBTree<std::uint64_t> tree;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < batches.size(); ++i)
+        load(tree, batches[i]);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::size_t total = batches.size() * batches[0].size();
+    std::printf("%-16s %10lld %14.3f\n", name, ms, static_cast<double>(total) / (ms ? ms : 1) / 1000.0);
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::size_t batchSize = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 1000000));
+    std::size_t batchesNum = static_cast<std::size_t>(bench::argOr(argc, argv, 2, 4));
+
+    bench::Rng rng(1);
+    std::vector<std::vector<std::uint64_t> > batches(batchesNum);
+    for (std::size_t i = 0; i < batchesNum; ++i)
+        for (std::size_t j = 0; j < batchSize; ++j)
+            batches[i].push_back(rng.next());
+
+    TaskPool pool;
+
+    std::printf("batch: %zu x %zu, pool threads: %zu\n", batchesNum, batchSize, pool.getThreadsNum());
+    std::printf("%-16s %10s %14s\n", "load", "ms", "Mkeys/s");
+
+    runCase("insert", batches, insertEach);
+    runCase("insertBatch", batches,
+            [](RBTree<std::uint64_t> &tree, const std::vector<std::uint64_t> &batch) {
+                tree.insertBatch(batch.begin(), batch.end());
+            });
+    runCase("insertBatch+pool", batches,
+            [&pool](RBTree<std::uint64_t> &tree, const std::vector<std::uint64_t> &batch) {
+                tree.insertBatch(batch.begin(), batch.end(), &pool);
+            });
+
+    return 0;
+}
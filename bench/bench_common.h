@@ -0,0 +1,100 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Общая обвязка многопоточных бенчмарков
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Запуск заданного числа потоков на фиксированное время, подсчет операций
+/// и дешевый генератор псевдослучайных ключей, одинаковые для всех бенчмарков.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_BENCH_BENCH_COMMON_H_
+#define RBTREE_BENCH_BENCH_COMMON_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+
+namespace bench
+{
+
+
+/** \brief Генератор xorshift64*: быстрый и без разделяемого состояния между потоками. */
+class Rng
+{
+public:
+    explicit Rng(std::uint64_t seed) : _state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    /** \brief Возвращает очередное псевдослучайное число. */
+    std::uint64_t next()
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545F4914F6CDD1DULL;
+    }
+
+    /** \brief Возвращает псевдослучайное число из [0, bound). */
+    std::uint64_t below(std::uint64_t bound) { return next() % bound; }
+
+protected:
+    std::uint64_t _state;
+};
+
+
+/** \brief Запускает \c threadsNum потоков \c worker на \c durationMs миллисекунд.
+ *
+ *  Поток \c i вызывает <tt>worker(i, stop)</tt>; тот крутит операции, пока \c stop ложен,
+ *  и возвращает их число. Все потоки стартуют одновременно.
+ *
+ *  \returns число операций каждого потока.
+ */
+template<typename Worker>
+std::vector<std::uint64_t> runThreads(std::size_t threadsNum, unsigned durationMs, Worker worker)
+{
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::vector<std::uint64_t> ops(threadsNum, 0);
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 0; i < threadsNum; ++i)
+        threads.push_back(std::thread([&, i]() {
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            ops[i] = worker(i, stop);
+        }));
+
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+    stop.store(true, std::memory_order_release);
+
+    for (std::size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    return ops;
+}
+
+
+/** \brief Переводит число операций за \c durationMs в миллионы операций в секунду. */
+inline double mops(std::uint64_t ops, unsigned durationMs)
+{
+    return static_cast<double>(ops) / durationMs / 1000.0;
+}
+
+
+/** \brief Возвращает \c argv[idx] как число или \c def, если аргумента нет. */
+inline std::uint64_t argOr(int argc, char *argv[], int idx, std::uint64_t def)
+{
+    return (idx < argc) ? std::strtoull(argv[idx], nullptr, 10) : def;
+}
+
+
+} // namespace bench
+
+
+#endif // RBTREE_BENCH_BENCH_COMMON_H_
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк xi::FlatCombiningRBTree под высокой конкуренцией писателей
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// 1..32 потока вставляют случайные ключи в одно дерево и ищут их. Сравниваются
+/// дерево под глобальным мьютексом и flat combining.
+///
+/// Запуск: combining_bench [длительность замера, мс]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+#include "bench_common.h"
+#include "flat_combining_rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Исходный вариант: дерево под глобальным мьютексом. */
+class MutexTree
+{
+public:
+    void insert(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _tree.insert(key);
+    }
+
+    bool contains(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        return _tree.find(key) != nullptr;
+    }
+
+protected:
+    std::mutex _lock;
+    RBTree<std::uint64_t> _tree;
+};
+
+
+/** \brief Замеряет операции \c threadsNum потоков и печатает строку. */
+template<typename Tree>
+void runCase(const char *name, Tree &tree, std::size_t threadsNum, unsigned durationMs)
+{
+    std::vector<std::uint64_t> ops = bench::runThreads(threadsNum, durationMs,
+            [&](std::size_t idx, const std::atomic<bool> &stop) -> std::uint64_t {
+                bench::Rng rng(idx + 1);
+                std::uint64_t done = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    // младшие биты — номер потока, чтобы ключи потоков не совпадали
+                    std::uint64_t key = (rng.next() << 6) | idx;
+                    try
+                    {
+                        tree.insert(key);
+                    }
+                    catch (const std::invalid_argument &)
+                    {
+                        // повтор случайного ключа — пропускаем
+                    }
+                    tree.contains(key >> 1);
+                    done += 2;
+                }
+                return done;
+            });
+
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < ops.size(); ++i)
+        total += ops[i];
+
+    std::printf("%-12s %8zu %14.3f\n", name, threadsNum, bench::mops(total, durationMs));
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned durationMs = static_cast<unsigned>(bench::argOr(argc, argv, 1, 500));
+
+    std::printf("duration: %u ms, hardware threads: %u\n", durationMs, std::thread::hardware_concurrency());
+    std::printf("%-12s %8s %14s\n", "tree", "threads", "Mops/s");
+
+    for (std::size_t threadsNum = 1; threadsNum <= 32; threadsNum *= 2)
+    {
+        {
+            MutexTree tree;
+            runCase("mutex", tree, threadsNum, durationMs);
+        }
+        {
+            FlatCombiningRBTree<std::uint64_t> tree;
+            runCase("combining", tree, threadsNum, durationMs);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк пропускной способности xi::ConcurrentRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Один писатель вставляет и удаляет случайные ключи, а 1..64 читателей ищут
+/// случайные ключи. Сравнивается обертка с разделяемой блокировкой и пакетной
+/// записью и дерево под одним глобальным мьютексом.
+///
+/// Запуск: concurrent_bench [число ключей] [длительность замера, мс]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <mutex>
+
+#include "bench_common.h"
+#include "concurrent_rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Исходный вариант: дерево под глобальным мьютексом. */
+class MutexTree
+{
+public:
+    void insert(int key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (!_tree.find(key))
+            _tree.insert(key);
+    }
+
+    void remove(int key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (_tree.find(key))
+            _tree.remove(key);
+    }
+
+    bool contains(int key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        return _tree.find(key) != nullptr;
+    }
+
+    void flush() {}
+
+protected:
+    std::mutex _lock;
+    RBTree<int> _tree;
+};
+
+
+/** \brief Заполняет \c tree четными ключами из [0, 2 * keysNum), замеряет и печатает строку. */
+template<typename Tree>
+void runCase(const char *name, Tree &tree, int keysNum, std::size_t readers, unsigned durationMs)
+{
+    for (int i = 0; i < keysNum; ++i)
+        tree.insert(2 * i);
+    tree.flush();
+
+    // поток 0 — писатель, остальные — читатели
+    std::vector<std::uint64_t> ops = bench::runThreads(readers + 1, durationMs,
+            [&](std::size_t idx, const std::atomic<bool> &stop) -> std::uint64_t {
+                bench::Rng rng(idx + 1);
+                std::uint64_t done = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    int key = static_cast<int>(rng.below(2 * keysNum));
+                    if (idx == 0)
+                    {
+                        if (done % 2)
+                            tree.insert(key);
+                        else
+                            tree.remove(key);
+                    }
+                    else
+                        tree.contains(key);
+                    ++done;
+                }
+                return done;
+            });
+
+    std::uint64_t readOps = 0;
+    for (std::size_t i = 1; i < ops.size(); ++i)
+        readOps += ops[i];
+
+    std::printf("%-12s %8zu %14.3f %14.3f\n", name, readers,
+                bench::mops(readOps, durationMs), bench::mops(ops[0], durationMs));
+}
+
+
+int main(int argc, char *argv[])
+{
+    int keysNum = static_cast<int>(bench::argOr(argc, argv, 1, 1 << 20));
+    unsigned durationMs = static_cast<unsigned>(bench::argOr(argc, argv, 2, 500));
+
+    std::printf("keys: %d, duration: %u ms, hardware threads: %u\n",
+                keysNum, durationMs, std::thread::hardware_concurrency());
+    std::printf("%-12s %8s %14s %14s\n", "tree", "readers", "read Mops/s", "write Mops/s");
+
+    for (std::size_t readers = 1; readers <= 64; readers *= 2)
+    {
+        {
+            MutexTree tree;
+            runCase("mutex", tree, keysNum, readers, durationMs);
+        }
+        {
+            ConcurrentRBTree<int> tree;
+            runCase("rw+batch", tree, keysNum, readers, durationMs);
+        }
+    }
+
+    return 0;
+}
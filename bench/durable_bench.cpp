@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк группового сброса журнала xi::DurableRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Потоки вставляют случайные ключи; каждая вставка возвращается, только когда ее
+/// запись сброшена на диск. Печатается пропускная способность и сколько операций
+/// в среднем пришлось на один fsync.
+///
+/// Запуск: durable_bench [каталог] [длительность, мс]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "bench_common.h"
+#include "durable_rbtree.h"
+
+
+using namespace xi;
+
+
+int main(int argc, char *argv[])
+{
+    std::string dir = (argc > 1) ? argv[1] : "durable_bench.db";
+    unsigned durationMs = static_cast<unsigned>(bench::argOr(argc, argv, 2, 2000));
+
+    std::printf("threads      Mops/s   ops/fsync\n");
+    for (std::size_t threadsNum = 1; threadsNum <= 16; threadsNum *= 2)
+    {
+        std::filesystem::remove_all(dir);
+        DurableRBTree<std::uint64_t> tree(dir);
+
+        std::vector<std::uint64_t> ops = bench::runThreads(threadsNum, durationMs,
+            [&tree](std::size_t id, const std::atomic<bool> &stop) {
+                bench::Rng rng(id + 1);
+                std::uint64_t n = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    tree.insert(rng.next());
+                    ++n;
+                }
+                return n;
+            });
+
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < ops.size(); ++i)
+            total += ops[i];
+        std::uint64_t syncs = tree.getSyncsNum();
+
+        std::printf("%7zu  %10.4f  %10.1f\n", threadsNum, bench::mops(total, durationMs),
+                    syncs ? static_cast<double>(total) / syncs : 0.0);
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк поиска от пальца в xi::RBTree на слиянии по возрастанию
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Отсортированный список проб (как внешняя сторона слияния) ищется в дереве
+/// по очереди: каждый раз от корня и от позиции, найденной для предыдущей пробы.
+///
+/// Запуск: finger_bench [число ключей] [шаг проб]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "bench_common.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Возвращает миллисекунды, прошедшие с \c start. */
+static long long msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char *argv[])
+{
+    typedef RBTree<std::uint64_t> Tree;
+
+    std::size_t keysNum = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 2000000));
+    std::size_t step = static_cast<std::size_t>(bench::argOr(argc, argv, 2, 4));
+
+    Tree tree;
+    std::vector<std::uint64_t> keys;
+    bench::Rng rng(1);
+    while (keys.size() < keysNum)
+    {
+        std::uint64_t k = rng.next();
+        if (!tree.find(k))
+        {
+            tree.insert(k);
+            keys.push_back(k);
+        }
+    }
+
+    // пробы — каждый step-й ключ и соседнее отсутствующее значение, по возрастанию
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::uint64_t> probes;
+    for (std::size_t i = 0; i < keys.size(); i += step)
+    {
+        probes.push_back(keys[i]);
+        probes.push_back(keys[i] + 1);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < probes.size(); ++i)
+        if (tree.find(probes[i]))
+            ++found;
+    std::printf("from root:   %6lld ms (%zu of %zu found)\n", msSince(start), found, probes.size());
+
+    start = std::chrono::steady_clock::now();
+    found = 0;
+    Tree::ConstIterator finger = tree.end();
+    for (std::size_t i = 0; i < probes.size(); ++i)
+    {
+        finger = tree.lowerBound(finger, probes[i]);
+        if (finger != tree.end() && *finger == probes[i])
+            ++found;
+    }
+    std::printf("from finger: %6lld ms (%zu of %zu found)\n", msSince(start), found, probes.size());
+
+    return 0;
+}
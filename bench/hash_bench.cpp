@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк сравнения и разницы xi::RBTree с хешами поддеревьев
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Два дерева из одних и тех же случайных ключей, в реплике изменено несколько
+/// ключей. Сравнивается обход обоих деревьев слиянием (как без \c RBTREE_WITH_HASHING)
+/// с \c isEqual() и \c diff(), отсекающими совпадающие поддеревья по хешам.
+///
+/// Запуск: hash_bench [число ключей] [число изменений]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "bench_common.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Возвращает микросекунды, прошедшие с \c start. */
+static long long usSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char *argv[])
+{
+    typedef RBTree<std::uint64_t> Tree;
+
+    std::size_t keysNum = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 2000000));
+    std::size_t changesNum = static_cast<std::size_t>(bench::argOr(argc, argv, 2, 100));
+
+    Tree primary;
+    Tree replica;
+    std::vector<std::uint64_t> keys;
+    bench::Rng rng(1);
+    while (keys.size() < keysNum)
+    {
+        std::uint64_t k = rng.next();
+        if (!primary.find(k))
+        {
+            primary.insert(k);
+            replica.insert(k);
+            keys.push_back(k);
+        }
+    }
+    for (std::size_t i = 0; i < changesNum; ++i)
+    {
+        std::uint64_t k = keys[rng.below(keys.size())];
+        if (replica.find(k))
+            replica.remove(k);
+    }
+
+    // обход слиянием, как делает diff() без хешей
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::size_t walked = 0;
+    Tree::ConstIterator a = primary.begin();
+    Tree::ConstIterator b = replica.begin();
+    while (a != primary.end() && b != replica.end())
+    {
+        if (*a < *b)
+            ++a;
+        else if (*b < *a)
+            ++b;
+        else
+        {
+            ++a;
+            ++b;
+        }
+        ++walked;
+    }
+    std::printf("merge walk:  %10lld us (%zu steps)\n", usSince(start), walked);
+
+    start = std::chrono::steady_clock::now();
+    bool equal = primary.isEqual(replica);
+    std::printf("isEqual:     %10lld us (%s)\n", usSince(start), equal ? "equal" : "differ");
+
+    start = std::chrono::steady_clock::now();
+    RBTreeDelta<std::uint64_t> delta;
+    primary.diff(replica, delta);
+    std::printf("pruned diff: %10lld us (%zu removes, %zu inserts)\n", usSince(start),
+                delta.removes.size(), delta.inserts.size());
+
+    return 0;
+}
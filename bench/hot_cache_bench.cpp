@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк поиска в xi::RBTree со скошенным распределением и кэшем частых ключей
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// 90% поисков приходятся на несколько тысяч горячих ключей, остальные — на все
+/// дерево. Один и тот же поток поисков выполняется без кэша и с кэшем частых ключей.
+///
+/// Запуск: hot_cache_bench [число ключей] [число горячих ключей] [ячеек кэша]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "bench_common.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Возвращает миллисекунды, прошедшие с \c start. */
+static long long msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+/** \brief Ищет все \c queries и возвращает число найденных. */
+static std::size_t runQueries(const RBTree<std::uint64_t> &tree, const std::vector<std::uint64_t> &queries)
+{
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < queries.size(); ++i)
+        if (tree.find(queries[i]))
+            ++found;
+    return found;
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::size_t keysNum = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 2000000));
+    std::size_t hotNum = static_cast<std::size_t>(bench::argOr(argc, argv, 2, 4000));
+    std::size_t slotsNum = static_cast<std::size_t>(bench::argOr(argc, argv, 3, 16384));
+    const std::size_t QUERIES = 10000000;
+
+    RBTree<std::uint64_t> tree;
+    std::vector<std::uint64_t> keys;
+    bench::Rng rng(1);
+    while (keys.size() < keysNum)
+    {
+        std::uint64_t k = rng.next();
+        if (!tree.find(k))
+        {
+            tree.insert(k);
+            keys.push_back(k);
+        }
+    }
+
+    std::vector<std::uint64_t> queries(QUERIES);
+    for (std::size_t i = 0; i < QUERIES; ++i)
+        queries[i] = (rng.below(10) < 9) ? keys[rng.below(hotNum)] : keys[rng.below(keys.size())];
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::size_t found = runQueries(tree, queries);
+    std::printf("no cache:    %6lld ms (%zu found)\n", msSince(start), found);
+
+    tree.setHotCacheSize(slotsNum);
+    start = std::chrono::steady_clock::now();
+    found = runQueries(tree, queries);
+    std::printf("hot cache:   %6lld ms (%zu found, %zu slots)\n", msSince(start), found, tree.getHotCacheSize());
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк упорядоченных множеств на нагрузке "в основном чтение"
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// 1..32 потока выполняют смесь из поиска (90%), вставки (5%) и удаления (5%)
+/// случайных ключей из диапазона, заполненного наполовину. Сравниваются
+/// \c RBTree под мьютексом, \c RBTree под разделяемой блокировкой
+/// и \c LockFreeSkipList.
+///
+/// Запуск: ordered_set_bench [длительность замера, мс] [диапазон ключей]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+
+#include "bench_common.h"
+#include "lock_free_skiplist.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Дерево под мьютексом. */
+class MutexTree
+{
+public:
+    bool contains(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        return _tree.find(key) != nullptr;
+    }
+
+    bool tryInsert(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (_tree.find(key))
+            return false;
+        _tree.insert(key);
+        return true;
+    }
+
+    bool tryRemove(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (!_tree.find(key))
+            return false;
+        _tree.remove(key);
+        return true;
+    }
+
+protected:
+    std::mutex _lock;
+    RBTree<std::uint64_t> _tree;
+};
+
+
+/** \brief Дерево под разделяемой блокировкой: поиски не мешают друг другу. */
+class RwLockTree
+{
+public:
+    bool contains(std::uint64_t key)
+    {
+        std::shared_lock<std::shared_mutex> l(_lock);
+        return _tree.find(key) != nullptr;
+    }
+
+    bool tryInsert(std::uint64_t key)
+    {
+        std::unique_lock<std::shared_mutex> l(_lock);
+        if (_tree.find(key))
+            return false;
+        _tree.insert(key);
+        return true;
+    }
+
+    bool tryRemove(std::uint64_t key)
+    {
+        std::unique_lock<std::shared_mutex> l(_lock);
+        if (!_tree.find(key))
+            return false;
+        _tree.remove(key);
+        return true;
+    }
+
+protected:
+    std::shared_mutex _lock;
+    RBTree<std::uint64_t> _tree;
+};
+
+
+/** \brief Заполняет множество половиной ключей, замеряет смесь операций и печатает строку. */
+template<typename Set>
+void runCase(const char *name, std::size_t threadsNum, unsigned durationMs, std::uint64_t range)
+{
+    Set set;
+    bench::Rng fill(12345);
+    for (std::uint64_t i = 0; i < range / 2; ++i)
+        set.tryInsert(fill.below(range));
+
+    std::vector<std::uint64_t> ops = bench::runThreads(threadsNum, durationMs,
+            [&](std::size_t idx, const std::atomic<bool> &stop) -> std::uint64_t {
+                bench::Rng rng(idx + 1);
+                std::uint64_t done = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    std::uint64_t r = rng.next();
+                    std::uint64_t key = (r >> 8) % range;
+                    unsigned kind = static_cast<unsigned>(r % 100);
+                    if (kind < 90)
+                        set.contains(key);
+                    else if (kind < 95)
+                        set.tryInsert(key);
+                    else
+                        set.tryRemove(key);
+                    ++done;
+                }
+                return done;
+            });
+
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < ops.size(); ++i)
+        total += ops[i];
+
+    std::printf("%-12s %8zu %14.3f\n", name, threadsNum, bench::mops(total, durationMs));
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned durationMs = static_cast<unsigned>(bench::argOr(argc, argv, 1, 500));
+    std::uint64_t range = bench::argOr(argc, argv, 2, 1 << 20);
+
+    std::printf("duration: %u ms, keys: %llu, hardware threads: %u\n",
+                durationMs, static_cast<unsigned long long>(range), std::thread::hardware_concurrency());
+    std::printf("%-12s %8s %14s\n", "set", "threads", "Mops/s");
+
+    for (std::size_t threadsNum = 1; threadsNum <= 32; threadsNum *= 2)
+    {
+        runCase<MutexTree>("mutex", threadsNum, durationMs, range);
+        runCase<RwLockTree>("rwlock", threadsNum, durationMs, range);
+        runCase<LockFreeSkipList<std::uint64_t> >("skiplist", threadsNum, durationMs, range);
+    }
+
+    return 0;
+}
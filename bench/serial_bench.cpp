@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк восстановления xi::RBTree из сериализованного потока
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Дерево из случайных ключей сериализуется в память, после чего восстанавливается
+/// двумя способами: поэлементными \c insert() и \c deserialize(). Для сравнения
+/// то же дерево записывается в файл \c MappedRBSet и открывается отображением.
+///
+/// Запуск: serial_bench [число ключей] [файл для MappedRBSet]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <sstream>
+#include <vector>
+
+#include "bench_common.h"
+#include "mapped_rbset.h"
+
+
+using namespace xi;
+
+
+/** \brief Возвращает миллисекунды, прошедшие с \c start. */
+static long long msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::size_t keysNum = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 5000000));
+
+    RBTree<std::uint64_t> source;
+    std::vector<std::uint64_t> keys;
+    bench::Rng rng(1);
+    while (keys.size() < keysNum)
+    {
+        std::uint64_t k = rng.next();
+        if (!source.find(k))
+        {
+            source.insert(k);
+            keys.push_back(k);
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::ostringstream os;
+    source.serialize(os);
+    std::string data = os.str();
+    std::printf("serialize:   %8lld ms, %zu bytes\n", msSince(start), data.size());
+
+    start = std::chrono::steady_clock::now();
+    {
+        RBTree<std::uint64_t> tree;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+            tree.insert(keys[i]);
+        std::printf("insert:      %8lld ms\n", msSince(start));
+    }
+
+    start = std::chrono::steady_clock::now();
+    {
+        std::istringstream is(data);
+        RBTree<std::uint64_t> tree;
+        tree.deserialize(is);
+        std::printf("deserialize: %8lld ms\n", msSince(start));
+    }
+
+    std::string path = (argc > 2) ? argv[2] : "serial_bench.rbm";
+    writeMapped(source, path);
+
+    start = std::chrono::steady_clock::now();
+    {
+        MappedRBSet<std::uint64_t> set(path);
+        bool found = set.contains(keys[0]);
+        std::printf("mapped open: %8lld ms (first lookup %s)\n", msSince(start), found ? "hit" : "miss");
+    }
+    std::remove(path.c_str());
+
+    return 0;
+}
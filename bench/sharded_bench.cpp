@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк масштабирования вставок в xi::ShardedRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// 1..64 писателей вставляют равномерно распределенные случайные ключи.
+/// Сравниваются дерево под одним глобальным мьютексом и шардированное дерево,
+/// которое начинает с одного шарда и делит его по мере роста и нагрузки.
+///
+/// Запуск: sharded_bench [длительность замера, мс]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+#include "bench_common.h"
+#include "sharded_rbtree.h"
+
+
+using namespace xi;
+
+
+/** \brief Исходный вариант: дерево под глобальным мьютексом. */
+class MutexTree
+{
+public:
+    void insert(std::uint64_t key)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _tree.insert(key);
+    }
+
+protected:
+    std::mutex _lock;
+    RBTree<std::uint64_t> _tree;
+};
+
+
+/** \brief Замеряет вставки \c writers потоками и печатает строку. */
+template<typename Tree>
+void runCase(const char *name, Tree &tree, std::size_t writers, unsigned durationMs)
+{
+    std::vector<std::uint64_t> ops = bench::runThreads(writers, durationMs,
+            [&](std::size_t idx, const std::atomic<bool> &stop) -> std::uint64_t {
+                bench::Rng rng(idx + 1);
+                std::uint64_t done = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    // младшие биты — номер потока, чтобы ключи потоков не совпадали
+                    std::uint64_t key = (rng.next() << 6) | idx;
+                    try
+                    {
+                        tree.insert(key);
+                    }
+                    catch (const std::invalid_argument &)
+                    {
+                        // повтор случайного ключа — пропускаем
+                    }
+                    ++done;
+                }
+                return done;
+            });
+
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < ops.size(); ++i)
+        total += ops[i];
+
+    std::printf("%-12s %8zu %14.3f\n", name, writers, bench::mops(total, durationMs));
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned durationMs = static_cast<unsigned>(bench::argOr(argc, argv, 1, 500));
+
+    std::printf("duration: %u ms, hardware threads: %u\n", durationMs, std::thread::hardware_concurrency());
+    std::printf("%-12s %8s %14s\n", "tree", "writers", "insert Mops/s");
+
+    for (std::size_t writers = 1; writers <= 64; writers *= 2)
+    {
+        {
+            MutexTree tree;
+            runCase("mutex", tree, writers, durationMs);
+        }
+        {
+            ShardedRBTree<std::uint64_t> tree;
+            runCase("sharded", tree, writers, durationMs);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк вставки в xi::RBTree: два прохода против одного спуска
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Одни и те же случайные и возрастающие ключи вставляются в два пустых дерева: в режиме
+/// \c INSERT_BOTTOM_UP (спуск, затем подъем по \c _parent) и \c INSERT_TOP_DOWN
+/// (балансировка по ходу спуска); печатаются время каждого и высота получившихся деревьев.
+///
+/// Деревья заполняются одновременно, чередующимися порциями ключей: так узлы обоих
+/// берутся у распределителя памяти в одном и том же его состоянии. При заполнении
+/// по очереди второе дерево получает память, раздробленную первым, и это искажает
+/// сравнение сильнее, чем сама разница способов балансировки.
+///
+/// Запуск: top_down_bench [число ключей] [повторы]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "bench_common.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+typedef RBTree<std::uint64_t> Tree;
+
+
+/** \brief Возвращает высоту поддерева \c nd. */
+static int heightOf(const Tree::Node *nd)
+{
+    if (!nd)
+        return 0;
+    return 1 + std::max(heightOf(nd->getLeft()), heightOf(nd->getRight()));
+}
+
+
+/** \brief Вставляет порцию \c keys[\c from, \c to) в \c tree, возвращает время в микросекундах. */
+static long long insertPortion(Tree &tree, const std::vector<std::uint64_t> &keys, std::size_t from, std::size_t to)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t i = from; i < to; ++i)
+        tree.insert(keys[i]);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+/** \brief Заполняет \c keys пустые деревья обоих режимов и печатает лучшее из \c reps время каждого. */
+static void run(const std::vector<std::uint64_t> &keys, int reps)
+{
+    const std::size_t portion = 1024;
+
+    long long best[2] = { -1, -1 };
+    int height[2] = { 0, 0 };
+    for (int r = 0; r < reps; ++r)
+    {
+        Tree trees[2];
+        trees[0].setInsertMode(Tree::INSERT_BOTTOM_UP);
+        trees[1].setInsertMode(Tree::INSERT_TOP_DOWN);
+
+        long long us[2] = { 0, 0 };
+        for (std::size_t from = 0; from < keys.size(); from += portion)
+        {
+            std::size_t to = std::min(from + portion, keys.size());
+            // первой в порции идет то одна, то другая вставка
+            int first = static_cast<int>((from / portion + r) % 2);
+            us[first] += insertPortion(trees[first], keys, from, to);
+            us[1 - first] += insertPortion(trees[1 - first], keys, from, to);
+        }
+
+        for (int m = 0; m < 2; ++m)
+        {
+            if (best[m] < 0 || us[m] < best[m])
+                best[m] = us[m];
+            height[m] = heightOf(trees[m].getRoot());
+        }
+    }
+
+    std::printf("  bottom-up  %6lld ms, height %d\n", best[0] / 1000, height[0]);
+    std::printf("  top-down   %6lld ms, height %d\n", best[1] / 1000, height[1]);
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::size_t keysNum = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 1000000));
+    int reps = static_cast<int>(bench::argOr(argc, argv, 2, 3));
+
+    std::vector<std::uint64_t> keys;
+    bench::Rng rng(1);
+    for (std::size_t i = 0; i < keysNum; ++i)
+        keys.push_back(rng.next());
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::printf("ascending, %zu keys\n", keys.size());
+    run(keys, reps);
+
+    bench::Rng shuffleRng(2);
+    for (std::size_t i = keys.size(); i > 1; --i)
+        std::swap(keys[i - 1], keys[shuffleRng.below(i)]);
+
+    std::printf("random, %zu keys\n", keys.size());
+    run(keys, reps);
+
+    return 0;
+}
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бенчмарк накладных расходов трассировки xi::RBTreeTraceRecorder
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Одни и те же случайные ключи вставляются в дерево без дампера и в дерево с рекордером,
+/// пишущим журнал; разница — цена записи событий в буфер и обмена буферами с фоновым
+/// потоком записи. Замер делается для маски событий по умолчанию (только вставки)
+/// и для всех событий.
+///
+/// Деревья заполняются одновременно, чередующимися порциями ключей, как в top_down_bench:
+/// при заполнении по очереди второе дерево получает память, раздробленную первым.
+/// Печатается лучшее из нескольких повторов время и прирост в процентах.
+///
+/// Запуск: trace_bench [число ключей] [повторы] [буфер, записей] [файл журнала]
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "bench_common.h"
+#include "rbtree_trace.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> Tree;
+typedef RBTreeTraceRecorder<int, std::less<int> > Recorder;
+
+
+/** \brief Вставляет порцию \c keys[\c from, \c to) в \c tree, возвращает время в микросекундах. */
+static long long insertPortion(Tree &tree, const std::vector<int> &keys, std::size_t from, std::size_t to)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (std::size_t i = from; i < to; ++i)
+        tree.insert(keys[i]);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+/** \brief Заполняет \c keys дерево без дампера и дерево с рекордером маски \c mask,
+ *  печатает лучшее из \c reps время каждого.
+ */
+static void run(const char *title, const std::vector<int> &keys, int reps, std::size_t bufRecords,
+                const char *fileName, unsigned mask)
+{
+    const std::size_t portion = 1024;
+
+    long long best[2] = { -1, -1 };
+    std::uint64_t eventsNum = 0;
+    for (int r = 0; r < reps; ++r)
+    {
+        Tree trees[2];
+        Recorder rec(fileName, bufRecords, mask);
+        trees[1].setDumper(&rec);
+
+        long long us[2] = { 0, 0 };
+        for (std::size_t from = 0; from < keys.size(); from += portion)
+        {
+            std::size_t to = std::min(from + portion, keys.size());
+            // первой в порции идет то одна, то другая вставка
+            int first = static_cast<int>((from / portion + r) % 2);
+            us[first] += insertPortion(trees[first], keys, from, to);
+            us[1 - first] += insertPortion(trees[1 - first], keys, from, to);
+        }
+
+        rec.flush();
+        eventsNum = rec.getEventsNum();
+        trees[1].resetDumper();
+
+        for (int m = 0; m < 2; ++m)
+            if (best[m] < 0 || us[m] < best[m])
+                best[m] = us[m];
+    }
+    std::remove(fileName);
+
+    std::printf("%s, %llu events\n", title, static_cast<unsigned long long>(eventsNum));
+    std::printf("  no dumper  %6lld ms\n", best[0] / 1000);
+    std::printf("  recorder   %6lld ms, %+.1f ns per insert, %+.1f%%\n", best[1] / 1000,
+                (best[1] - best[0]) * 1e3 / static_cast<double>(keys.size()),
+                (best[1] - best[0]) * 100.0 / static_cast<double>(best[0]));
+}
+
+
+int main(int argc, char *argv[])
+{
+    std::size_t keysNum = static_cast<std::size_t>(bench::argOr(argc, argv, 1, 2000000));
+    int reps = static_cast<int>(bench::argOr(argc, argv, 2, 5));
+    std::size_t bufRecords = static_cast<std::size_t>(bench::argOr(argc, argv, 3, Recorder::DEF_BUFFER_RECORDS));
+    const char *fileName = (argc > 4) ? argv[4] : "trace_bench.bin";
+
+    // уникальные ключи в случайном порядке
+    std::vector<int> keys(keysNum);
+    for (std::size_t i = 0; i < keysNum; ++i)
+        keys[i] = static_cast<int>(i);
+    bench::Rng rng(1);
+    for (std::size_t i = keysNum; i > 1; --i)
+        std::swap(keys[i - 1], keys[rng.below(i)]);
+
+    run("default mask", keys, reps, bufRecords, fileName, Recorder::DEF_EVENT_MASK);
+    run("all events", keys, reps, bufRecords, fileName, Recorder::ALL_EVENTS);
+
+    return 0;
+}
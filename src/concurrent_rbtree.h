@@ -0,0 +1,165 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Потокобезопасная обертка над красно-черным деревом
+///            с разделяемой блокировкой для чтения и пакетной записью
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Читатели (поиск, обход, диапазонные запросы) берут блокировку \c std::shared_mutex
+/// в разделяемом режиме и не мешают друг другу. Вставки и удаления не применяются
+/// сразу, а ставятся в очередь; когда в ней набирается пакет, он применяется к дереву
+/// целиком под одним захватом монопольной блокировки, так что один захват
+/// окупает много перебалансировок. Недобранный пакет применяется, когда его
+/// старейшая операция ждет дольше заданной задержки.
+///
+/// "Реализация" соответствующих методов располагается в файле concurrent_rbtree.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_CONCURRENT_RBTREE_H_
+#define RBTREE_CONCURRENT_RBTREE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+
+/** \brief Красно-черное дерево, разделяемое многими потоками.
+ *
+ *  Изменения становятся видимы читателям, когда применяется их пакет: при заполнении
+ *  очереди до \c getBatchSize() операций, при явном вызове \c flush() или когда старейшая
+ *  операция очереди ждет не меньше \c getMaxDelay(). Возраст очереди проверяют и запись,
+ *  и чтение, поэтому чтение видит все операции, поставленные в очередь раньше, чем за
+ *  \c getMaxDelay() до его начала, даже если записи прекратились. Операции
+ *  одного пакета применяются в порядке ключей (для одного ключа — в порядке поступления),
+ *  поэтому соседние спуски идут по уже прогретым в кэше путям.
+ *
+ *  Ошибки отложенных операций вызывающему сообщить уже нельзя, поэтому вставка
+ *  существующего ключа и удаление отсутствующего молча пропускаются.
+ *
+ *  Обходы вызывают переданную функцию под разделяемой блокировкой дерева, поэтому
+ *  функция не должна писать в это же дерево (\c insert(), \c remove(), \c flush()):
+ *  запись, применяющая пакет, ждала бы монопольной блокировки в том же потоке вечно.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class ConcurrentRBTree
+{
+public:
+    typedef RBTree<Element, Compar> TTree;
+
+    typedef std::chrono::steady_clock Clock;
+
+    /** \brief Размер пакета по умолчанию. */
+    static const std::size_t DEF_BATCH_SIZE = 64;
+
+    /** \brief Наибольшая задержка применения операции по умолчанию, мкс. */
+    static constexpr long long DEF_MAX_DELAY_US = 1000;
+
+public:
+    /** \brief Создает пустое дерево, применяющее записи пакетами по \c batchSize операций
+     *  и не позже, чем через \c maxDelay после постановки в очередь (см. описание класса).
+     */
+    explicit ConcurrentRBTree(std::size_t batchSize = DEF_BATCH_SIZE,
+                              Clock::duration maxDelay = std::chrono::microseconds(DEF_MAX_DELAY_US));
+
+public:
+    // Запись
+
+    /** \brief Ставит в очередь вставку \c key. */
+    void insert(const Element &key);
+
+#ifdef RBTREE_WITH_DELETION
+
+    /** \brief Ставит в очередь удаление \c key. */
+    void remove(const Element &key);
+
+#endif // RBTREE_WITH_DELETION
+
+    /** \brief Применяет к дереву все операции, поставленные в очередь до вызова. */
+    void flush();
+
+public:
+    // Чтение
+
+    /** \brief Возвращает истину, если \c key есть в дереве (без учета еще не примененных операций). */
+    bool contains(const Element &key) const;
+
+    /** \brief Вызывает \c fn для каждого элемента в порядке возрастания.
+     *
+     *  \c fn выполняется под разделяемой блокировкой и не должна писать в это дерево.
+     */
+    template<typename F>
+    void forEach(F fn) const;
+
+    /** \brief Вызывает \c fn для каждого элемента из полуинтервала [\c lo, \c hi) в порядке возрастания.
+     *
+     *  Ограничение на \c fn — как у \c forEach().
+     */
+    template<typename F>
+    void forEachInRange(const Element &lo, const Element &hi, F fn) const;
+
+    /** \brief Возвращает размер пакета. */
+    std::size_t getBatchSize() const { return _batchSize; }
+
+    /** \brief Возвращает наибольшую задержку применения операции. */
+    Clock::duration getMaxDelay() const { return _maxDelay; }
+
+protected:
+    ConcurrentRBTree(const ConcurrentRBTree &);                 ///< КК не доступен.
+    ConcurrentRBTree &operator=(const ConcurrentRBTree &);      ///< Присваивание недоступно.
+
+protected:
+    /** \brief Отложенная операция записи. */
+    struct PendingOp
+    {
+        Element key;                            ///< Ключ.
+        bool isInsert;                          ///< Вставка, иначе удаление.
+    };
+
+    /** \brief Ставит операцию в очередь и, если пакет набран, применяет его. */
+    void enqueue(const Element &key, bool isInsert);
+
+    /** \brief Применяет пакет \c batch к дереву под монопольной блокировкой. */
+    void applyBatch(std::vector<PendingOp> &batch);
+
+    /** \brief Перед чтением применяет очередь, если ее старейшая операция ждет не меньше \c _maxDelay. */
+    void flushStale() const;
+
+    /** \brief Возвращает текущее время в тиках \c Clock; никогда не 0. */
+    static Clock::rep nowTicks();
+
+protected:
+    TTree _tree;                                ///< Само дерево.
+    mutable std::shared_mutex _treeLock;        ///< Блокировка дерева: читатели — разделяемо, пакет — монопольно.
+
+    std::mutex _queueLock;                      ///< Блокировка очереди (держится только на время push/swap).
+    std::vector<PendingOp> _queue;              ///< Очередь отложенных операций.
+    std::atomic<Clock::rep> _queuedSince;       ///< Время постановки старейшей операции очереди; 0 — очередь пуста.
+
+    /** \brief Упорядочивает применение пакетов: пакет, раньше забранный из очереди,
+     *  раньше и применяется.
+     */
+    std::mutex _flushLock;
+
+    std::size_t _batchSize;                     ///< Размер пакета.
+    Clock::duration _maxDelay;                  ///< Наибольшая задержка применения операции.
+    Compar _compar;                             ///< Компаратор для сортировки пакета.
+}; // class ConcurrentRBTree
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "concurrent_rbtree.hpp"
+
+#endif // RBTREE_CONCURRENT_RBTREE_H_
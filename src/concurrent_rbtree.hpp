@@ -0,0 +1,159 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация потокобезопасной обертки над красно-черным деревом
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле concurrent_rbtree.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>        // std::stable_sort
+
+
+namespace xi
+{
+
+
+template<typename Element, typename Compar>
+ConcurrentRBTree<Element, Compar>::ConcurrentRBTree(std::size_t batchSize, Clock::duration maxDelay)
+        : _queuedSince(0)
+        , _batchSize(batchSize ? batchSize : 1)
+        , _maxDelay(maxDelay)
+{
+    _queue.reserve(_batchSize);
+}
+
+
+template<typename Element, typename Compar>
+void ConcurrentRBTree<Element, Compar>::insert(const Element &key)
+{
+    enqueue(key, true);
+}
+
+
+#ifdef RBTREE_WITH_DELETION
+
+template<typename Element, typename Compar>
+void ConcurrentRBTree<Element, Compar>::remove(const Element &key)
+{
+    enqueue(key, false);
+}
+
+#endif // RBTREE_WITH_DELETION
+
+
+template<typename Element, typename Compar>
+void ConcurrentRBTree<Element, Compar>::enqueue(const Element &key, bool isInsert)
+{
+    PendingOp op = { key, isInsert };
+    Clock::rep now = nowTicks();
+
+    {
+        std::lock_guard<std::mutex> ql(_queueLock);
+        if (_queue.empty())
+            _queuedSince.store(now);
+        _queue.push_back(op);
+
+        // недобранный пакет ждет, пока его старейшая операция не слишком стара
+        if (_queue.size() < _batchSize && now - _queuedSince.load() < _maxDelay.count())
+            return;
+    }
+
+    flush();
+}
+
+
+template<typename Element, typename Compar>
+void ConcurrentRBTree<Element, Compar>::flushStale() const
+{
+    // пустая очередь стоит читателю одного чтения атомарной переменной, без записи
+    Clock::rep since = _queuedSince.load();
+    if (since != 0 && nowTicks() - since >= _maxDelay.count())
+        const_cast<ConcurrentRBTree *>(this)->flush();
+}
+
+
+template<typename Element, typename Compar>
+typename ConcurrentRBTree<Element, Compar>::Clock::rep ConcurrentRBTree<Element, Compar>::nowTicks()
+{
+    Clock::rep now = Clock::now().time_since_epoch().count();
+    return now != 0 ? now : 1;
+}
+
+
+template<typename Element, typename Compar>
+void ConcurrentRBTree<Element, Compar>::flush()
+{
+    std::lock_guard<std::mutex> fl(_flushLock);
+
+    // забираем очередь целиком; писатели тем временем копят следующий пакет
+    std::vector<PendingOp> batch;
+    batch.reserve(_batchSize);
+    {
+        std::lock_guard<std::mutex> ql(_queueLock);
+        batch.swap(_queue);
+        _queuedSince.store(0);
+    }
+
+    if (!batch.empty())
+        applyBatch(batch);
+}
+
+
+template<typename Element, typename Compar>
+void ConcurrentRBTree<Element, Compar>::applyBatch(std::vector<PendingOp> &batch)
+{
+    // сортировка устойчивая: операции над одним ключом сохраняют порядок поступления
+    const Compar &compar = _compar;
+    std::stable_sort(batch.begin(), batch.end(),
+                     [&compar](const PendingOp &a, const PendingOp &b) { return compar(a.key, b.key); });
+
+    std::unique_lock<std::shared_mutex> wl(_treeLock);
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        const PendingOp &op = batch[i];
+        bool present = _tree.find(op.key) != nullptr;
+
+        if (op.isInsert && !present)
+            _tree.insert(op.key);
+#ifdef RBTREE_WITH_DELETION
+        else if (!op.isInsert && present)
+            _tree.remove(op.key);
+#endif // RBTREE_WITH_DELETION
+    }
+}
+
+
+template<typename Element, typename Compar>
+bool ConcurrentRBTree<Element, Compar>::contains(const Element &key) const
+{
+    flushStale();
+    std::shared_lock<std::shared_mutex> rl(_treeLock);
+    return _tree.find(key) != nullptr;
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void ConcurrentRBTree<Element, Compar>::forEach(F fn) const
+{
+    flushStale();
+    std::shared_lock<std::shared_mutex> rl(_treeLock);
+    for (typename TTree::ConstIterator it = _tree.begin(); it != _tree.end(); ++it)
+        fn(*it);
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void ConcurrentRBTree<Element, Compar>::forEachInRange(const Element &lo, const Element &hi, F fn) const
+{
+    flushStale();
+    std::shared_lock<std::shared_mutex> rl(_treeLock);
+    for (typename TTree::ConstIterator it = _tree.lowerBound(lo); it != _tree.end() && _compar(*it, hi); ++it)
+        fn(*it);
+}
+
+
+} // namespace xi
@@ -0,0 +1,258 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Красно-черное дерево, переживающее падение процесса: журнал
+///            упреждающей записи и контрольные точки
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Каждое изменение дописывается записью в журнал (WAL) в каталоге дерева и считается
+/// выполненным, когда запись сброшена на диск. Сброс групповой: пока один поток пишет
+/// и вызывает fsync, записи остальных копятся в буфере и уходят на диск следующим
+/// сбросом целиком, так что под нагрузкой одна последовательная запись и один fsync
+/// приходятся на пачку операций, а не на каждую.
+///
+/// Журнал делится на сегменты. Фоновый поток, когда журнал с прошлой контрольной точки
+/// вырастает больше заданного, записывает контрольную точку — полный снимок дерева
+/// в формате \c RBTree::serialize() — и удаляет сегменты, целиком покрытые ею.
+/// Снимок берется из \c PersistentRBTree за O(1) и пишется, не останавливая писателей.
+///
+/// При открытии дерево загружается из контрольной точки и доигрывается хвостом журнала.
+/// Недописанная при падении последняя запись распознается по контрольной сумме
+/// и отбрасывается.
+///
+/// Файлы каталога:
+///   - \c checkpoint — сигнатура "RBCP", версия, номер последней покрытой записи (LSN),
+///     первый нужный сегмент журнала, затем поток \c RBTree::serialize();
+///   - \c wal-NNNNNNNNNN.log — сегменты журнала; запись: LSN (8 байт), операция (1 байт),
+///     элемент, сумма FNV-1a предыдущих полей (8 байт). Целые — little-endian.
+///
+/// "Реализация" соответствующих методов располагается в файле durable_rbtree.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_DURABLE_RBTREE_H_
+#define RBTREE_DURABLE_RBTREE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>        // std::exception_ptr
+#include <functional>       // std::less
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "persistent_rbtree.h"
+#include "rbtree_serial.h"
+
+
+namespace xi
+{
+
+
+/** \brief Файлы журнала: дозапись и сброс на диск. */
+namespace durable
+{
+
+/** \brief Файл, открытый на дозапись. */
+class AppendFile
+{
+public:
+    AppendFile() : _fd(-1) {}
+    ~AppendFile() { close(); }
+
+    /** \brief Открывает (создает) файл \c path; \c truncate — обнулить существующий. */
+    void open(const std::string &path, bool truncate);
+
+    /** \brief Дописывает \c n байтов \c data. */
+    void write(const char *data, std::size_t n);
+
+    /** \brief Сбрасывает записанное на диск. */
+    void sync();
+
+    /** \brief Закрывает файл, если он открыт. */
+    void close();
+
+    /** \brief Возвращает истину, если файл открыт. */
+    bool isOpen() const { return _fd >= 0; }
+
+protected:
+    AppendFile(const AppendFile &);                 ///< КК не доступен.
+    AppendFile &operator=(const AppendFile &);      ///< Присваивание недоступно.
+
+protected:
+    int _fd;                                    ///< Дескриптор.
+    std::string _path;                          ///< Путь (для сообщений об ошибках).
+}; // class AppendFile
+
+/** \brief Сбрасывает на диск сам каталог \c dir, чтобы созданные и переименованные
+ *  в нем файлы пережили падение (там, где это требуется и возможно).
+ */
+void syncDir(const std::string &dir);
+
+} // namespace durable
+
+
+/** \brief Красно-черное дерево с журналом упреждающей записи и контрольными точками.
+ *
+ *  \c insert() и \c remove() возвращают управление, когда изменение записано на диск.
+ *  Изменение видно читателям (\c snapshot(), \c contains()) чуть раньше — с момента,
+ *  как оно занесено в журнал, но еще не сброшено.
+ *
+ *  Ошибка ввода-вывода генерирует \c std::runtime_error; после нее дерево в памяти может
+ *  опережать диск, поэтому все дальнейшие операции генерируют ту же ошибку, а состояние
+ *  восстанавливается повторным открытием каталога.
+ *
+ *  \tparam Traits Кодирование элементов (см. \c RBTreeSerialTraits).
+ */
+template<typename Element, typename Compar = std::less<Element>,
+         typename Traits = RBTreeSerialTraits<Element> >
+class DurableRBTree
+{
+public:
+    typedef PersistentRBTree<Element, Compar> TTree;
+    typedef typename TTree::Snapshot Snapshot;
+
+    /** \brief Порог размера журнала с прошлой контрольной точки по умолчанию. */
+    static const std::size_t DEF_CHECKPOINT_BYTES = std::size_t(256) << 20;
+
+    /** \brief Размер сегмента журнала по умолчанию. */
+    static const std::size_t DEF_SEGMENT_BYTES = std::size_t(64) << 20;
+
+public:
+    /** \brief Открывает (создает) дерево в каталоге \c dir и восстанавливает его состояние.
+     *
+     *  \param checkpointBytes Сколько байтов журнала с прошлой контрольной точки запускают
+     *  фоновую контрольную точку; 0 — только явные вызовы \c checkpoint().
+     *  \param segmentBytes Размер, после которого журнал переходит в новый сегмент.
+     */
+    explicit DurableRBTree(const std::string &dir,
+                           std::size_t checkpointBytes = DEF_CHECKPOINT_BYTES,
+                           std::size_t segmentBytes = DEF_SEGMENT_BYTES);
+
+    /** \brief Деструктор. Останавливает фоновый поток; все выполненные операции уже на диске. */
+    ~DurableRBTree();
+
+public:
+    // Запись
+
+    /** \brief Вставляет \c key. Возвращает ложь (ничего не записывая), если ключ уже есть.
+     *
+     *  Ложь, как и истина, возвращается лишь тогда, когда на диске все записи, на которых
+     *  основан ответ (например, чужая вставка того же ключа, еще ждущая сброса).
+     */
+    bool insert(const Element &key) { return apply(OP_INSERT, key); }
+
+    /** \brief Удаляет \c key. Возвращает ложь (ничего не записывая), если ключа нет;
+     *  ответ, как у \c insert(), дожидается диска.
+     */
+    bool remove(const Element &key) { return apply(OP_REMOVE, key); }
+
+    /** \brief Записывает контрольную точку текущего состояния и удаляет покрытые ею сегменты. */
+    void checkpoint();
+
+public:
+    // Чтение
+
+    /** \brief Берет согласованный снимок дерева. */
+    Snapshot snapshot() const { return _tree.snapshot(); }
+
+    /** \brief Возвращает истину, если \c key есть в дереве. */
+    bool contains(const Element &key) const { return _tree.contains(key); }
+
+    /** \brief Возвращает число сбросов журнала на диск (для наблюдения за группировкой). */
+    std::uint64_t getSyncsNum() const;
+
+    /** \brief Возвращает число записанных контрольных точек. */
+    std::uint64_t getCheckpointsNum() const;
+
+protected:
+    DurableRBTree(const DurableRBTree &);                   ///< КК не доступен.
+    DurableRBTree &operator=(const DurableRBTree &);        ///< Присваивание недоступно.
+
+protected:
+    /** \brief Вид записи журнала. */
+    enum OpKind
+    {
+        OP_INSERT = 1,
+        OP_REMOVE = 2
+    };
+
+    /** \brief Выполняет операцию, заносит ее в журнал и дожидается сброса. */
+    bool apply(OpKind op, const Element &key);
+
+    /** \brief Дописывает запись в буфер журнала. Вызывается под \c _mutex. */
+    void appendRecord(std::uint64_t lsn, OpKind op, const Element &key);
+
+    /** \brief Дожидается, пока запись \c lsn окажется на диске; если сброс никто не делает,
+     *  делает его сам.
+     */
+    void waitDurable(std::uint64_t lsn, std::unique_lock<std::mutex> &lock);
+
+    /** \brief Записывает пачку в сегмент \c segment и сбрасывает ее на диск. Вызывается
+     *  только сбрасывающим потоком, без \c _mutex.
+     */
+    void writeBatch(std::uint64_t segment, const std::string &batch);
+
+    /** \brief Генерирует сохраненную ошибку ввода-вывода, если она была. Под \c _mutex. */
+    void checkError() const;
+
+    /** \brief Загружает контрольную точку и доигрывает журнал. */
+    void recover();
+
+    /** \brief Доигрывает сегмент \c path; недописанный хвост допустим только в последнем
+     *  (\c isLast) и обрезается.
+     */
+    void replaySegment(const std::string &path, bool isLast, std::uint64_t checkpointLsn);
+
+    /** \brief Тело фонового потока контрольных точек. */
+    void checkpointLoop();
+
+    /** \brief Путь к сегменту журнала с номером \c segment. */
+    std::string segmentPath(std::uint64_t segment) const;
+
+    /** \brief Путь к файлу контрольной точки. */
+    std::string checkpointPath() const { return _dir + "/checkpoint"; }
+
+protected:
+    std::string _dir;                           ///< Каталог дерева.
+    std::size_t _checkpointBytes;               ///< Порог фоновой контрольной точки.
+    std::size_t _segmentBytes;                  ///< Порог смены сегмента.
+    TTree _tree;                                ///< Само дерево.
+    Compar _compar;                             ///< Компаратор (для проверки контрольной точки).
+
+    mutable std::mutex _mutex;                  ///< Защищает все поля ниже, кроме помеченных.
+    std::condition_variable _durableCv;         ///< Сброс завершен.
+    std::condition_variable _checkpointCv;      ///< Пора делать контрольную точку / останов.
+
+    std::string _buffer;                        ///< Записи, еще не отданные на сброс.
+    std::string _flushBuffer;                   ///< Пачка текущего сброса (только сбрасывающий поток).
+    durable::AppendFile _file;                  ///< Открытый сегмент (только сбрасывающий поток).
+    std::uint64_t _fileSegment;                 ///< Номер открытого сегмента (только сбрасывающий поток).
+
+    std::uint64_t _lastLsn;                     ///< LSN последней занесенной записи.
+    std::uint64_t _durableLsn;                  ///< LSN последней сброшенной записи.
+    bool _flushing;                             ///< Идет сброс.
+    std::uint64_t _flushSegment;                ///< Сегмент, в который идет текущий сброс.
+    std::uint64_t _currentSegment;              ///< Сегмент для следующих сбросов.
+    std::uint64_t _firstSegment;                ///< Самый старый еще не удаленный сегмент.
+    std::size_t _currentSegmentBytes;           ///< Записано в текущий сегмент.
+    std::size_t _walBytes;                      ///< Записано в журнал с прошлой контрольной точки.
+    std::exception_ptr _ioError;                ///< Ошибка ввода-вывода, после которой все операции отказывают.
+
+    std::uint64_t _syncsNum;                    ///< Число сбросов журнала.
+    std::uint64_t _checkpointsNum;              ///< Число контрольных точек.
+
+    std::mutex _checkpointLock;                 ///< Сериализует контрольные точки.
+    bool _stopping;                             ///< Фоновому потоку пора завершаться.
+    std::thread _checkpointer;                  ///< Фоновый поток контрольных точек.
+}; // class DurableRBTree
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "durable_rbtree.hpp"
+
+#endif // RBTREE_DURABLE_RBTREE_H_
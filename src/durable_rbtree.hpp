@@ -0,0 +1,604 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация красно-черного дерева с журналом упреждающей записи
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле durable_rbtree.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cerrno>
+#include <cstdio>           // std::snprintf
+#include <cstring>          // std::strerror
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>        // std::runtime_error
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace xi
+{
+
+namespace durable
+{
+
+/** \brief Генерирует \c std::runtime_error с описанием \c errno. */
+[[noreturn]] inline void fail(const char *what, const std::string &path)
+{
+    throw std::runtime_error(std::string(what) + " '" + path + "': " + std::strerror(errno));
+}
+
+
+inline void AppendFile::open(const std::string &path, bool truncate)
+{
+    close();
+    _path = path;
+#if defined(_WIN32)
+    _fd = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0),
+                  _S_IREAD | _S_IWRITE);
+#else
+    _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+#endif
+    if (_fd < 0)
+        fail("Cannot open", path);
+}
+
+
+inline void AppendFile::write(const char *data, std::size_t n)
+{
+    while (n > 0)
+    {
+#if defined(_WIN32)
+        int done = ::_write(_fd, data, static_cast<unsigned>(n < (1u << 30) ? n : (1u << 30)));
+#else
+        ssize_t done = ::write(_fd, data, n);
+        if (done < 0 && errno == EINTR)
+            continue;
+#endif
+        if (done < 0)
+            fail("Cannot write", _path);
+        data += done;
+        n -= static_cast<std::size_t>(done);
+    }
+}
+
+
+inline void AppendFile::sync()
+{
+#if defined(_WIN32)
+    if (::_commit(_fd) != 0)
+#elif defined(__APPLE__)
+    // на macOS fsync не сбрасывает кэш самого диска
+    if (::fcntl(_fd, F_FULLFSYNC) != 0 && ::fsync(_fd) != 0)
+#else
+    if (::fdatasync(_fd) != 0)
+#endif
+        fail("Cannot sync", _path);
+}
+
+
+inline void AppendFile::close()
+{
+    if (_fd < 0)
+        return;
+#if defined(_WIN32)
+    ::_close(_fd);
+#else
+    ::close(_fd);
+#endif
+    _fd = -1;
+}
+
+
+inline void syncDir(const std::string &dir)
+{
+#if defined(_WIN32)
+    // каталог в Windows не открыть как файл; метаданные NTFS журналирует сама
+    (void)dir;
+#else
+    int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        fail("Cannot open directory", dir);
+    int rc = ::fsync(fd);
+    int err = errno;
+    ::close(fd);
+    errno = err;
+    if (rc != 0)
+        fail("Cannot sync directory", dir);
+#endif
+}
+
+
+/** \brief Буфер потока вывода поверх \c AppendFile (для записи контрольной точки).
+ *
+ *  Исключение из буфера \c std::ostream перехватывает и превращает в badbit, теряя текст
+ *  ошибки, поэтому буфер запоминает первую ошибку файла, а \c checkError() генерирует
+ *  ее заново после записи.
+ */
+class FileOutBuf : public std::streambuf
+{
+public:
+    explicit FileOutBuf(AppendFile &file) : _file(file), _buf(1 << 16)
+    {
+        setp(_buf.data(), _buf.data() + _buf.size());
+    }
+
+    /** \brief Генерирует заново первую ошибку записи в файл, если она была. */
+    void checkError() const
+    {
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (sync() != 0)
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            sputc(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        if (_error)
+            return -1;
+
+        try
+        {
+            _file.write(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+        }
+        catch (...)
+        {
+            _error = std::current_exception();
+            return -1;
+        }
+        setp(_buf.data(), _buf.data() + _buf.size());
+        return 0;
+    }
+
+protected:
+    AppendFile &_file;                          ///< Файл.
+    std::vector<char> _buf;                     ///< Буфер.
+    std::exception_ptr _error;                  ///< Первая ошибка записи.
+}; // class FileOutBuf
+
+
+/** \brief Буфер потока вывода, дописывающий в строку (для кодирования записей журнала). */
+class StringOutBuf : public std::streambuf
+{
+public:
+    explicit StringOutBuf(std::string &str) : _str(str) {}
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            _str.push_back(traits_type::to_char_type(ch));
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        _str.append(s, static_cast<std::size_t>(n));
+        return n;
+    }
+
+protected:
+    std::string &_str;                          ///< Строка.
+}; // class StringOutBuf
+
+
+/** \brief Сигнатура контрольной точки. */
+static const char CHECKPOINT_SIGNATURE[4] = { 'R', 'B', 'C', 'P' };
+
+/** \brief Версия формата контрольной точки и журнала. */
+static const std::uint32_t FORMAT_VERSION = 1;
+
+} // namespace durable
+
+
+//==============================================================================
+// class DurableRBTree
+//==============================================================================
+
+template<typename Element, typename Compar, typename Traits>
+DurableRBTree<Element, Compar, Traits>::DurableRBTree(const std::string &dir,
+                                                      std::size_t checkpointBytes,
+                                                      std::size_t segmentBytes)
+        : _dir(dir)
+        , _checkpointBytes(checkpointBytes)
+        , _segmentBytes(segmentBytes)
+        , _fileSegment(0)
+        , _lastLsn(0)
+        , _durableLsn(0)
+        , _flushing(false)
+        , _flushSegment(0)
+        , _currentSegment(1)
+        , _firstSegment(1)
+        , _currentSegmentBytes(0)
+        , _walBytes(0)
+        , _syncsNum(0)
+        , _checkpointsNum(0)
+        , _stopping(false)
+{
+    std::filesystem::create_directories(_dir);
+    recover();
+
+    if (_checkpointBytes > 0)
+        _checkpointer = std::thread([this]() { checkpointLoop(); });
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+DurableRBTree<Element, Compar, Traits>::~DurableRBTree()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _checkpointCv.notify_all();
+    if (_checkpointer.joinable())
+        _checkpointer.join();
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+std::string DurableRBTree<Element, Compar, Traits>::segmentPath(std::uint64_t segment) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "/wal-%010llu.log", static_cast<unsigned long long>(segment));
+    return _dir + name;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+std::uint64_t DurableRBTree<Element, Compar, Traits>::getSyncsNum() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _syncsNum;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+std::uint64_t DurableRBTree<Element, Compar, Traits>::getCheckpointsNum() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _checkpointsNum;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::checkError() const
+{
+    if (_ioError)
+        std::rethrow_exception(_ioError);
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+bool DurableRBTree<Element, Compar, Traits>::apply(OpKind op, const Element &key)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    checkError();
+
+    // дерево меняется под тем же мьютексом, что и журнал: порядок записей — порядок изменений
+    bool changed = (op == OP_INSERT) ? _tree.insert(key) : _tree.remove(key);
+    if (!changed)
+    {
+        // ответ опирается на состояние в памяти: оно могло прийти от чужой, еще не сброшенной
+        // записи, и после сбоя ее бы не оказалось
+        waitDurable(_lastLsn, lock);
+        return false;
+    }
+
+    std::uint64_t lsn = ++_lastLsn;
+    appendRecord(lsn, op, key);
+    waitDurable(lsn, lock);
+    return true;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::appendRecord(std::uint64_t lsn, OpKind op, const Element &key)
+{
+    std::size_t start = _buffer.size();
+
+    durable::StringOutBuf buf(_buffer);
+    std::ostream os(&buf);
+    serial::writeUInt(os, lsn, 8);
+    os.put(static_cast<char>(op));
+    Traits::write(os, key);
+
+    std::uint64_t sum = serial::fnv1a(_buffer.data() + start, _buffer.size() - start);
+    serial::writeUInt(os, sum, 8);
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::waitDurable(std::uint64_t lsn, std::unique_lock<std::mutex> &lock)
+{
+    while (_durableLsn < lsn)
+    {
+        checkError();
+
+        // сброс уже идет — наша запись уйдет со следующим, который сделает кто-то из ждущих
+        if (_flushing)
+        {
+            _durableCv.wait(lock);
+            continue;
+        }
+
+        // становимся сбрасывающим: забираем все накопленное
+        _flushing = true;
+        _flushBuffer.swap(_buffer);
+        _buffer.clear();
+        std::uint64_t upto = _lastLsn;
+        std::uint64_t segment = _currentSegment;
+        _flushSegment = segment;
+
+        lock.unlock();
+        std::exception_ptr error;
+        try
+        {
+            writeBatch(segment, _flushBuffer);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        std::size_t written = _flushBuffer.size();
+        _flushBuffer.clear();
+        lock.lock();
+
+        _flushing = false;
+        if (error)
+            _ioError = error;
+        else
+        {
+            _durableLsn = upto;
+            ++_syncsNum;
+            _walBytes += written;
+            if (segment == _currentSegment)
+            {
+                _currentSegmentBytes += written;
+                if (_currentSegmentBytes >= _segmentBytes)
+                {
+                    ++_currentSegment;
+                    _currentSegmentBytes = 0;
+                }
+            }
+            if (_checkpointBytes > 0 && _walBytes >= _checkpointBytes)
+                _checkpointCv.notify_one();
+        }
+        _durableCv.notify_all();
+    }
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::writeBatch(std::uint64_t segment, const std::string &batch)
+{
+    if (_fileSegment != segment)
+    {
+        _file.close();
+        _file.open(segmentPath(segment), false);
+        _fileSegment = segment;
+        durable::syncDir(_dir);
+    }
+
+    _file.write(batch.data(), batch.size());
+    _file.sync();
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::checkpoint()
+{
+    std::lock_guard<std::mutex> checkpointGuard(_checkpointLock);
+
+    // снимок и LSN берутся под тем же мьютексом, под которым меняется дерево, — они согласованы;
+    // все записи после снимка пойдут в новый сегмент (если в текущий уже что-то писалось:
+    // иначе номера сегментов пошли бы с пропусками, а восстановление читает их подряд)
+    Snapshot snap;
+    std::uint64_t lsn;
+    std::uint64_t segment;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        checkError();
+        snap = _tree.snapshot();
+        lsn = _lastLsn;
+        if (_currentSegmentBytes > 0 || (_flushing && _flushSegment == _currentSegment))
+        {
+            ++_currentSegment;
+            _currentSegmentBytes = 0;
+        }
+        segment = _currentSegment;
+        _walBytes = 0;
+    }
+
+    // пишем во временный файл и переименовываем: контрольная точка на диске всегда целая
+    std::string tmpPath = checkpointPath() + ".tmp";
+    {
+        durable::AppendFile file;
+        file.open(tmpPath, true);
+        durable::FileOutBuf buf(file);
+        std::ostream os(&buf);
+
+        // при ошибке файла writeStream() сообщит лишь об испорченном потоке — важнее причина
+        try
+        {
+            os.write(durable::CHECKPOINT_SIGNATURE, sizeof(durable::CHECKPOINT_SIGNATURE));
+            serial::writeUInt(os, durable::FORMAT_VERSION, 4);
+            serial::writeUInt(os, lsn, 8);
+            serial::writeUInt(os, segment, 8);
+            serial::writeStream<Traits>(os, snap.getSize(), [&snap](auto &write) { snap.forEach(write); });
+            os.flush();
+        }
+        catch (...)
+        {
+            buf.checkError();
+            throw;
+        }
+        buf.checkError();
+        if (!os)
+            throw std::runtime_error("Failed to write checkpoint '" + tmpPath + "'");
+        file.sync();
+    }
+    std::filesystem::rename(tmpPath, checkpointPath());
+    durable::syncDir(_dir);
+
+    // старые сегменты больше не нужны; дожидаемся только сброса, который еще мог писать в них
+    std::uint64_t first;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_flushing && _flushSegment < segment)
+            _durableCv.wait(lock);
+        first = _firstSegment;
+        _firstSegment = segment;
+        ++_checkpointsNum;
+    }
+    for (std::uint64_t s = first; s < segment; ++s)
+    {
+        std::error_code ec;
+        std::filesystem::remove(segmentPath(s), ec);
+    }
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::checkpointLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _checkpointCv.wait(lock, [this]() { return _stopping || _walBytes >= _checkpointBytes; });
+        if (_stopping)
+            return;
+
+        lock.unlock();
+        try
+        {
+            checkpoint();
+        }
+        catch (...)
+        {
+            // не вышло записать на диск — дальше писать журнал тоже небезопасно
+            std::lock_guard<std::mutex> errorLock(_mutex);
+            if (!_ioError)
+                _ioError = std::current_exception();
+            _walBytes = 0;
+        }
+        lock.lock();
+
+        if (_ioError)
+            return;
+    }
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::recover()
+{
+    std::uint64_t checkpointLsn = 0;
+    std::uint64_t segment = 1;
+
+    std::error_code ec;
+    std::filesystem::remove(checkpointPath() + ".tmp", ec);
+
+    std::ifstream cp(checkpointPath(), std::ios::binary);
+    if (cp)
+    {
+        char sig[sizeof(durable::CHECKPOINT_SIGNATURE)];
+        cp.read(sig, sizeof(sig));
+        if (!cp || std::char_traits<char>::compare(sig, durable::CHECKPOINT_SIGNATURE, sizeof(sig)) != 0 ||
+            serial::readUInt(cp, 4) != durable::FORMAT_VERSION)
+            throw std::runtime_error("Bad checkpoint '" + checkpointPath() + "'");
+        checkpointLsn = serial::readUInt(cp, 8);
+        segment = serial::readUInt(cp, 8);
+        if (!cp)
+            throw std::runtime_error("Bad checkpoint '" + checkpointPath() + "'");
+
+        std::vector<Element> keys;
+        serial::readStream<Traits>(cp, _compar, keys);
+        _tree.assignSorted(keys.begin(), keys.size());
+    }
+    _lastLsn = checkpointLsn;
+
+    // сегменты перед первым нужным могли остаться, если падение случилось во время их удаления
+    for (std::uint64_t s = segment - 1; s > 0 && std::filesystem::exists(segmentPath(s)); --s)
+        std::filesystem::remove(segmentPath(s), ec);
+
+    _firstSegment = segment;
+    for (; std::filesystem::exists(segmentPath(segment)); ++segment)
+        replaySegment(segmentPath(segment), !std::filesystem::exists(segmentPath(segment + 1)), checkpointLsn);
+
+    // в уже существующие сегменты не дописываем: новые записи — в новый
+    _currentSegment = segment;
+    _durableLsn = _lastLsn;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void DurableRBTree<Element, Compar, Traits>::replaySegment(const std::string &path, bool isLast,
+                                                            std::uint64_t checkpointLsn)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("Cannot open WAL segment '" + path + "'");
+
+    std::streamoff good = 0;
+    bool torn = false;
+    while (in.peek() != std::char_traits<char>::eof())
+    {
+        // сумма считается по всем полям записи, прошедшим через обертку
+        FnvStreamBuf fnv(in.rdbuf());
+        std::istream rec(&fnv);
+        std::uint64_t lsn = serial::readUInt(rec, 8);
+        int op = rec.get();
+        Element key = Traits::read(rec);
+        std::uint64_t hash = fnv.getHash();
+        std::uint64_t sum = serial::readUInt(in, 8);
+
+        if (!rec || !in || sum != hash || (op != OP_INSERT && op != OP_REMOVE) ||
+            (lsn > checkpointLsn && lsn <= _lastLsn))
+        {
+            torn = true;
+            break;
+        }
+
+        if (lsn > checkpointLsn)
+        {
+            if (op == OP_INSERT)
+                _tree.insert(key);
+            else
+                _tree.remove(key);
+            _lastLsn = lsn;
+        }
+        good = in.tellg();
+    }
+
+    if (!torn)
+        return;
+
+    // недописанной может быть только последняя запись последнего сегмента
+    if (!isLast)
+        throw std::runtime_error("WAL segment '" + path + "' is corrupted");
+
+    in.close();
+    std::filesystem::resize_file(path, static_cast<std::uintmax_t>(good));
+}
+
+
+} // namespace xi
@@ -0,0 +1,142 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Эпохальное (epoch-based) отложенное освобождение памяти
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Писатель, вынувший узел из структуры, не освобождает его сразу, а передает
+/// \c retire(): узел уходит в корзину текущей глобальной эпохи. Читатель на время
+/// обхода объявляет эпоху, которую видел при входе, в своем слоте. Глобальная эпоха
+/// продвигается, только когда все активные читатели объявили текущую, поэтому к моменту,
+/// когда она ушла на две эпохи вперед от эпохи вынимания, ни один читатель, способный
+/// видеть вынутый узел, уже не активен, и корзина освобождается.
+///
+/// Со стороны читателя это одна запись в собственный слот при входе и одна при выходе;
+/// разделяемых счетчиков и блокировок нет.
+///
+/// "Реализация" соответствующих методов располагается в файле epoch.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_EPOCH_H_
+#define RBTREE_EPOCH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+
+namespace xi
+{
+
+
+/** \brief Менеджер эпох: слоты читателей и корзины отложенно освобождаемых объектов.
+ *
+ *  Один менеджер может обслуживать несколько структур. \c retire() и \c synchronize()
+ *  потокобезопасны, но рассчитаны на редкие (пишущие) вызовы и сериализуются мьютексом.
+ */
+class EpochManager
+{
+public:
+    /** \brief Наибольшее число одновременно активных читателей. */
+    static const std::size_t MAX_READERS = 128;
+
+    /** \brief Через сколько \c retire() писатель пытается продвинуть эпоху. */
+    static const std::size_t ADVANCE_PERIOD = 32;
+
+    /** \brief Функция, окончательно освобождающая отложенный объект. */
+    typedef void (*Deleter)(void *obj);
+
+
+    /** \brief Объявляет читателя активным на время своей жизни (RAII). */
+    class ReaderGuard
+    {
+    public:
+        explicit ReaderGuard(EpochManager &em) : _em(em), _slot(em.enter()) {}
+        ~ReaderGuard() { _em.leave(_slot); }
+
+    protected:
+        ReaderGuard(const ReaderGuard &);               ///< КК не доступен.
+        ReaderGuard &operator=(const ReaderGuard &);    ///< Присваивание недоступно.
+
+    protected:
+        EpochManager &_em;                      ///< Менеджер.
+        std::size_t _slot;                      ///< Занятый слот.
+    }; // class EpochManager::ReaderGuard
+
+public:
+    EpochManager();                             ///< Конструктор по умолчанию.
+
+    /** \brief Деструктор. Освобождает все отложенные объекты: читателей к этому моменту быть не должно. */
+    ~EpochManager();
+
+public:
+    /** \brief Объявляет вход читателя; возвращает номер занятого слота для \c leave(). */
+    std::size_t enter();
+
+    /** \brief Объявляет выход читателя из слота \c slot. */
+    void leave(std::size_t slot);
+
+    /** \brief Откладывает освобождение \c obj функцией \c deleter до ухода всех читателей,
+     *  которые могли его видеть. Вызывается после того, как \c obj стал недостижим.
+     */
+    void retire(void *obj, Deleter deleter);
+
+    /** \brief Дожидается выхода всех текущих читателей и освобождает все отложенные объекты.
+     *
+     *  Нельзя вызывать из потока, который сам держит \c ReaderGuard этого менеджера.
+     */
+    void synchronize();
+
+    /** \brief Возвращает текущую глобальную эпоху. */
+    std::uint64_t getEpoch() const { return _epoch.load(); }
+
+    /** \brief Возвращает число отложенных, но еще не освобожденных объектов. */
+    std::size_t getRetiredNum() const;
+
+protected:
+    EpochManager(const EpochManager &);                 ///< КК не доступен.
+    EpochManager &operator=(const EpochManager &);      ///< Присваивание недоступно.
+
+protected:
+    /** \brief Отложенный объект. */
+    struct Retired
+    {
+        void *obj;                              ///< Объект.
+        Deleter deleter;                        ///< Чем освободить.
+    };
+
+    /** \brief Слот читателя на отдельной кэш-линии, чтобы читатели не делили линии. */
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint64_t> epoch;       ///< Объявленная эпоха; 0 — слот свободен.
+    };
+
+    /** \brief Число корзин: текущая эпоха и две предыдущие. */
+    static const std::size_t BUCKETS = 3;
+
+    /** \brief Продвигает эпоху, если все активные читатели объявили текущую. Вызывается под \c _retireLock. */
+    bool tryAdvance();
+
+    /** \brief Освобождает все объекты корзины \c bucket. */
+    static void freeBucket(std::vector<Retired> &bucket);
+
+protected:
+    std::atomic<std::uint64_t> _epoch;          ///< Глобальная эпоха (начинается с 1).
+    Slot _slots[MAX_READERS];                   ///< Слоты читателей.
+
+    mutable std::mutex _retireLock;             ///< Сериализует писателей.
+    std::vector<Retired> _buckets[BUCKETS];     ///< Корзины: объекты, вынутые в эпоху e, лежат в e % BUCKETS.
+    std::size_t _sinceAdvance;                  ///< Число retire() с последней попытки продвижения.
+}; // class EpochManager
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "epoch.hpp"
+
+#endif // RBTREE_EPOCH_H_
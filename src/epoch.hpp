@@ -0,0 +1,138 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация эпохального отложенного освобождения памяти
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" методов, описанных в файле epoch.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <functional>       // std::hash
+#include <thread>
+
+
+namespace xi
+{
+
+
+inline EpochManager::EpochManager()
+        : _epoch(1)
+        , _sinceAdvance(0)
+{
+    for (std::size_t i = 0; i < MAX_READERS; ++i)
+        _slots[i].epoch.store(0);
+}
+
+
+inline EpochManager::~EpochManager()
+{
+    for (std::size_t i = 0; i < BUCKETS; ++i)
+        freeBucket(_buckets[i]);
+}
+
+
+inline std::size_t EpochManager::enter()
+{
+    // начинаем с "своего" слота, чтобы потоки обычно не делили линии и не спорили за CAS
+    std::size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % MAX_READERS;
+
+    std::uint64_t e = _epoch.load();
+    for (;;)
+    {
+        std::uint64_t expected = 0;
+        if (_slots[slot].epoch.compare_exchange_strong(expected, e))
+            break;
+
+        slot = (slot + 1) % MAX_READERS;
+        if (slot == 0)
+            std::this_thread::yield();          // все слоты заняты — ждем освобождения
+    }
+
+    // Эпоха могла уйти вперед между ее чтением и объявлением, и писатель мог не увидеть
+    // объявления. Переобъявляем, пока не совпадет: после этого эпоха не продвинется
+    // дальше e + 1, пока слот занят.
+    for (;;)
+    {
+        std::uint64_t cur = _epoch.load();
+        if (cur == e)
+            break;
+        e = cur;
+        _slots[slot].epoch.store(e);
+    }
+
+    return slot;
+}
+
+
+inline void EpochManager::leave(std::size_t slot)
+{
+    _slots[slot].epoch.store(0);
+}
+
+
+inline void EpochManager::retire(void *obj, Deleter deleter)
+{
+    std::lock_guard<std::mutex> lock(_retireLock);
+
+    Retired r = { obj, deleter };
+    _buckets[_epoch.load() % BUCKETS].push_back(r);
+
+    if (++_sinceAdvance >= ADVANCE_PERIOD)
+    {
+        _sinceAdvance = 0;
+        tryAdvance();
+    }
+}
+
+
+inline void EpochManager::synchronize()
+{
+    std::lock_guard<std::mutex> lock(_retireLock);
+
+    // два продвижения освобождают обе непустые корзины: предыдущей эпохи и текущей
+    for (int i = 0; i < 2; ++i)
+        while (!tryAdvance())
+            std::this_thread::yield();
+
+    _sinceAdvance = 0;
+}
+
+
+inline std::size_t EpochManager::getRetiredNum() const
+{
+    std::lock_guard<std::mutex> lock(_retireLock);
+
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < BUCKETS; ++i)
+        n += _buckets[i].size();
+    return n;
+}
+
+
+inline bool EpochManager::tryAdvance()
+{
+    std::uint64_t e = _epoch.load();
+    for (std::size_t i = 0; i < MAX_READERS; ++i)
+    {
+        std::uint64_t v = _slots[i].epoch.load();
+        if (v != 0 && v != e)
+            return false;
+    }
+
+    // объекты эпохи e - 1 не видит ни один читатель: все активные вошли не раньше эпохи e
+    _epoch.store(e + 1);
+    freeBucket(_buckets[(e + 2) % BUCKETS]);    // == (e - 1) % BUCKETS
+    return true;
+}
+
+
+inline void EpochManager::freeBucket(std::vector<Retired> &bucket)
+{
+    for (std::size_t i = 0; i < bucket.size(); ++i)
+        bucket[i].deleter(bucket[i].obj);
+    bucket.clear();
+}
+
+
+} // namespace xi
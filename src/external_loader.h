@@ -0,0 +1,147 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Загрузка в RBTree наборов, не помещающихся в память целиком
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Внешняя сортировка слиянием, замкнутая на построение дерева за O(n). Элементы
+/// копятся в буфере фиксированного размера; заполненный буфер сортируется, из него
+/// убираются повторы, и он сбрасывается на диск отсортированным отрезком (run).
+/// При построении отрезки сливаются k-путевым слиянием через кучу с удалением
+/// повторов, и слитый поток сразу идет в \c RBTree::assignSorted() — без промежуточного
+/// вектора всех ключей. Отрезков больше \c MAX_FAN_IN сначала сливаются в более
+/// длинные промежуточными проходами.
+///
+/// Пиковая память — итоговое дерево плюс буфер (при построении буфер уже освобожден,
+/// а у каждого открытого отрезка свой небольшой буфер чтения). Число элементов после
+/// удаления повторов заранее неизвестно, поэтому узлы дерева выделяются блоками
+/// фиксированного размера по мере слияния: сверх итогового дерева — не больше одного блока.
+///
+/// "Реализация" соответствующих методов располагается в файле external_loader.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_EXTERNAL_LOADER_H_
+#define RBTREE_EXTERNAL_LOADER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>       // std::less
+#include <string>
+#include <vector>
+
+#include "rbtree.h"
+#include "rbtree_serial.h"
+#include "task_pool.h"
+
+
+namespace xi
+{
+
+
+/** \brief Загрузчик неупорядоченного потока элементов в \c RBTree с ограниченной памятью.
+ *
+ *  Элементы подаются \c add() в любом порядке и с повторами; \c build() строит из них
+ *  дерево. Временные файлы отрезков создаются в \c tmpDir и удаляются, как только
+ *  становятся не нужны (и в деструкторе). Ошибки ввода-вывода сообщаются
+ *  \c std::runtime_error.
+ *
+ *  \tparam Traits Кодирование элементов в файлах отрезков (см. \c RBTreeSerialTraits).
+ */
+template<typename Element, typename Compar = std::less<Element>,
+         typename Traits = RBTreeSerialTraits<Element> >
+class ExternalLoader
+{
+public:
+    typedef RBTree<Element, Compar> TTree;
+
+    /** \brief Размер буфера по умолчанию. */
+    static const std::size_t DEF_BUFFER_BYTES = std::size_t(64) << 20;
+
+    /** \brief Сколько отрезков сливается за один проход. */
+    static const std::size_t MAX_FAN_IN = 64;
+
+public:
+    /** \brief Создает загрузчик.
+     *
+     *  \param tmpDir Каталог временных файлов.
+     *  \param bufferBytes Размер буфера; в нем помещается bufferBytes / sizeof(Element)
+     *  элементов (для элементов с динамической частью это лишь оценка).
+     *  \param pool Пул для параллельной сортировки буфера; может быть \c nullptr.
+     */
+    explicit ExternalLoader(const std::string &tmpDir, std::size_t bufferBytes = DEF_BUFFER_BYTES,
+                            TaskPool *pool = nullptr);
+
+    /** \brief Деструктор. Удаляет оставшиеся временные файлы. */
+    ~ExternalLoader();
+
+public:
+    /** \brief Добавляет элемент. */
+    void add(const Element &key);
+
+    /** \brief Добавляет элементы [\c first, \c last); итератор проходится один раз
+     *  (подойдет, например, \c std::istream_iterator).
+     */
+    template<typename InputIt>
+    void add(InputIt first, InputIt last);
+
+    /** \brief Строит в пустом дереве \c tree дерево из всех добавленных элементов без повторов
+     *  и делает загрузчик пустым.
+     *
+     *  Если \c tree не пусто, генерирует \c std::invalid_argument.
+     */
+    void build(TTree &tree);
+
+    /** \brief Возвращает число отрезков, сброшенных на диск. */
+    std::size_t getRunsNum() const { return _runs.size(); }
+
+protected:
+    ExternalLoader(const ExternalLoader &);                 ///< КК не доступен.
+    ExternalLoader &operator=(const ExternalLoader &);      ///< Присваивание недоступно.
+
+protected:
+    /** \brief Отрезок на диске. */
+    struct Run
+    {
+        std::string path;                       ///< Файл.
+        std::uint64_t size;                     ///< Число элементов.
+    };
+
+    class Merger;
+    class MergeIterator;
+
+    /** \brief Сортирует буфер и удаляет из него повторы. */
+    void sortBuffer();
+
+    /** \brief Сбрасывает буфер на диск новым отрезком. */
+    void spill();
+
+    /** \brief Сливает отрезки \c _runs[\c first, \c last) в один новый отрезок. */
+    Run mergeRuns(std::size_t first, std::size_t last);
+
+    /** \brief Возвращает путь для нового временного файла. */
+    std::string newRunPath();
+
+    /** \brief Удаляет файлы всех отрезков. */
+    void removeRuns();
+
+protected:
+    std::string _tmpDir;                        ///< Каталог временных файлов.
+    std::size_t _bufferCapacity;                ///< Вместимость буфера в элементах.
+    TaskPool *_pool;                            ///< Пул сортировки или \c nullptr.
+    Compar _compar;                             ///< Компаратор.
+
+    std::vector<Element> _buffer;               ///< Буфер еще не сброшенных элементов.
+    std::vector<Run> _runs;                     ///< Сброшенные отрезки.
+    std::string _runPrefix;                     ///< Общая часть имен файлов этого загрузчика.
+    std::size_t _filesNum;                      ///< Счетчик для имен файлов.
+}; // class ExternalLoader
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "external_loader.hpp"
+
+#endif // RBTREE_EXTERNAL_LOADER_H_
@@ -0,0 +1,350 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация загрузчика наборов, не помещающихся в память
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле external_loader.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>        // std::sort, std::unique, std::push_heap, std::pop_heap
+#include <cstdio>           // std::snprintf
+#include <fstream>
+#include <memory>           // std::unique_ptr
+#include <optional>
+#include <random>           // std::random_device
+#include <stdexcept>        // std::invalid_argument, std::runtime_error
+
+
+namespace xi
+{
+
+
+//==============================================================================
+// class ExternalLoader::Merger
+//==============================================================================
+
+/** \brief k-путевое слияние отрезков с удалением повторов. */
+template<typename Element, typename Compar, typename Traits>
+class ExternalLoader<Element, Compar, Traits>::Merger
+{
+public:
+    /** \brief Размер буфера чтения каждого отрезка. */
+    static const std::size_t READ_BUFFER = 1 << 16;
+
+public:
+    Merger(const std::vector<Run> &runs, std::size_t first, std::size_t last, const Compar &compar)
+            : _compar(compar)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            std::unique_ptr<Source> src(new Source(READ_BUFFER));
+            src->in.rdbuf()->pubsetbuf(src->buf.data(), static_cast<std::streamsize>(src->buf.size()));
+            src->in.open(runs[i].path, std::ios::binary);
+            if (!src->in)
+                throw std::runtime_error("Cannot open run file '" + runs[i].path + "'");
+            src->left = runs[i].size;
+            _sources.push_back(std::move(src));
+        }
+
+        _heads.resize(_sources.size());
+        for (std::size_t i = 0; i < _sources.size(); ++i)
+            if (readHead(i))
+                pushHeap(i);
+    }
+
+    /** \brief Кладет в \c out следующий по возрастанию элемент без повторов.
+     *  \returns ложь, если элементы кончились.
+     */
+    bool next(Element &out)
+    {
+        while (!_heap.empty())
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), HeapOrder(this));
+            std::size_t i = _heap.back();
+
+            // каждый отрезок без повторов, так что равные приходят из разных отрезков подряд
+            bool fresh = !_last || _compar(*_last, *_heads[i]);
+            if (fresh)
+                _last = *_heads[i];
+
+            if (readHead(i))
+                std::push_heap(_heap.begin(), _heap.end(), HeapOrder(this));
+            else
+                _heap.pop_back();
+
+            if (fresh)
+            {
+                out = *_last;
+                return true;
+            }
+        }
+        return false;
+    }
+
+protected:
+    /** \brief Открытый отрезок. */
+    struct Source
+    {
+        explicit Source(std::size_t bufSize) : buf(bufSize), left(0) {}
+
+        std::vector<char> buf;                  ///< Буфер чтения (до \c in: отдается ему).
+        std::ifstream in;                       ///< Файл.
+        std::uint64_t left;                     ///< Сколько элементов осталось прочесть.
+    };
+
+    /** \brief Порядок кучи: наверху отрезок с наименьшим текущим элементом. */
+    struct HeapOrder
+    {
+        explicit HeapOrder(const Merger *m) : merger(m) {}
+        bool operator()(std::size_t a, std::size_t b) const
+        {
+            return merger->_compar(*merger->_heads[b], *merger->_heads[a]);
+        }
+        const Merger *merger;
+    };
+
+    /** \brief Читает следующий элемент отрезка \c i в \c _heads[i]; ложь — отрезок кончился. */
+    bool readHead(std::size_t i)
+    {
+        Source &src = *_sources[i];
+        if (src.left == 0)
+        {
+            src.in.close();
+            return false;
+        }
+
+        _heads[i] = Traits::read(src.in);
+        if (!src.in)
+            throw std::runtime_error("Truncated run file");
+        --src.left;
+        return true;
+    }
+
+    void pushHeap(std::size_t i)
+    {
+        _heap.push_back(i);
+        std::push_heap(_heap.begin(), _heap.end(), HeapOrder(this));
+    }
+
+protected:
+    Compar _compar;                                 ///< Компаратор.
+    std::vector<std::unique_ptr<Source> > _sources; ///< Отрезки.
+    std::vector<std::optional<Element> > _heads;    ///< Текущий элемент каждого отрезка.
+    std::vector<std::size_t> _heap;                 ///< Куча номеров непустых отрезков.
+    std::optional<Element> _last;                   ///< Последний выданный элемент.
+}; // class ExternalLoader::Merger
+
+
+/** \brief Однопроходный итератор по результату слияния — вход для \c RBTree::assignSorted(). */
+template<typename Element, typename Compar, typename Traits>
+class ExternalLoader<Element, Compar, Traits>::MergeIterator
+{
+public:
+    /** \brief Итератор конца слияния. */
+    MergeIterator() : _merger(nullptr) {}
+
+    explicit MergeIterator(Merger &merger) : _merger(&merger) { advance(); }
+
+    const Element &operator*() const { return *_cur; }
+
+    /** \brief Различает лишь конец слияния и не конец: другого сравнения однопроходному не нужно. */
+    bool operator!=(const MergeIterator &other) const { return _cur.has_value() != other._cur.has_value(); }
+
+    MergeIterator &operator++()
+    {
+        advance();
+        return *this;
+    }
+
+protected:
+    void advance()
+    {
+        Element el;
+        if (_merger->next(el))
+            _cur = el;
+        else
+            _cur.reset();
+    }
+
+protected:
+    Merger *_merger;                            ///< Слияние.
+    std::optional<Element> _cur;                ///< Текущий элемент; пусто — слияние кончилось.
+}; // class ExternalLoader::MergeIterator
+
+
+//==============================================================================
+// class ExternalLoader
+//==============================================================================
+
+template<typename Element, typename Compar, typename Traits>
+ExternalLoader<Element, Compar, Traits>::ExternalLoader(const std::string &tmpDir, std::size_t bufferBytes,
+                                                        TaskPool *pool)
+        : _tmpDir(tmpDir)
+        , _bufferCapacity(bufferBytes / sizeof(Element) ? bufferBytes / sizeof(Element) : 1)
+        , _pool(pool)
+        , _filesNum(0)
+{
+    // имена файлов не должны совпасть с файлами других загрузчиков, в том числе в других процессах
+    std::random_device rd;
+    char prefix[48];
+    std::snprintf(prefix, sizeof(prefix), "xi_rbtree_run_%08x%08x_", rd(), rd());
+    _runPrefix = prefix;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+ExternalLoader<Element, Compar, Traits>::~ExternalLoader()
+{
+    removeRuns();
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void ExternalLoader<Element, Compar, Traits>::add(const Element &key)
+{
+    // буфер растет, но не дальше своей вместимости
+    if (_buffer.size() == _buffer.capacity() && _buffer.capacity() < _bufferCapacity)
+        _buffer.reserve(std::min(std::max<std::size_t>(2 * _buffer.capacity(), 1024), _bufferCapacity));
+
+    _buffer.push_back(key);
+    if (_buffer.size() >= _bufferCapacity)
+        spill();
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+template<typename InputIt>
+void ExternalLoader<Element, Compar, Traits>::add(InputIt first, InputIt last)
+{
+    for (; first != last; ++first)
+        add(*first);
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void ExternalLoader<Element, Compar, Traits>::sortBuffer()
+{
+    if (_pool)
+        _pool->sort(_buffer.begin(), _buffer.end(), _compar);
+    else
+        std::sort(_buffer.begin(), _buffer.end(), _compar);
+
+    // после сортировки равные рядом: соседи равны, если левый не меньше правого
+    const Compar &compar = _compar;
+    _buffer.erase(std::unique(_buffer.begin(), _buffer.end(),
+                              [&compar](const Element &a, const Element &b) { return !compar(a, b); }),
+                  _buffer.end());
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+std::string ExternalLoader<Element, Compar, Traits>::newRunPath()
+{
+    return _tmpDir + "/" + _runPrefix + std::to_string(_filesNum++) + ".run";
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void ExternalLoader<Element, Compar, Traits>::spill()
+{
+    sortBuffer();
+
+    Run run = { newRunPath(), _buffer.size() };
+    {
+        std::ofstream out(run.path, std::ios::binary | std::ios::trunc);
+        for (std::size_t i = 0; i < _buffer.size() && out; ++i)
+            Traits::write(out, _buffer[i]);
+        out.close();
+        if (!out)
+        {
+            std::remove(run.path.c_str());
+            throw std::runtime_error("Cannot write run file '" + run.path + "'");
+        }
+    }
+
+    _runs.push_back(run);
+    _buffer.clear();
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+typename ExternalLoader<Element, Compar, Traits>::Run
+ExternalLoader<Element, Compar, Traits>::mergeRuns(std::size_t first, std::size_t last)
+{
+    Run run = { newRunPath(), 0 };
+    try
+    {
+        Merger merger(_runs, first, last, _compar);
+        std::ofstream out(run.path, std::ios::binary | std::ios::trunc);
+        Element el;
+        while (out && merger.next(el))
+        {
+            Traits::write(out, el);
+            ++run.size;
+        }
+        out.close();
+        if (!out)
+            throw std::runtime_error("Cannot write run file '" + run.path + "'");
+    }
+    catch (...)
+    {
+        std::remove(run.path.c_str());
+        throw;
+    }
+    return run;
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void ExternalLoader<Element, Compar, Traits>::build(TTree &tree)
+{
+    if (!tree.isEmpty())
+        throw std::invalid_argument("Target tree must be empty");
+
+    // все поместилось в буфер — диск не нужен
+    if (_runs.empty())
+    {
+        sortBuffer();
+        tree.assignSorted(_buffer.begin(), _buffer.size());
+        std::vector<Element>().swap(_buffer);
+        return;
+    }
+
+    if (!_buffer.empty())
+        spill();
+    std::vector<Element>().swap(_buffer);       // память буфера нужна дереву
+
+    // слишком много отрезков — сливаем самые старые в один, пока не останется на один проход
+    while (_runs.size() > MAX_FAN_IN)
+    {
+        Run merged = mergeRuns(0, MAX_FAN_IN);
+        for (std::size_t i = 0; i < MAX_FAN_IN; ++i)
+            std::remove(_runs[i].path.c_str());
+        _runs.erase(_runs.begin(), _runs.begin() + MAX_FAN_IN);
+        _runs.push_back(merged);
+    }
+
+    // Повторы между отрезками известны только после слияния: сумма длин отрезков — лишь
+    // верхняя граница, а узлы assignSorted() выделяет блоками по мере прихода элементов.
+    std::size_t maxN = 0;
+    for (std::size_t i = 0; i < _runs.size(); ++i)
+        maxN += static_cast<std::size_t>(_runs[i].size);
+
+    Merger merger(_runs, 0, _runs.size(), _compar);
+    tree.assignSorted(MergeIterator(merger), MergeIterator(), maxN);
+    removeRuns();
+}
+
+
+template<typename Element, typename Compar, typename Traits>
+void ExternalLoader<Element, Compar, Traits>::removeRuns()
+{
+    for (std::size_t i = 0; i < _runs.size(); ++i)
+        std::remove(_runs[i].path.c_str());
+    _runs.clear();
+}
+
+
+} // namespace xi
@@ -0,0 +1,154 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Красно-черное дерево с доступом через flat combining
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Поток не захватывает дерево сам, а публикует операцию (вставку, удаление, поиск)
+/// в свободном слоте общего массива и ждет ее результата. Поток, которому удалось
+/// захватить блокировку, становится комбинирующим: собирает все опубликованные
+/// операции, упорядочивает их по ключу и выполняет за один проход, раздавая результаты.
+/// Вместо передачи блокировки из рук в руки на каждой операции она передается раз на
+/// пачку, а спуски отсортированных операций идут по прогретым в кэше путям. Без
+/// конкуренции поток, сразу захвативший свободную блокировку, ничего не публикует.
+///
+/// "Реализация" соответствующих методов располагается в файле flat_combining_rbtree.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_FLAT_COMBINING_RBTREE_H_
+#define RBTREE_FLAT_COMBINING_RBTREE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>        // std::exception_ptr
+#include <mutex>
+#include <vector>
+
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+
+/** \brief Красно-черное дерево, разделяемое многими писателями через flat combining.
+ *
+ *  Все операции синхронны и линеаризуемы: операция выполнена, когда метод вернулся.
+ *  Ошибки сообщаются как у \c RBTree: вставка существующего ключа и удаление
+ *  отсутствующего генерируют \c std::invalid_argument в вызвавшем потоке.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class FlatCombiningRBTree
+{
+public:
+    typedef RBTree<Element, Compar> TTree;
+
+    /** \brief Число слотов публикации: одновременно ждущих операций не больше этого. */
+    static const std::size_t MAX_SLOTS = 128;
+
+public:
+    /** \brief Создает пустое дерево. */
+    FlatCombiningRBTree();
+
+public:
+    // Запись
+
+    /** \brief Вставляет \c key. Если он уже есть, генерирует \c std::invalid_argument. */
+    void insert(const Element &key);
+
+#ifdef RBTREE_WITH_DELETION
+
+    /** \brief Удаляет \c key. Если его нет, генерирует \c std::invalid_argument. */
+    void remove(const Element &key);
+
+#endif // RBTREE_WITH_DELETION
+
+public:
+    // Чтение
+
+    /** \brief Возвращает истину, если \c key есть в дереве. Поиск комбинируется вместе с записями. */
+    bool contains(const Element &key) const;
+
+    /** \brief Вызывает \c fn для каждого элемента в порядке возрастания, удерживая блокировку. */
+    template<typename F>
+    void forEach(F fn) const;
+
+    /** \brief Возвращает число проходов комбинирования (для наблюдения за тем, насколько
+     *  операции сливаются в пачки).
+     */
+    std::size_t getPassesNum() const { return _passesNum.load(std::memory_order_relaxed); }
+
+protected:
+    FlatCombiningRBTree(const FlatCombiningRBTree &);                   ///< КК не доступен.
+    FlatCombiningRBTree &operator=(const FlatCombiningRBTree &);        ///< Присваивание недоступно.
+
+protected:
+    /** \brief Вид операции. */
+    enum OpKind
+    {
+        OP_INSERT,
+        OP_REMOVE,
+        OP_FIND
+    };
+
+    /** \brief Состояние слота. */
+    enum SlotState
+    {
+        SLOT_FREE,                              ///< Свободен.
+        SLOT_CLAIMED,                           ///< Занят потоком, операция еще заполняется.
+        SLOT_PENDING,                           ///< Операция опубликована и ждет комбинирующего.
+        SLOT_DONE                               ///< Операция выполнена, результат готов.
+    };
+
+    /** \brief Слот публикации; каждый в своей кэш-линии, чтобы ждущие потоки не мешали друг другу. */
+    struct alignas(64) Slot
+    {
+        Slot() : state(SLOT_FREE), op(OP_FIND), key(nullptr), result(false) {}
+
+        std::atomic<int> state;                 ///< Состояние (\c SlotState).
+        OpKind op;                              ///< Операция.
+        const Element *key;                     ///< Ключ; живет на стеке ждущего потока.
+        bool result;                            ///< Успех операции / найден ли ключ.
+        std::exception_ptr error;               ///< Исключение, возникшее при выполнении.
+    };
+
+    /** \brief Публикует операцию, дожидается ее выполнения (при случае комбинируя сам)
+     *  и возвращает результат.
+     */
+    bool perform(OpKind op, const Element &key) const;
+
+    /** \brief Выполняет все опубликованные операции. Вызывается под \c _lock. */
+    void combine() const;
+
+    /** \brief Выполняет одну операцию над деревом. Вызывается под \c _lock. */
+    bool execute(OpKind op, const Element &key) const;
+
+    /** \brief Возвращает слот, с которого текущий поток начинает искать свободный. */
+    static std::size_t homeSlot();
+
+protected:
+    // mutable: поиск тоже проходит через комбинирование, а комбинирующий поток
+    // выполняет и чужие записи
+    mutable TTree _tree;                        ///< Само дерево.
+    mutable std::mutex _lock;                   ///< Блокировка комбинирующего.
+    mutable Slot _slots[MAX_SLOTS];             ///< Слоты публикации.
+    mutable std::vector<Slot *> _batch;         ///< Пачка текущего прохода (под \c _lock).
+    mutable std::atomic<std::size_t> _passesNum; ///< Число проходов комбинирования.
+
+    /** \brief Число опубликованных и еще не собранных операций: при нуле комбинирующий
+     *  не просматривает слоты.
+     */
+    mutable std::atomic<std::size_t> _publishedNum;
+
+    Compar _compar;                             ///< Компаратор для сортировки пачки.
+}; // class FlatCombiningRBTree
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "flat_combining_rbtree.hpp"
+
+#endif // RBTREE_FLAT_COMBINING_RBTREE_H_
@@ -0,0 +1,194 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация красно-черного дерева с доступом через flat combining
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле flat_combining_rbtree.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>        // std::sort
+#include <functional>       // std::hash
+#include <stdexcept>        // std::invalid_argument
+#include <thread>
+
+
+namespace xi
+{
+
+
+template<typename Element, typename Compar>
+FlatCombiningRBTree<Element, Compar>::FlatCombiningRBTree()
+        : _passesNum(0), _publishedNum(0)
+{
+    _batch.reserve(MAX_SLOTS);
+}
+
+
+template<typename Element, typename Compar>
+void FlatCombiningRBTree<Element, Compar>::insert(const Element &key)
+{
+    if (!perform(OP_INSERT, key))
+        throw std::invalid_argument("Key already exists");
+}
+
+
+#ifdef RBTREE_WITH_DELETION
+
+template<typename Element, typename Compar>
+void FlatCombiningRBTree<Element, Compar>::remove(const Element &key)
+{
+    if (!perform(OP_REMOVE, key))
+        throw std::invalid_argument("Key not find");
+}
+
+#endif // RBTREE_WITH_DELETION
+
+
+template<typename Element, typename Compar>
+bool FlatCombiningRBTree<Element, Compar>::contains(const Element &key) const
+{
+    return perform(OP_FIND, key);
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void FlatCombiningRBTree<Element, Compar>::forEach(F fn) const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    for (typename TTree::ConstIterator it = _tree.begin(); it != _tree.end(); ++it)
+        fn(*it);
+}
+
+
+template<typename Element, typename Compar>
+std::size_t FlatCombiningRBTree<Element, Compar>::homeSlot()
+{
+    thread_local std::size_t home = std::hash<std::thread::id>()(std::this_thread::get_id()) % MAX_SLOTS;
+    return home;
+}
+
+
+template<typename Element, typename Compar>
+bool FlatCombiningRBTree<Element, Compar>::perform(OpKind op, const Element &key) const
+{
+    // блокировка свободна — выполняем сразу, заодно и опубликованное другими
+    if (_lock.try_lock())
+    {
+        std::lock_guard<std::mutex> lock(_lock, std::adopt_lock);
+        bool result = execute(op, key);
+        combine();
+        return result;
+    }
+
+    // занимаем свободный слот, начиная со "своего": у разных потоков они обычно разные
+    Slot *slot = nullptr;
+    for (std::size_t i = homeSlot(); !slot; i = (i + 1) % MAX_SLOTS)
+    {
+        int expected = SLOT_FREE;
+        if (_slots[i].state.load(std::memory_order_relaxed) == SLOT_FREE &&
+            _slots[i].state.compare_exchange_strong(expected, SLOT_CLAIMED, std::memory_order_acquire))
+            slot = &_slots[i];
+        else if (i + 1 == MAX_SLOTS)
+            std::this_thread::yield();          // все слоты заняты — даем им освободиться
+    }
+
+    slot->op = op;
+    slot->key = &key;
+    slot->error = nullptr;
+
+    // счетчик — до публикации: комбинирующий может увидеть его и не найти слота, но не наоборот
+    _publishedNum.fetch_add(1);
+    slot->state.store(SLOT_PENDING, std::memory_order_release);
+
+    // ждем, пока операцию выполнит комбинирующий; если блокировка свободна — комбинируем сами
+    while (slot->state.load(std::memory_order_acquire) != SLOT_DONE)
+    {
+        if (_lock.try_lock())
+        {
+            combine();
+            _lock.unlock();
+        }
+        else
+            std::this_thread::yield();
+    }
+
+    bool result = slot->result;
+    std::exception_ptr error = slot->error;
+    slot->error = nullptr;
+    slot->state.store(SLOT_FREE, std::memory_order_release);
+
+    if (error)
+        std::rethrow_exception(error);
+    return result;
+}
+
+
+template<typename Element, typename Compar>
+void FlatCombiningRBTree<Element, Compar>::combine() const
+{
+    if (_publishedNum.load() == 0)
+        return;
+
+    _batch.clear();
+    for (std::size_t i = 0; i < MAX_SLOTS; ++i)
+        if (_slots[i].state.load(std::memory_order_acquire) == SLOT_PENDING)
+            _batch.push_back(&_slots[i]);
+
+    if (_batch.empty())
+        return;
+    _publishedNum.fetch_sub(_batch.size());
+
+    // по ключу: соседние спуски идут по уже прогретым путям
+    const Compar &compar = _compar;
+    std::sort(_batch.begin(), _batch.end(),
+              [&compar](const Slot *a, const Slot *b) { return compar(*a->key, *b->key); });
+
+    for (std::size_t i = 0; i < _batch.size(); ++i)
+    {
+        Slot *slot = _batch[i];
+        try
+        {
+            slot->result = execute(slot->op, *slot->key);
+        }
+        catch (...)
+        {
+            slot->error = std::current_exception();
+        }
+        slot->state.store(SLOT_DONE, std::memory_order_release);
+    }
+
+    _passesNum.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+template<typename Element, typename Compar>
+bool FlatCombiningRBTree<Element, Compar>::execute(OpKind op, const Element &key) const
+{
+    bool present = _tree.find(key) != nullptr;
+
+    switch (op)
+    {
+    case OP_INSERT:
+        if (present)
+            return false;
+        _tree.insert(key);
+        return true;
+
+#ifdef RBTREE_WITH_DELETION
+    case OP_REMOVE:
+        if (!present)
+            return false;
+        _tree.remove(key);
+        return true;
+#endif // RBTREE_WITH_DELETION
+
+    default:
+        return present;
+    }
+}
+
+
+} // namespace xi
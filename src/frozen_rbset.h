@@ -0,0 +1,108 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Неизменяемое множество в раскладке Эйтцингера (BFS-порядок)
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Замороженный снимок красно-черного дерева для сценариев "построили один раз —
+/// ищем миллиарды раз". Ключи лежат одним выровненным массивом в порядке обхода
+/// в ширину идеального дерева поиска: потомки элемента k — элементы 2k и 2k+1.
+/// Поиск не разыменовывает указателей, обходится без ветвлений по результату
+/// сравнения и заранее подтягивает в кэш линию с потомками на несколько уровней ниже.
+///
+/// "Реализация" соответствующих методов располагается в файле frozen_rbset.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_FROZEN_RBSET_H_
+#define RBTREE_FROZEN_RBSET_H_
+
+#include <cstddef>
+#include <functional>       // std::less
+
+#include "prefetch.h"
+
+
+namespace xi
+{
+
+
+/** \brief Неизменяемое упорядоченное множество в раскладке Эйтцингера.
+ *
+ *  Обычно получается вызовом \c RBTree::freeze(), но может быть построено из любой
+ *  строго возрастающей (в смысле \c Compar) последовательности за O(n).
+ *
+ *  \tparam Element Тип элементов.
+ *  \tparam Compar Функтор сравнения, тот же, что и у исходного дерева.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class FrozenRBSet
+{
+public:
+    /** \brief Размер кэш-линии, по которой выравнивается массив. */
+    static const std::size_t CACHE_LINE = 64;
+
+public:
+    /** \brief Создает пустое множество. */
+    FrozenRBSet();
+
+    /** \brief Строит множество из \c n элементов, перечисляемых итератором \c first
+     *  в строго возрастающем порядке.
+     */
+    template<typename InputIt>
+    FrozenRBSet(InputIt first, std::size_t n);
+
+    FrozenRBSet(FrozenRBSet &&other);               ///< Перемещающий конструктор.
+    FrozenRBSet &operator=(FrozenRBSet &&other);    ///< Перемещающее присваивание.
+
+    ~FrozenRBSet();                                 ///< Деструктор.
+
+public:
+    /** \brief Возвращает истину, если \c key содержится в множестве. */
+    bool contains(const Element &key) const { return find(key) != nullptr; }
+
+    /** \brief Возвращает указатель на элемент, эквивалентный \c key, либо \c nullptr. */
+    const Element *find(const Element &key) const;
+
+    /** \brief Возвращает указатель на наименьший элемент, не меньший \c key, либо \c nullptr. */
+    const Element *lowerBound(const Element &key) const;
+
+    /** \brief Возвращает число элементов. */
+    std::size_t getSize() const { return _size; }
+
+    /** \brief Возвращает истину, если множество пусто. */
+    bool isEmpty() const { return _size == 0; }
+
+protected:
+    FrozenRBSet(const FrozenRBSet &);               ///< КК не доступен.
+    FrozenRBSet &operator=(const FrozenRBSet &);    ///< Оператор присваивания недоступен.
+
+protected:
+    /** \brief Рекурсивно заполняет поддерево с корнем в позиции \c k очередными элементами \c it,
+     *  считая созданные элементы в \c built.
+     */
+    template<typename InputIt>
+    void fill(std::size_t k, InputIt &it, std::size_t &built);
+
+    /** \brief Возвращает позицию (с единицы) нижней грани \c key, 0 — если ее нет. */
+    std::size_t lowerBoundPos(const Element &key) const;
+
+    /** \brief Уничтожает элементы и освобождает память. */
+    void release();
+
+protected:
+    Compar _compar;                             ///< Компаратор сравнения двух элементов.
+
+    void *_mem;                                 ///< Сырой (невыровненный) блок памяти.
+    Element *_data;                             ///< Массив с нулевой фиктивной позицией: элементы в [1.._size].
+    std::size_t _size;                          ///< Число элементов.
+}; // class FrozenRBSet
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "frozen_rbset.hpp"
+
+#endif // RBTREE_FROZEN_RBSET_H_
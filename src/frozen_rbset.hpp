@@ -0,0 +1,245 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация неизменяемого множества в раскладке Эйтцингера
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле frozen_rbset.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <new>              // operator new, placement new
+#include <cstdint>          // std::uintptr_t
+
+
+namespace xi
+{
+
+/** \brief Алгоритмы над массивом в раскладке Эйтцингера с позициями, нумеруемыми с единицы. */
+namespace eytzinger
+{
+
+/** \brief Наибольшая степень двойки, не превосходящая \c x (для x >= 1). */
+constexpr std::size_t floorPow2(std::size_t x)
+{
+    return (x < 2) ? 1 : 2 * floorPow2(x / 2);
+}
+
+/** \brief Сколько элементов опережающе подтягивается в кэш: столько потомков на одной
+ *  глубине умещается в кэш-линию (но не меньше двух — это оба сына).
+ */
+template<typename Element>
+constexpr std::size_t prefetchStride()
+{
+    return (64 / sizeof(Element) < 2) ? 2 : floorPow2(64 / sizeof(Element));
+}
+
+/** \brief Число младших единичных битов \c k. */
+inline unsigned trailingOnes(std::size_t k)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(~static_cast<unsigned long long>(k)));
+#else
+    unsigned r = 0;
+    while (k & 1)
+    {
+        k >>= 1;
+        ++r;
+    }
+    return r;
+#endif
+}
+
+/** \brief Возвращает позицию нижней грани \c key в массиве \c data из \c n элементов, 0 — если ее нет.
+ *
+ *  Спуск идет вправо, когда элемент меньше ключа; выбор сына — арифметика над результатом
+ *  сравнения, а не ветвление. Из итоговой позиции снимаются хвостовые "правые" шаги
+ *  и еще один — последний шаг влево, это и есть нижняя грань.
+ */
+template<typename Element, typename Compar>
+std::size_t lowerBoundPos(const Element *data, std::size_t n, const Compar &compar, const Element &key)
+{
+    const std::size_t stride = prefetchStride<Element>();
+
+    std::size_t k = 1;
+    while (k <= n)
+    {
+        // адрес лишь подсказка процессору, за пределы массива он не разыменовывается
+        XI_RBTREE_PREFETCH(reinterpret_cast<const char *>(data) + k * stride * sizeof(Element));
+        k = 2 * k + static_cast<std::size_t>(compar(data[k], key));
+    }
+
+    return k >> (trailingOnes(k) + 1);
+}
+
+/** \brief Возвращает позицию, следующую за \c k в порядке возрастания, 0 — если \c k последняя. */
+inline std::size_t nextPos(std::size_t k, std::size_t n)
+{
+    // есть правое поддерево — идем в его самый левый узел
+    if (2 * k + 1 <= n)
+    {
+        k = 2 * k + 1;
+        while (2 * k <= n)
+            k = 2 * k;
+        return k;
+    }
+
+    // иначе поднимаемся, пока мы правый сын, и еще на шаг
+    return k >> (trailingOnes(k) + 1);
+}
+
+} // namespace eytzinger
+
+
+//==============================================================================
+// class FrozenRBSet
+//==============================================================================
+
+template<typename Element, typename Compar>
+FrozenRBSet<Element, Compar>::FrozenRBSet()
+        : _mem(nullptr)
+        , _data(nullptr)
+        , _size(0)
+{
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+FrozenRBSet<Element, Compar>::FrozenRBSet(InputIt first, std::size_t n)
+        : _mem(nullptr)
+        , _data(nullptr)
+        , _size(0)
+{
+    if (n == 0)
+        return;
+
+    // позиция 0 фиктивная; выравниваем начало массива по кэш-линии, тогда
+    // потомки одного уровня, подтягиваемые за раз, лежат в одной линии
+    _mem = ::operator new((n + 1) * sizeof(Element) + CACHE_LINE);
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(_mem);
+    addr = (addr + CACHE_LINE - 1) & ~static_cast<std::uintptr_t>(CACHE_LINE - 1);
+    _data = reinterpret_cast<Element *>(addr);
+
+    _size = n;
+    std::size_t built = 0;
+    try
+    {
+        fill(1, first, built);
+    }
+    catch (...)
+    {
+        // созданы первые built элементов в порядке возрастания — их и разрушаем
+        std::size_t k = 1;
+        while (2 * k <= n)
+            k = 2 * k;
+        for (std::size_t i = 0; i < built; ++i, k = eytzinger::nextPos(k, n))
+            _data[k].~Element();
+
+        ::operator delete(_mem);
+        _mem = nullptr;
+        _data = nullptr;
+        _size = 0;
+        throw;
+    }
+}
+
+
+template<typename Element, typename Compar>
+FrozenRBSet<Element, Compar>::FrozenRBSet(FrozenRBSet &&other)
+        : _compar(other._compar)
+        , _mem(other._mem)
+        , _data(other._data)
+        , _size(other._size)
+{
+    other._mem = nullptr;
+    other._data = nullptr;
+    other._size = 0;
+}
+
+
+template<typename Element, typename Compar>
+FrozenRBSet<Element, Compar> &FrozenRBSet<Element, Compar>::operator=(FrozenRBSet &&other)
+{
+    if (this == &other)
+        return *this;
+
+    release();
+
+    _compar = other._compar;
+    _mem = other._mem;
+    _data = other._data;
+    _size = other._size;
+
+    other._mem = nullptr;
+    other._data = nullptr;
+    other._size = 0;
+
+    return *this;
+}
+
+
+template<typename Element, typename Compar>
+FrozenRBSet<Element, Compar>::~FrozenRBSet()
+{
+    release();
+}
+
+
+template<typename Element, typename Compar>
+void FrozenRBSet<Element, Compar>::release()
+{
+    for (std::size_t k = 1; k <= _size; ++k)
+        _data[k].~Element();
+
+    ::operator delete(_mem);
+    _mem = nullptr;
+    _data = nullptr;
+    _size = 0;
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void FrozenRBSet<Element, Compar>::fill(std::size_t k, InputIt &it, std::size_t &built)
+{
+    if (k > _size)
+        return;
+
+    // симметричный порядок обхода позиций совпадает с порядком возрастания ключей
+    fill(2 * k, it, built);
+    new (_data + k) Element(*it);
+    ++built;
+    ++it;
+    fill(2 * k + 1, it, built);
+}
+
+
+template<typename Element, typename Compar>
+std::size_t FrozenRBSet<Element, Compar>::lowerBoundPos(const Element &key) const
+{
+    return eytzinger::lowerBoundPos(_data, _size, _compar, key);
+}
+
+
+template<typename Element, typename Compar>
+const Element *FrozenRBSet<Element, Compar>::lowerBound(const Element &key) const
+{
+    std::size_t k = lowerBoundPos(key);
+    return k ? _data + k : nullptr;
+}
+
+
+template<typename Element, typename Compar>
+const Element *FrozenRBSet<Element, Compar>::find(const Element &key) const
+{
+    std::size_t k = lowerBoundPos(key);
+
+    // нижняя грань не меньше key; эквивалентна, если и не больше
+    if (k && !_compar(key, _data[k]))
+        return _data + k;
+    return nullptr;
+}
+
+
+} // namespace xi
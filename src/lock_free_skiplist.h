@@ -0,0 +1,176 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Неблокирующий упорядоченный список с пропусками (skip list)
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Альтернатива \c RBTree для разделяемых кэшей, которые в основном читают.
+/// Мелкозернистая блокировка вращений красно-черного дерева трудна, а список
+/// с пропусками меняется локально: вставка — это CAS ссылок соседей, удаление —
+/// пометка ссылок узла и их последующее "вырезание" любым проходящим потоком
+/// (алгоритм Херлихи — Шавита). Ни одна операция не берет блокировок; поиск
+/// не пишет в разделяемую память вообще.
+///
+/// Узлы, вырезанные из списка, освобождаются через \c EpochManager: каждая операция
+/// выполняется под \c EpochManager::ReaderGuard.
+///
+/// "Реализация" соответствующих методов располагается в файле lock_free_skiplist.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_LOCK_FREE_SKIPLIST_H_
+#define RBTREE_LOCK_FREE_SKIPLIST_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>       // std::less
+
+#include "epoch.h"
+
+
+namespace xi
+{
+
+
+/** \brief Неблокирующее упорядоченное множество на списке с пропусками.
+ *
+ *  Набор операций повторяет \c RBTree: \c insert() и \c remove() генерируют
+ *  \c std::invalid_argument на существующем / отсутствующем ключе, обход идет по
+ *  возрастанию. Поскольку "проверить, потом изменить" в конкурентной структуре
+ *  невозможно, есть и не генерирующие варианты \c tryInsert() / \c tryRemove().
+ *
+ *  Указателей на узлы наружу не отдается: узел может быть освобожден сразу после
+ *  выхода из операции, поэтому поиск возвращает копию элемента.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class LockFreeSkipList
+{
+public:
+    /** \brief Наибольшее число уровней: хватает на 2^32 элементов при вероятности уровня 1/2. */
+    static const int MAX_LEVEL = 32;
+
+public:
+    /** \brief Создает пустой список. */
+    LockFreeSkipList();
+
+    /** \brief Деструктор. Конкурентных операций к этому моменту быть не должно. */
+    ~LockFreeSkipList();
+
+public:
+    // Запись
+
+    /** \brief Вставляет \c key. Если он уже есть, генерирует \c std::invalid_argument. */
+    void insert(const Element &key);
+
+    /** \brief Удаляет \c key. Если его нет, генерирует \c std::invalid_argument. */
+    void remove(const Element &key);
+
+    /** \brief Вставляет \c key; возвращает ложь, если он уже был. */
+    bool tryInsert(const Element &key);
+
+    /** \brief Удаляет \c key; возвращает ложь, если его не было. */
+    bool tryRemove(const Element &key);
+
+public:
+    // Чтение
+
+    /** \brief Возвращает истину, если \c key есть в списке. */
+    bool contains(const Element &key) const;
+
+    /** \brief Находит наименьший элемент, не меньший \c key, и копирует его в \c out.
+     *
+     *  \returns Ложь, если такого нет.
+     */
+    bool lowerBound(const Element &key, Element &out) const;
+
+    /** \brief Вызывает \c fn для каждого элемента в порядке возрастания.
+     *
+     *  Обход не атомарен: элементы, вставленные или удаленные во время него, могут
+     *  как попасть, так и не попасть в обход.
+     */
+    template<typename F>
+    void forEach(F fn) const;
+
+    /** \brief Вызывает \c fn для каждого элемента из полуинтервала [\c lo, \c hi) в порядке возрастания. */
+    template<typename F>
+    void forEachInRange(const Element &lo, const Element &hi, F fn) const;
+
+    /** \brief Возвращает число элементов (при конкурентных изменениях — приблизительно). */
+    std::size_t getSize() const { return _size.load(std::memory_order_relaxed); }
+
+    /** \brief Возвращает истину, если список пуст. */
+    bool isEmpty() const { return getSize() == 0; }
+
+protected:
+    LockFreeSkipList(const LockFreeSkipList &);                 ///< КК не доступен.
+    LockFreeSkipList &operator=(const LockFreeSkipList &);      ///< Присваивание недоступно.
+
+protected:
+    /** \brief Ссылка на следующий узел; младший бит — пометка "узел, которому принадлежит
+     *  ссылка, удаляется".
+     */
+    typedef std::atomic<std::uintptr_t> Link;
+
+    /** \brief Узел: элемент и \c topLevel ссылок, лежащих сразу за структурой. */
+    struct alignas(Link) Node
+    {
+        Node(const Element &k, int top) : key(k), topLevel(top), owners(2) {}
+
+        /** \brief Возвращает массив ссылок узла. */
+        Link *next() { return reinterpret_cast<Link *>(this + 1); }
+
+        Element key;                            ///< Элемент.
+        int topLevel;                           ///< Число уровней, на которых стоит узел.
+
+        /** \brief Сколько участников еще могут работать со ссылками узла: вставляющий
+         *  (пока связывает верхние уровни) и список (пока узел не удален). Последний
+         *  из них передает узел на освобождение.
+         */
+        std::atomic<int> owners;
+    };
+
+    /** \brief Создает узел с \c top уровнями. */
+    static Node *createNode(const Element &key, int top);
+
+    /** \brief Разрушает и освобождает узел (функция освобождения для \c EpochManager). */
+    static void destroyNode(void *nd);
+
+    /** \brief Передает узел на освобождение, если \c nd был его последним участником. */
+    void release(Node *nd);
+
+    /** \brief Возвращает ссылки узла \c pred; \c nullptr — голова списка. */
+    Link *linksOf(Node *pred) const { return pred ? pred->next() : _head; }
+
+    static Node *ptrOf(std::uintptr_t link) { return reinterpret_cast<Node *>(link & ~std::uintptr_t(1)); }
+    static bool isMarked(std::uintptr_t link) { return (link & 1) != 0; }
+    static std::uintptr_t linkTo(const Node *nd) { return reinterpret_cast<std::uintptr_t>(nd); }
+
+    /** \brief Ищет \c key, заполняя на каждом уровне последний меньший узел \c preds
+     *  и следующий за ним \c succs; попутно вырезает помеченные узлы.
+     *
+     *  \returns Истину, если \c succs[0] эквивалентен \c key.
+     */
+    bool find(const Element &key, Node **preds, Node **succs);
+
+    /** \brief Спускается к первому непомеченному узлу, не меньшему \c key, ничего не меняя. */
+    Node *lowerBoundNode(const Element &key) const;
+
+    /** \brief Возвращает случайное число уровней нового узла: уровень k — с вероятностью 2^-k. */
+    static int randomLevel();
+
+protected:
+    mutable Link _head[MAX_LEVEL];              ///< Ссылки головы списка.
+    std::atomic<std::size_t> _size;             ///< Число элементов.
+    mutable EpochManager _epochs;               ///< Отложенное освобождение вырезанных узлов.
+    Compar _compar;                             ///< Компаратор.
+}; // class LockFreeSkipList
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "lock_free_skiplist.hpp"
+
+#endif // RBTREE_LOCK_FREE_SKIPLIST_H_
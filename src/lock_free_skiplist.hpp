@@ -0,0 +1,336 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация неблокирующего списка с пропусками
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле lock_free_skiplist.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <new>              // placement new
+#include <stdexcept>        // std::invalid_argument
+#include <thread>
+
+
+namespace xi
+{
+
+
+template<typename Element, typename Compar>
+LockFreeSkipList<Element, Compar>::LockFreeSkipList()
+        : _size(0)
+{
+    for (int i = 0; i < MAX_LEVEL; ++i)
+        _head[i].store(0);
+}
+
+
+template<typename Element, typename Compar>
+LockFreeSkipList<Element, Compar>::~LockFreeSkipList()
+{
+    // в нижнем уровне лежат ровно неудаленные узлы; удаленные уже отданы _epochs
+    Node *nd = ptrOf(_head[0].load());
+    while (nd)
+    {
+        Node *next = ptrOf(nd->next()[0].load());
+        destroyNode(nd);
+        nd = next;
+    }
+}
+
+
+template<typename Element, typename Compar>
+typename LockFreeSkipList<Element, Compar>::Node *
+LockFreeSkipList<Element, Compar>::createNode(const Element &key, int top)
+{
+    void *mem = ::operator new(sizeof(Node) + top * sizeof(Link));
+    Node *nd;
+    try
+    {
+        nd = new (mem) Node(key, top);
+    }
+    catch (...)
+    {
+        ::operator delete(mem);
+        throw;
+    }
+
+    for (int i = 0; i < top; ++i)
+        new (nd->next() + i) Link(0);
+    return nd;
+}
+
+
+template<typename Element, typename Compar>
+void LockFreeSkipList<Element, Compar>::destroyNode(void *p)
+{
+    Node *nd = static_cast<Node *>(p);
+    nd->~Node();                                // ссылки тривиально разрушаемы
+    ::operator delete(p);
+}
+
+
+template<typename Element, typename Compar>
+void LockFreeSkipList<Element, Compar>::release(Node *nd)
+{
+    if (nd->owners.fetch_sub(1) == 1)
+        _epochs.retire(nd, &destroyNode);
+}
+
+
+template<typename Element, typename Compar>
+int LockFreeSkipList<Element, Compar>::randomLevel()
+{
+    // xorshift на поток: общий генератор был бы разделяемой точкой записи
+    thread_local std::uint64_t state =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ULL + 1;
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    std::uint64_t bits = state * 0x2545F4914F6CDD1DULL;
+
+    int level = 1;
+    while ((bits & 1) && level < MAX_LEVEL)
+    {
+        ++level;
+        bits >>= 1;
+    }
+    return level;
+}
+
+
+template<typename Element, typename Compar>
+bool LockFreeSkipList<Element, Compar>::find(const Element &key, Node **preds, Node **succs)
+{
+retry:
+    Node *pred = nullptr;
+    Node *curr = nullptr;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level)
+    {
+        curr = ptrOf(linksOf(pred)[level].load());
+        while (curr)
+        {
+            std::uintptr_t succ = curr->next()[level].load();
+
+            // curr удаляется — вырезаем его на этом уровне; не вышло — перед нами все поменялось
+            if (isMarked(succ))
+            {
+                std::uintptr_t expected = linkTo(curr);
+                if (!linksOf(pred)[level].compare_exchange_strong(expected, linkTo(ptrOf(succ))))
+                    goto retry;
+                curr = ptrOf(succ);
+                continue;
+            }
+
+            if (!_compar(curr->key, key))
+                break;
+            pred = curr;
+            curr = ptrOf(succ);
+        }
+
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+
+    return curr && !_compar(key, curr->key);
+}
+
+
+template<typename Element, typename Compar>
+typename LockFreeSkipList<Element, Compar>::Node *
+LockFreeSkipList<Element, Compar>::lowerBoundNode(const Element &key) const
+{
+    // как find(), но помеченные узлы только пропускаются: читатель ничего не пишет
+    Node *pred = nullptr;
+    Node *curr = nullptr;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level)
+    {
+        curr = ptrOf(linksOf(pred)[level].load());
+        while (curr)
+        {
+            std::uintptr_t succ = curr->next()[level].load();
+            if (isMarked(succ))
+            {
+                curr = ptrOf(succ);
+                continue;
+            }
+
+            if (!_compar(curr->key, key))
+                break;
+            pred = curr;
+            curr = ptrOf(succ);
+        }
+    }
+
+    return curr;
+}
+
+
+template<typename Element, typename Compar>
+bool LockFreeSkipList<Element, Compar>::tryInsert(const Element &key)
+{
+    int top = randomLevel();
+    Node *preds[MAX_LEVEL];
+    Node *succs[MAX_LEVEL];
+    Node *nd = nullptr;
+
+    EpochManager::ReaderGuard guard(_epochs);
+    for (;;)
+    {
+        if (find(key, preds, succs))
+        {
+            if (nd)
+                destroyNode(nd);                // узел никому не был виден
+            return false;
+        }
+
+        if (!nd)
+            nd = createNode(key, top);
+        for (int i = 0; i < top; ++i)
+            nd->next()[i].store(linkTo(succs[i]));
+
+        // точка линеаризации — появление в нижнем уровне
+        std::uintptr_t expected = linkTo(succs[0]);
+        if (linksOf(preds[0])[0].compare_exchange_strong(expected, linkTo(nd)))
+            break;
+    }
+    _size.fetch_add(1, std::memory_order_relaxed);
+
+    // верхние уровни — вспомогательные; если узел тем временем начали удалять, бросаем
+    for (int level = 1; level < top; ++level)
+    {
+        for (;;)
+        {
+            std::uintptr_t next = nd->next()[level].load();
+            if (isMarked(next))
+                goto linked;
+            if (ptrOf(next) != succs[level] &&
+                !nd->next()[level].compare_exchange_strong(next, linkTo(succs[level])))
+                continue;                       // ссылку пометил удаляющий — проверим снова
+
+            std::uintptr_t expected = linkTo(succs[level]);
+            if (linksOf(preds[level])[level].compare_exchange_strong(expected, linkTo(nd)))
+                break;
+
+            find(key, preds, succs);
+            if (succs[0] != nd)
+                goto linked;                    // узел уже удален
+        }
+    }
+
+linked:
+    // если удаление прошло, пока мы связывали, поздние ссылки на узел надо вырезать самим
+    if (isMarked(nd->next()[0].load()))
+        find(key, preds, succs);
+    release(nd);
+    return true;
+}
+
+
+template<typename Element, typename Compar>
+bool LockFreeSkipList<Element, Compar>::tryRemove(const Element &key)
+{
+    Node *preds[MAX_LEVEL];
+    Node *succs[MAX_LEVEL];
+
+    EpochManager::ReaderGuard guard(_epochs);
+    if (!find(key, preds, succs))
+        return false;
+    Node *nd = succs[0];
+
+    // помечаем ссылки сверху вниз: после пометки ссылки уровня на ней ничего не вставить
+    for (int level = nd->topLevel - 1; level >= 1; --level)
+    {
+        std::uintptr_t next = nd->next()[level].load();
+        while (!isMarked(next))
+            nd->next()[level].compare_exchange_weak(next, next | 1);
+    }
+
+    // точка линеаризации — пометка нижней ссылки; кто ее поставил, тот и удалил
+    std::uintptr_t next = nd->next()[0].load();
+    for (;;)
+    {
+        if (isMarked(next))
+            return false;                       // опередил другой удаляющий
+        if (nd->next()[0].compare_exchange_weak(next, next | 1))
+            break;
+    }
+    _size.fetch_sub(1, std::memory_order_relaxed);
+
+    // вырезаем узел со всех уровней
+    find(key, preds, succs);
+    release(nd);
+    return true;
+}
+
+
+template<typename Element, typename Compar>
+void LockFreeSkipList<Element, Compar>::insert(const Element &key)
+{
+    if (!tryInsert(key))
+        throw std::invalid_argument("Key already exists");
+}
+
+
+template<typename Element, typename Compar>
+void LockFreeSkipList<Element, Compar>::remove(const Element &key)
+{
+    if (!tryRemove(key))
+        throw std::invalid_argument("Key not find");
+}
+
+
+template<typename Element, typename Compar>
+bool LockFreeSkipList<Element, Compar>::contains(const Element &key) const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    Node *nd = lowerBoundNode(key);
+    return nd && !_compar(key, nd->key);
+}
+
+
+template<typename Element, typename Compar>
+bool LockFreeSkipList<Element, Compar>::lowerBound(const Element &key, Element &out) const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    Node *nd = lowerBoundNode(key);
+    if (!nd)
+        return false;
+
+    out = nd->key;
+    return true;
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void LockFreeSkipList<Element, Compar>::forEach(F fn) const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    for (Node *nd = ptrOf(_head[0].load()); nd; )
+    {
+        std::uintptr_t next = nd->next()[0].load();
+        if (!isMarked(next))
+            fn(nd->key);
+        nd = ptrOf(next);
+    }
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void LockFreeSkipList<Element, Compar>::forEachInRange(const Element &lo, const Element &hi, F fn) const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    for (Node *nd = lowerBoundNode(lo); nd && _compar(nd->key, hi); )
+    {
+        std::uintptr_t next = nd->next()[0].load();
+        if (!isMarked(next))
+            fn(nd->key);
+        nd = ptrOf(next);
+    }
+}
+
+
+} // namespace xi
@@ -0,0 +1,167 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Неизменяемое множество, отображаемое из файла в память
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Файловый вариант \c FrozenRBSet для больших справочных множеств. Раскладка
+/// Эйтцингера не содержит указателей — потомки позиции k лежат в позициях 2k и 2k+1, —
+/// поэтому массив ключей пишется на диск как есть, а при открытии файл просто
+/// отображается в память (\c mmap): открытие стоит O(1) независимо от размера, страницы
+/// подгружаются по мере обращения, а страничный кэш делится всеми процессами,
+/// открывшими тот же файл.
+///
+/// Формат файла:
+///   - заголовок (64 байта): сигнатура "RBM1", версия формата, размер элемента,
+///     метка порядка байтов, число элементов, смещение массива;
+///   - массив из (n + 1) элементов в раскладке Эйтцингера; позиция 0 фиктивная
+///     и заполнена нулями. Массив начинается на границе кэш-линии.
+/// Элементы и поля заголовка хранятся в порядке байтов записавшей машины; файл,
+/// записанный на машине с другим порядком, при открытии отвергается.
+///
+/// "Реализация" соответствующих методов располагается в файле mapped_rbset.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_MAPPED_RBSET_H_
+#define RBTREE_MAPPED_RBSET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>       // std::less
+#include <string>
+#include <type_traits>      // std::is_trivially_copyable
+
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+
+/** \brief Неизменяемое упорядоченное множество поверх отображенного в память файла.
+ *
+ *  Файл создается статическим \c write() или функцией \c writeMapped() и открывается
+ *  конструктором. Поиск возвращает указатели прямо в отображение; они действительны,
+ *  пока жив объект. Ошибки ввода-вывода и неверный формат файла сообщаются
+ *  исключением \c std::runtime_error.
+ *
+ *  \tparam Element Тривиально копируемый тип элементов: они читаются из файла без
+ *  конструирования.
+ *  \tparam Compar Функтор сравнения; в файле он не записывается, открывать файл нужно
+ *  с тем же, с которым он был записан.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class MappedRBSet
+{
+public:
+    static_assert(std::is_trivially_copyable<Element>::value,
+                  "MappedRBSet requires trivially copyable elements");
+
+    /** \brief Размер заголовка; он же — смещение массива элементов в файле. */
+    static const std::size_t HEADER_SIZE = 64;
+
+    /** \brief Версия формата. */
+    static const std::uint32_t FORMAT_VERSION = 1;
+
+public:
+    /** \brief Создает пустое множество, не связанное с файлом. */
+    MappedRBSet();
+
+    /** \brief Отображает в память файл \c path только для чтения. */
+    explicit MappedRBSet(const std::string &path);
+
+    MappedRBSet(MappedRBSet &&other);               ///< Перемещающий конструктор.
+    MappedRBSet &operator=(MappedRBSet &&other);    ///< Перемещающее присваивание.
+
+    ~MappedRBSet();                                 ///< Деструктор. Снимает отображение.
+
+public:
+    /** \brief Записывает в файл \c path множество из \c n элементов, перечисляемых
+     *  итератором \c first в строго возрастающем порядке.
+     *
+     *  Файл собирается во временном файле рядом (\c path + ".tmp"), который после
+     *  сброса на диск переименовывается в \c path: открывающие \c path никогда не видят
+     *  недописанный файл.
+     */
+    template<typename InputIt>
+    static void write(const std::string &path, InputIt first, std::size_t n);
+
+public:
+    /** \brief Возвращает истину, если \c key содержится в множестве. */
+    bool contains(const Element &key) const { return find(key) != nullptr; }
+
+    /** \brief Возвращает указатель на элемент, эквивалентный \c key, либо \c nullptr. */
+    const Element *find(const Element &key) const;
+
+    /** \brief Возвращает указатель на наименьший элемент, не меньший \c key, либо \c nullptr. */
+    const Element *lowerBound(const Element &key) const;
+
+    /** \brief Вызывает \c fn для каждого элемента в порядке возрастания. */
+    template<typename F>
+    void forEach(F fn) const;
+
+    /** \brief Вызывает \c fn для каждого элемента из полуинтервала [\c lo, \c hi) в порядке возрастания. */
+    template<typename F>
+    void forEachInRange(const Element &lo, const Element &hi, F fn) const;
+
+    /** \brief Возвращает число элементов. */
+    std::size_t getSize() const { return _size; }
+
+    /** \brief Возвращает истину, если множество пусто. */
+    bool isEmpty() const { return _size == 0; }
+
+protected:
+    MappedRBSet(const MappedRBSet &);               ///< КК не доступен.
+    MappedRBSet &operator=(const MappedRBSet &);    ///< Оператор присваивания недоступен.
+
+protected:
+    /** \brief Заголовок файла. */
+    struct Header
+    {
+        char signature[4];                      ///< "RBM1".
+        std::uint32_t version;                  ///< Версия формата.
+        std::uint32_t elementSize;              ///< sizeof(Element) записавшей программы.
+        std::uint32_t byteOrder;                ///< \c BYTE_ORDER_MARK в порядке байтов записавшей машины.
+        std::uint64_t size;                     ///< Число элементов.
+        std::uint64_t dataOffset;               ///< Смещение массива от начала файла.
+    };
+
+    /** \brief Метка порядка байтов. */
+    static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    /** \brief Рекурсивно раскладывает очередные элементы \c it по поддереву позиции \c k. */
+    template<typename InputIt>
+    static void fill(Element *data, std::size_t n, std::size_t k, InputIt &it);
+
+    /** \brief Возвращает позицию (с единицы) нижней грани \c key, 0 — если ее нет. */
+    std::size_t lowerBoundPos(const Element &key) const;
+
+    /** \brief Возвращает позицию наименьшего элемента, 0 — если множество пусто. */
+    std::size_t firstPos() const;
+
+    /** \brief Снимает отображение. */
+    void release();
+
+protected:
+    Compar _compar;                             ///< Компаратор сравнения двух элементов.
+
+    void *_map;                                 ///< Начало отображения.
+    std::size_t _mapSize;                       ///< Длина отображения.
+    const Element *_data;                       ///< Массив с нулевой фиктивной позицией: элементы в [1.._size].
+    std::size_t _size;                          ///< Число элементов.
+}; // class MappedRBSet
+
+
+/** \brief Записывает дерево в файл \c path в формате \c MappedRBSet. */
+template<typename Element, typename Compar>
+void writeMapped(const RBTree<Element, Compar> &tree, const std::string &path);
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "mapped_rbset.hpp"
+
+#endif // RBTREE_MAPPED_RBSET_H_
@@ -0,0 +1,523 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация множества, отображаемого из файла в память
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле mapped_rbset.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cerrno>
+#include <cstdio>           // std::remove
+#include <cstring>          // std::memcpy, std::memcmp, std::strerror
+#include <stdexcept>        // std::runtime_error
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace xi
+{
+
+/** \brief Отображение файлов в память: тонкая обертка над mmap / MapViewOfFile. */
+namespace mapped
+{
+
+/** \brief Генерирует \c std::runtime_error с описанием последней системной ошибки. */
+[[noreturn]] inline void fail(const char *what, const std::string &path)
+{
+#if defined(_WIN32)
+    std::string reason = "system error " + std::to_string(::GetLastError());
+#else
+    std::string reason = std::strerror(errno);
+#endif
+    throw std::runtime_error(std::string(what) + " '" + path + "': " + reason);
+}
+
+
+/** \brief Отображает файл \c path целиком только для чтения; длину кладет в \c size.
+ *
+ *  Файл короче \c minSize не отображается (пустой файл отобразить и нельзя).
+ */
+inline void *mapRead(const std::string &path, std::size_t minSize, std::size_t &size)
+{
+#if defined(_WIN32)
+    HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        fail("Cannot open", path);
+
+    LARGE_INTEGER len;
+    if (!::GetFileSizeEx(file, &len))
+    {
+        ::CloseHandle(file);
+        fail("Cannot stat", path);
+    }
+    if (static_cast<std::uint64_t>(len.QuadPart) < minSize)
+    {
+        ::CloseHandle(file);
+        throw std::runtime_error("File '" + path + "' is too short");
+    }
+
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *addr = mapping ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+    // отображение держит файл само
+    if (mapping)
+        ::CloseHandle(mapping);
+    ::CloseHandle(file);
+    if (!addr)
+        fail("Cannot map", path);
+
+    size = static_cast<std::size_t>(len.QuadPart);
+    return addr;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        fail("Cannot open", path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        fail("Cannot stat", path);
+    }
+    if (static_cast<std::uint64_t>(st.st_size) < minSize)
+    {
+        ::close(fd);
+        throw std::runtime_error("File '" + path + "' is too short");
+    }
+
+    void *addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);                                // отображение держит файл само
+    if (addr == MAP_FAILED)
+    {
+        errno = err;
+        fail("Cannot map", path);
+    }
+
+    size = static_cast<std::size_t>(st.st_size);
+    return addr;
+#endif
+}
+
+
+/** \brief Снимает отображение, созданное \c mapRead() или \c WritableFile. */
+inline void unmap(void *addr, std::size_t size)
+{
+    if (!addr)
+        return;
+#if defined(_WIN32)
+    (void)size;
+    ::UnmapViewOfFile(addr);
+#else
+    ::munmap(addr, size);
+#endif
+}
+
+
+/** \brief Новый файл заданной длины, отображенный в память для записи.
+ *
+ *  Пишется во временный файл \c path + ".tmp"; \c commit() сбрасывает его на диск
+ *  и атомарно переименовывает в \c path. Без \c commit() деструктор удаляет
+ *  временный файл.
+ */
+class WritableFile
+{
+public:
+    WritableFile(const std::string &path, std::size_t size)
+            : _path(path)
+            , _tmpPath(path + ".tmp")
+            , _addr(nullptr)
+            , _size(size)
+#if defined(_WIN32)
+            , _file(INVALID_HANDLE_VALUE)
+            , _mapping(nullptr)
+#else
+            , _fd(-1)
+#endif
+    {
+#if defined(_WIN32)
+        _file = ::CreateFileA(_tmpPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE)
+            fail("Cannot create", _tmpPath);
+
+        // отображение длиннее файла растягивает файл
+        std::uint64_t len = size;
+        _mapping = ::CreateFileMappingA(_file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(len >> 32), static_cast<DWORD>(len), nullptr);
+        if (_mapping)
+            _addr = ::MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, size);
+        if (!_addr)
+        {
+            abandon();
+            fail("Cannot map", _tmpPath);
+        }
+#else
+        _fd = ::open(_tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (_fd < 0)
+            fail("Cannot create", _tmpPath);
+
+        // место выделяем сразу: запись в отображение "дырявого" файла на заполненном
+        // диске завершилась бы сигналом, а не ошибкой
+#if defined(__linux__)
+        int err = ::posix_fallocate(_fd, 0, static_cast<off_t>(size));
+        if (err != 0)
+            errno = err;
+#else
+        int err = ::ftruncate(_fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+#endif
+        if (err == 0)
+        {
+            _addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+            if (_addr == MAP_FAILED)
+                _addr = nullptr;
+        }
+        if (!_addr)
+        {
+            err = errno;
+            abandon();
+            errno = err;
+            fail("Cannot map", _tmpPath);
+        }
+#endif
+    }
+
+    ~WritableFile()
+    {
+        abandon();
+    }
+
+    /** \brief Возвращает начало отображения. */
+    char *data() { return static_cast<char *>(_addr); }
+
+    /** \brief Сбрасывает файл на диск и переименовывает его в целевой. */
+    void commit()
+    {
+#if defined(_WIN32)
+        bool ok = ::FlushViewOfFile(_addr, 0) != 0;
+        ::UnmapViewOfFile(_addr);
+        _addr = nullptr;
+        ::CloseHandle(_mapping);
+        _mapping = nullptr;
+        ok = ok && ::FlushFileBuffers(_file) != 0;
+        ::CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+        if (!ok)
+        {
+            abandon();
+            fail("Cannot flush", _tmpPath);
+        }
+        if (!::MoveFileExA(_tmpPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            abandon();
+            fail("Cannot rename to", _path);
+        }
+#else
+        bool ok = ::msync(_addr, _size, MS_SYNC) == 0;
+        ::munmap(_addr, _size);
+        _addr = nullptr;
+        ok = ok && ::fsync(_fd) == 0;
+        ok = (::close(_fd) == 0) && ok;
+        _fd = -1;
+        if (!ok)
+        {
+            int err = errno;
+            abandon();
+            errno = err;
+            fail("Cannot flush", _tmpPath);
+        }
+        if (::rename(_tmpPath.c_str(), _path.c_str()) != 0)
+        {
+            int err = errno;
+            abandon();
+            errno = err;
+            fail("Cannot rename to", _path);
+        }
+#endif
+        _tmpPath.clear();
+    }
+
+protected:
+    WritableFile(const WritableFile &);                 ///< КК не доступен.
+    WritableFile &operator=(const WritableFile &);      ///< Присваивание недоступно.
+
+    /** \brief Освобождает все ресурсы и удаляет временный файл, если он еще есть. */
+    void abandon()
+    {
+#if defined(_WIN32)
+        if (_addr)
+            ::UnmapViewOfFile(_addr);
+        if (_mapping)
+            ::CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE)
+            ::CloseHandle(_file);
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_addr)
+            ::munmap(_addr, _size);
+        if (_fd >= 0)
+            ::close(_fd);
+        _fd = -1;
+#endif
+        _addr = nullptr;
+        if (!_tmpPath.empty())
+            std::remove(_tmpPath.c_str());
+        _tmpPath.clear();
+    }
+
+protected:
+    std::string _path;                          ///< Целевой файл.
+    std::string _tmpPath;                       ///< Временный файл; пусто — его уже нет.
+    void *_addr;                                ///< Начало отображения.
+    std::size_t _size;                          ///< Длина файла.
+#if defined(_WIN32)
+    HANDLE _file;                               ///< Временный файл.
+    HANDLE _mapping;                            ///< Объект отображения.
+#else
+    int _fd;                                    ///< Временный файл.
+#endif
+}; // class WritableFile
+
+} // namespace mapped
+
+
+//==============================================================================
+// class MappedRBSet
+//==============================================================================
+
+template<typename Element, typename Compar>
+MappedRBSet<Element, Compar>::MappedRBSet()
+        : _map(nullptr)
+        , _mapSize(0)
+        , _data(nullptr)
+        , _size(0)
+{
+}
+
+
+template<typename Element, typename Compar>
+MappedRBSet<Element, Compar>::MappedRBSet(const std::string &path)
+        : _map(nullptr)
+        , _mapSize(0)
+        , _data(nullptr)
+        , _size(0)
+{
+    _map = mapped::mapRead(path, HEADER_SIZE, _mapSize);
+
+    Header h;
+    std::memcpy(&h, _map, sizeof(Header));
+
+    const char *error = nullptr;
+    if (std::memcmp(h.signature, "RBM1", 4) != 0)
+        error = "bad signature";
+    else if (h.byteOrder != BYTE_ORDER_MARK)
+        error = "written on a machine with different byte order";
+    else if (h.version != FORMAT_VERSION)
+        error = "unsupported format version";
+    else if (h.elementSize != sizeof(Element))
+        error = "element size mismatch";
+    else if (h.dataOffset < sizeof(Header) || h.dataOffset % alignof(Element) != 0 || h.dataOffset > _mapSize)
+        error = "bad data offset";
+    else if (h.size > 0 && (_mapSize - h.dataOffset) / sizeof(Element) <= h.size)
+        error = "file is truncated";
+
+    if (error)
+    {
+        release();
+        throw std::runtime_error("File '" + path + "': " + error);
+    }
+
+    _data = reinterpret_cast<const Element *>(static_cast<const char *>(_map) + h.dataOffset);
+    _size = static_cast<std::size_t>(h.size);
+}
+
+
+template<typename Element, typename Compar>
+MappedRBSet<Element, Compar>::MappedRBSet(MappedRBSet &&other)
+        : _compar(other._compar)
+        , _map(other._map)
+        , _mapSize(other._mapSize)
+        , _data(other._data)
+        , _size(other._size)
+{
+    other._map = nullptr;
+    other._mapSize = 0;
+    other._data = nullptr;
+    other._size = 0;
+}
+
+
+template<typename Element, typename Compar>
+MappedRBSet<Element, Compar> &MappedRBSet<Element, Compar>::operator=(MappedRBSet &&other)
+{
+    if (this == &other)
+        return *this;
+
+    release();
+
+    _compar = other._compar;
+    _map = other._map;
+    _mapSize = other._mapSize;
+    _data = other._data;
+    _size = other._size;
+
+    other._map = nullptr;
+    other._mapSize = 0;
+    other._data = nullptr;
+    other._size = 0;
+
+    return *this;
+}
+
+
+template<typename Element, typename Compar>
+MappedRBSet<Element, Compar>::~MappedRBSet()
+{
+    release();
+}
+
+
+template<typename Element, typename Compar>
+void MappedRBSet<Element, Compar>::release()
+{
+    mapped::unmap(_map, _mapSize);
+    _map = nullptr;
+    _mapSize = 0;
+    _data = nullptr;
+    _size = 0;
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void MappedRBSet<Element, Compar>::write(const std::string &path, InputIt first, std::size_t n)
+{
+    static_assert(alignof(Element) <= HEADER_SIZE, "Element alignment exceeds the header size");
+
+    std::size_t fileSize = HEADER_SIZE + (n ? (n + 1) * sizeof(Element) : 0);
+    mapped::WritableFile file(path, fileSize);
+
+    // файл создан выделенным, но не обязательно обнуленным (заголовок и позиция 0)
+    std::memset(file.data(), 0, HEADER_SIZE + (n ? sizeof(Element) : 0));
+
+    if (n)
+        fill(reinterpret_cast<Element *>(file.data() + HEADER_SIZE), n, 1, first);
+
+    Header h;
+    std::memset(&h, 0, sizeof(Header));
+    std::memcpy(h.signature, "RBM1", 4);
+    h.version = FORMAT_VERSION;
+    h.elementSize = sizeof(Element);
+    h.byteOrder = BYTE_ORDER_MARK;
+    h.size = n;
+    h.dataOffset = HEADER_SIZE;
+    std::memcpy(file.data(), &h, sizeof(Header));
+
+    file.commit();
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void MappedRBSet<Element, Compar>::fill(Element *data, std::size_t n, std::size_t k, InputIt &it)
+{
+    if (k > n)
+        return;
+
+    // симметричный порядок обхода позиций совпадает с порядком возрастания ключей
+    fill(data, n, 2 * k, it);
+    const Element &el = *it;
+    std::memcpy(static_cast<void *>(data + k), &el, sizeof(Element));
+    ++it;
+    fill(data, n, 2 * k + 1, it);
+}
+
+
+template<typename Element, typename Compar>
+std::size_t MappedRBSet<Element, Compar>::lowerBoundPos(const Element &key) const
+{
+    return eytzinger::lowerBoundPos(_data, _size, _compar, key);
+}
+
+
+template<typename Element, typename Compar>
+std::size_t MappedRBSet<Element, Compar>::firstPos() const
+{
+    if (_size == 0)
+        return 0;
+
+    std::size_t k = 1;
+    while (2 * k <= _size)
+        k = 2 * k;
+    return k;
+}
+
+
+template<typename Element, typename Compar>
+const Element *MappedRBSet<Element, Compar>::lowerBound(const Element &key) const
+{
+    std::size_t k = lowerBoundPos(key);
+    return k ? _data + k : nullptr;
+}
+
+
+template<typename Element, typename Compar>
+const Element *MappedRBSet<Element, Compar>::find(const Element &key) const
+{
+    std::size_t k = lowerBoundPos(key);
+
+    // нижняя грань не меньше key; эквивалентна, если и не больше
+    if (k && !_compar(key, _data[k]))
+        return _data + k;
+    return nullptr;
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void MappedRBSet<Element, Compar>::forEach(F fn) const
+{
+    for (std::size_t k = firstPos(); k; k = eytzinger::nextPos(k, _size))
+        fn(_data[k]);
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void MappedRBSet<Element, Compar>::forEachInRange(const Element &lo, const Element &hi, F fn) const
+{
+    for (std::size_t k = lowerBoundPos(lo); k && _compar(_data[k], hi); k = eytzinger::nextPos(k, _size))
+        fn(_data[k]);
+}
+
+
+//==============================================================================
+
+template<typename Element, typename Compar>
+void writeMapped(const RBTree<Element, Compar> &tree, const std::string &path)
+{
+    std::size_t n = 0;
+    for (typename RBTree<Element, Compar>::ConstIterator it = tree.begin(); it != tree.end(); ++it)
+        ++n;
+
+    MappedRBSet<Element, Compar>::write(path, tree.begin(), n);
+}
+
+
+} // namespace xi
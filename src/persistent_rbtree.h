@@ -0,0 +1,211 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Персистентное (с копированием пути) красно-черное дерево
+///            со снимками за O(1)
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Узлы неизменяемы. Вставка и удаление копируют только путь от корня до места
+/// изменения (O(log n) узлов), все остальные поддеревья разделяются между старой
+/// и новой версиями и освобождаются по счетчику ссылок, когда не нужны ни одной
+/// версии. Корень текущей версии публикуется атомарно, поэтому читатель берет
+/// согласованный снимок одной атомарной загрузкой и дальше работает с ним,
+/// никак не мешая писателю.
+///
+/// Связи с родителем у таких узлов быть не может: она привязала бы общий узел
+/// к одной версии и заставила бы копировать все дерево. Поэтому вместо
+/// \c rotLeft / \c rotRight изменяемого дерева перебалансировка выражена функционально
+/// (вариант Окасаки для вставки и Карса для удаления): каждый шаг строит новые узлы
+/// из старых поддеревьев.
+///
+/// "Реализация" соответствующих методов располагается в файле persistent_rbtree.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_PERSISTENT_RBTREE_H_
+#define RBTREE_PERSISTENT_RBTREE_H_
+
+#include <cstddef>
+#include <functional>       // std::less
+#include <memory>           // std::shared_ptr
+#include <mutex>
+
+
+namespace xi
+{
+
+
+/** \brief Персистентное красно-черное дерево.
+ *
+ *  Писатели (\c insert, \c remove) сериализуются внутренним мьютексом; читатели
+ *  берут \c snapshot() и работают с ним без блокировок сколь угодно долго.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class PersistentRBTree
+{
+public:
+    /** \brief Тип цвета узла дерева. */
+    enum Color
+    {
+        BLACK,
+        RED
+    };
+
+    class Node;
+
+    /** \brief Разделяемый указатель на неизменяемый узел. */
+    typedef std::shared_ptr<const Node> NodePtr;
+
+    /** \brief Неизменяемый узел. */
+    class Node
+    {
+    public:
+        Node(Color col, const NodePtr &left, const Element &key, const NodePtr &right)
+                : _key(key), _color(col), _left(left), _right(right)
+        {
+        }
+
+        /** \brief Возвращает ключ узла. */
+        const Element &getKey() const { return _key; }
+
+        /** \brief Возвращает цвет узла. */
+        Color getColor() const { return _color; }
+
+        /** \brief Возвращает левого потомка. */
+        const NodePtr &getLeft() const { return _left; }
+
+        /** \brief Возвращает правого потомка. */
+        const NodePtr &getRight() const { return _right; }
+
+    protected:
+        // Дерево конструирует узлы напрямую и читает поля без аксессоров.
+        friend class PersistentRBTree<Element, Compar>;
+
+        const Element _key;                     ///< Ключ.
+        const Color _color;                     ///< Цвет.
+        const NodePtr _left;                    ///< Левый потомок.
+        const NodePtr _right;                   ///< Правый потомок.
+    }; // class PersistentRBTree::Node
+
+
+    /** \brief Согласованный снимок дерева на момент вызова \c snapshot().
+     *
+     *  Снимок — это просто удерживаемый корень версии: копируется за O(1) и остается
+     *  действительным, сколько бы изменений ни сделал писатель после.
+     */
+    class Snapshot
+    {
+    public:
+        Snapshot() : _size(0) {}
+        Snapshot(const NodePtr &root, std::size_t size) : _root(root), _size(size) {}
+
+        /** \brief Возвращает узел с ключом, эквивалентным \c key, или \c nullptr. */
+        const Node *find(const Element &key) const;
+
+        /** \brief Возвращает истину, если \c key есть в снимке. */
+        bool contains(const Element &key) const { return find(key) != nullptr; }
+
+        /** \brief Вызывает \c fn для каждого элемента снимка в порядке возрастания. */
+        template<typename F>
+        void forEach(F fn) const;
+
+        /** \brief Возвращает число элементов. */
+        std::size_t getSize() const { return _size; }
+
+        /** \brief Возвращает истину, если снимок пуст. */
+        bool isEmpty() const { return !_root; }
+
+        /** \brief Возвращает корень снимка. */
+        const NodePtr &getRoot() const { return _root; }
+
+    protected:
+        NodePtr _root;                          ///< Корень версии.
+        std::size_t _size;                      ///< Число элементов версии.
+        Compar _compar;                         ///< Компаратор.
+    }; // class PersistentRBTree::Snapshot
+
+public:
+    PersistentRBTree();                         ///< Конструктор по умолчанию.
+
+public:
+    /** \brief Вставляет \c key. Возвращает ложь (и ничего не меняет), если ключ уже есть. */
+    bool insert(const Element &key);
+
+    /** \brief Удаляет \c key. Возвращает ложь (и ничего не меняет), если ключа нет. */
+    bool remove(const Element &key);
+
+    /** \brief Атомарно берет снимок текущей версии. Не блокирует ни писателя, ни других читателей. */
+    Snapshot snapshot() const;
+
+    /** \brief Возвращает истину, если \c key есть в текущей версии. */
+    bool contains(const Element &key) const { return snapshot().contains(key); }
+
+    /** \brief Заменяет содержимое дерева \c n элементами, перечисляемыми итератором \c first
+     *  в строго возрастающем порядке. Строит за O(n), без сравнений и перебалансировок.
+     */
+    template<typename InputIt>
+    void assignSorted(InputIt first, std::size_t n);
+
+protected:
+    PersistentRBTree(const PersistentRBTree &);                 ///< КК не доступен.
+    PersistentRBTree &operator=(const PersistentRBTree &);      ///< Присваивание недоступно.
+
+protected:
+    /** \brief Создает новый узел. */
+    static NodePtr make(Color col, const NodePtr &left, const Element &key, const NodePtr &right)
+    {
+        return std::make_shared<const Node>(col, left, key, right);
+    }
+
+    static bool isRed(const NodePtr &nd) { return nd && nd->_color == RED; }
+    static bool isBlack(const NodePtr &nd) { return nd && nd->_color == BLACK; }
+
+    /** \brief Возвращает копию \c nd, окрашенную в \c col (или сам \c nd, если цвет тот же). */
+    static NodePtr paint(const NodePtr &nd, Color col);
+
+    /** \brief Собирает черный узел (\c left, \c key, \c right), устраняя красно-красные нарушения
+     *  у одного из потомков.
+     */
+    static NodePtr balance(const NodePtr &left, const Element &key, const NodePtr &right);
+
+    /** \brief Рекурсивная часть вставки; \c inserted — была ли вставка. */
+    NodePtr ins(const NodePtr &nd, const Element &key, bool &inserted) const;
+
+    /** \brief Рекурсивная часть удаления; \c removed — было ли удаление. */
+    NodePtr del(const NodePtr &nd, const Element &key, bool &removed) const;
+
+    /** \brief Восстанавливает баланс, когда черная высота левого поддерева уменьшилась на единицу. */
+    static NodePtr balLeft(const NodePtr &left, const Element &key, const NodePtr &right);
+
+    /** \brief Восстанавливает баланс, когда черная высота правого поддерева уменьшилась на единицу. */
+    static NodePtr balRight(const NodePtr &left, const Element &key, const NodePtr &right);
+
+    /** \brief Сливает два поддерева одинаковой черной высоты, все ключи \c left меньше ключей \c right. */
+    static NodePtr fuse(const NodePtr &left, const NodePtr &right);
+
+    /** \brief Строит идеально сбалансированное поддерево из \c n очередных элементов \c it;
+     *  узлы на глубине \c redDepth красные.
+     */
+    template<typename InputIt>
+    static NodePtr build(InputIt &it, std::size_t n, int depth, int redDepth);
+
+    /** \brief Атомарно публикует новую версию. */
+    void publish(const NodePtr &root, std::size_t size);
+
+protected:
+    /** \brief Текущая версия: корень вместе с размером, чтобы читатель получал их согласованно
+     *  одной атомарной загрузкой. Доступ — только через \c std::atomic_load / \c std::atomic_store.
+     */
+    std::shared_ptr<const Snapshot> _current;
+    mutable std::mutex _writeLock;              ///< Сериализует писателей.
+    Compar _compar;                             ///< Компаратор.
+}; // class PersistentRBTree
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "persistent_rbtree.hpp"
+
+#endif // RBTREE_PERSISTENT_RBTREE_H_
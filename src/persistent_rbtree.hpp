@@ -0,0 +1,346 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация персистентного красно-черного дерева
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле persistent_rbtree.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>           // std::atomic_load / std::atomic_store для shared_ptr
+#include <vector>
+
+
+namespace xi
+{
+
+
+//==============================================================================
+// class PersistentRBTree::Snapshot
+//==============================================================================
+
+template<typename Element, typename Compar>
+const typename PersistentRBTree<Element, Compar>::Node *
+PersistentRBTree<Element, Compar>::Snapshot::find(const Element &key) const
+{
+    const Node *cur = _root.get();
+    while (cur)
+    {
+        if (_compar(key, cur->getKey()))
+            cur = cur->getLeft().get();
+        else if (_compar(cur->getKey(), key))
+            cur = cur->getRight().get();
+        else
+            return cur;
+    }
+
+    return nullptr;
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void PersistentRBTree<Element, Compar>::Snapshot::forEach(F fn) const
+{
+    // узлы неизменяемы, поэтому обход без родителей — через явный стек
+    std::vector<const Node *> stack;
+    const Node *cur = _root.get();
+    while (cur || !stack.empty())
+    {
+        while (cur)
+        {
+            stack.push_back(cur);
+            cur = cur->getLeft().get();
+        }
+
+        cur = stack.back();
+        stack.pop_back();
+        fn(cur->getKey());
+        cur = cur->getRight().get();
+    }
+}
+
+
+//==============================================================================
+// class PersistentRBTree
+//==============================================================================
+
+template<typename Element, typename Compar>
+PersistentRBTree<Element, Compar>::PersistentRBTree()
+        : _current(std::make_shared<const Snapshot>())
+{
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::Snapshot PersistentRBTree<Element, Compar>::snapshot() const
+{
+    return *std::atomic_load(&_current);
+}
+
+
+template<typename Element, typename Compar>
+void PersistentRBTree<Element, Compar>::publish(const NodePtr &root, std::size_t size)
+{
+    std::atomic_store(&_current, std::shared_ptr<const Snapshot>(std::make_shared<const Snapshot>(root, size)));
+}
+
+
+template<typename Element, typename Compar>
+bool PersistentRBTree<Element, Compar>::insert(const Element &key)
+{
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    // писатель один, поэтому текущую версию можно читать без атомарности
+    const Snapshot &cur = *_current;
+
+    bool inserted = false;
+    NodePtr root = ins(cur.getRoot(), key, inserted);
+    if (!inserted)
+        return false;
+
+    publish(paint(root, BLACK), cur.getSize() + 1);
+    return true;
+}
+
+
+template<typename Element, typename Compar>
+bool PersistentRBTree<Element, Compar>::remove(const Element &key)
+{
+    std::lock_guard<std::mutex> lock(_writeLock);
+
+    const Snapshot &cur = *_current;
+
+    // без ключа del() вернул бы путь с нарушенной черной высотой — его просто отбрасываем
+    bool removed = false;
+    NodePtr root = del(cur.getRoot(), key, removed);
+    if (!removed)
+        return false;
+
+    publish(paint(root, BLACK), cur.getSize() - 1);
+    return true;
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void PersistentRBTree<Element, Compar>::assignSorted(InputIt first, std::size_t n)
+{
+    // узлы на неполном нижнем уровне красные, все остальные — черные
+    int redDepth = 0;
+    while ((std::size_t(2) << redDepth) <= n + 1)
+        ++redDepth;
+
+    NodePtr root = build(first, n, 0, redDepth);
+
+    std::lock_guard<std::mutex> lock(_writeLock);
+    publish(root, n);
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::build(InputIt &it, std::size_t n, int depth, int redDepth)
+{
+    if (n == 0)
+        return NodePtr();
+
+    std::size_t leftN = (n - 1) / 2;
+    NodePtr left = build(it, leftN, depth + 1, redDepth);
+    Element key = *it;
+    ++it;
+    NodePtr right = build(it, n - 1 - leftN, depth + 1, redDepth);
+
+    return make(depth == redDepth ? RED : BLACK, left, key, right);
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::paint(const NodePtr &nd, Color col)
+{
+    if (!nd || nd->_color == col)
+        return nd;
+
+    return make(col, nd->_left, nd->_key, nd->_right);
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::balance(const NodePtr &left, const Element &key, const NodePtr &right)
+{
+    // Каждый случай — это пара поворотов изменяемого дерева (rotLeft/rotRight) вместе
+    // с перекраской, выраженные сборкой трех новых узлов из четырех старых поддеревьев.
+
+    // оба сына красные — перекраска
+    if (isRed(left) && isRed(right))
+        return make(RED, paint(left, BLACK), key, paint(right, BLACK));
+
+    if (isRed(left))
+    {
+        // левый-левый
+        if (isRed(left->_left))
+            return make(RED, paint(left->_left, BLACK), left->_key,
+                        make(BLACK, left->_right, key, right));
+
+        // левый-правый
+        if (isRed(left->_right))
+        {
+            const NodePtr &lr = left->_right;
+            return make(RED, make(BLACK, left->_left, left->_key, lr->_left), lr->_key,
+                        make(BLACK, lr->_right, key, right));
+        }
+    }
+
+    if (isRed(right))
+    {
+        // правый-правый
+        if (isRed(right->_right))
+            return make(RED, make(BLACK, left, key, right->_left), right->_key,
+                        paint(right->_right, BLACK));
+
+        // правый-левый
+        if (isRed(right->_left))
+        {
+            const NodePtr &rl = right->_left;
+            return make(RED, make(BLACK, left, key, rl->_left), rl->_key,
+                        make(BLACK, rl->_right, right->_key, right->_right));
+        }
+    }
+
+    return make(BLACK, left, key, right);
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::ins(const NodePtr &nd, const Element &key, bool &inserted) const
+{
+    if (!nd)
+    {
+        inserted = true;
+        return make(RED, NodePtr(), key, NodePtr());
+    }
+
+    if (_compar(key, nd->_key))
+    {
+        NodePtr left = ins(nd->_left, key, inserted);
+        if (!inserted)
+            return nd;
+        return nd->_color == BLACK ? balance(left, nd->_key, nd->_right)
+                                   : make(RED, left, nd->_key, nd->_right);
+    }
+
+    if (_compar(nd->_key, key))
+    {
+        NodePtr right = ins(nd->_right, key, inserted);
+        if (!inserted)
+            return nd;
+        return nd->_color == BLACK ? balance(nd->_left, nd->_key, right)
+                                   : make(RED, nd->_left, nd->_key, right);
+    }
+
+    // такой ключ уже есть: версия не меняется
+    return nd;
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::del(const NodePtr &nd, const Element &key, bool &removed) const
+{
+    if (!nd)
+        return nd;
+
+    if (_compar(key, nd->_key))
+    {
+        // из черного поддерева удаление уносит один черный уровень
+        NodePtr left = del(nd->_left, key, removed);
+        return isBlack(nd->_left) ? balLeft(left, nd->_key, nd->_right)
+                                  : make(RED, left, nd->_key, nd->_right);
+    }
+
+    if (_compar(nd->_key, key))
+    {
+        NodePtr right = del(nd->_right, key, removed);
+        return isBlack(nd->_right) ? balRight(nd->_left, nd->_key, right)
+                                   : make(RED, nd->_left, nd->_key, right);
+    }
+
+    removed = true;
+    return fuse(nd->_left, nd->_right);
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::balLeft(const NodePtr &left, const Element &key, const NodePtr &right)
+{
+    if (isRed(left))
+        return make(RED, paint(left, BLACK), key, right);
+
+    if (isBlack(right))
+        return balance(left, key, paint(right, RED));
+
+    // правый брат красный: его левый сын черный и поднимается наверх
+    const NodePtr &rl = right->_left;
+    return make(RED, make(BLACK, left, key, rl->_left), rl->_key,
+                balance(rl->_right, right->_key, paint(right->_right, RED)));
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::balRight(const NodePtr &left, const Element &key, const NodePtr &right)
+{
+    if (isRed(right))
+        return make(RED, left, key, paint(right, BLACK));
+
+    if (isBlack(left))
+        return balance(paint(left, RED), key, right);
+
+    // левый брат красный: его правый сын черный и поднимается наверх
+    const NodePtr &lr = left->_right;
+    return make(RED, balance(paint(left->_left, RED), left->_key, lr->_left), lr->_key,
+                make(BLACK, lr->_right, key, right));
+}
+
+
+template<typename Element, typename Compar>
+typename PersistentRBTree<Element, Compar>::NodePtr
+PersistentRBTree<Element, Compar>::fuse(const NodePtr &left, const NodePtr &right)
+{
+    if (!left)
+        return right;
+    if (!right)
+        return left;
+
+    if (isRed(left) && isRed(right))
+    {
+        NodePtr mid = fuse(left->_right, right->_left);
+        if (isRed(mid))
+            return make(RED, make(RED, left->_left, left->_key, mid->_left), mid->_key,
+                        make(RED, mid->_right, right->_key, right->_right));
+        return make(RED, left->_left, left->_key, make(RED, mid, right->_key, right->_right));
+    }
+
+    if (isBlack(left) && isBlack(right))
+    {
+        NodePtr mid = fuse(left->_right, right->_left);
+        if (isRed(mid))
+            return make(RED, make(BLACK, left->_left, left->_key, mid->_left), mid->_key,
+                        make(BLACK, mid->_right, right->_key, right->_right));
+        return balLeft(left->_left, left->_key, make(BLACK, mid, right->_key, right->_right));
+    }
+
+    if (isRed(right))
+        return make(RED, fuse(left, right->_left), right->_key, right->_right);
+
+    return make(RED, left->_left, left->_key, fuse(left->_right, right));
+}
+
+
+} // namespace xi
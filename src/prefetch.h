@@ -0,0 +1,25 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Подсказка процессору о предстоящем чтении памяти
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_PREFETCH_H_
+#define RBTREE_PREFETCH_H_
+
+
+// Подсказка процессору заранее подтянуть в кэш данные по адресу addr.
+// Адрес не разыменовывается, поэтому может быть и недействительным.
+#if defined(__GNUC__) || defined(__clang__)
+#define XI_RBTREE_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define XI_RBTREE_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char *>(addr), _MM_HINT_T0)
+#else
+#define XI_RBTREE_PREFETCH(addr) ((void)(addr))
+#endif
+
+
+#endif // RBTREE_PREFETCH_H_
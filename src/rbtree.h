@@ -13,6 +13,20 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <stdexcept>
+#include <atomic>
+#include <cstddef>          // std::size_t
+#include <algorithm>        // std::sort, std::unique
+#include <iterator>         // std::forward_iterator_tag
+#include <vector>
+#include <memory>           // std::shared_ptr
+
+#include "prefetch.h"
+#include "frozen_rbset.h"
+#include "epoch.h"
+#include "task_pool.h"
+#include "rbtree_serial.h"
+#include "rbtree_delta.h"
+#include "rbtree_hash.h"
 
 #ifndef RBTREE_RBTREE_H_
 #define RBTREE_RBTREE_H_
@@ -20,6 +34,10 @@
 // Uncomment this if you want to implement deletion.
 #define RBTREE_WITH_DELETION
 
+// Define this (as a compiler flag, the same for the whole program) to keep subtree
+// hashes in nodes: contentHash(), fast inequality and pruned diff(). +8 bytes per node.
+// #define RBTREE_WITH_HASHING
+
 
 namespace xi
 {
@@ -95,6 +113,13 @@ public:
         RED
     };
 
+    /** \brief Способ, которым \c insert() восстанавливает свойства КЧД. */
+    enum InsertMode
+    {
+        INSERT_BOTTOM_UP,       ///< спуск до листа, затем подъем по \c _parent (\c rebalance())
+        INSERT_TOP_DOWN         ///< перекраски и повороты по ходу единственного спуска
+    };
+
     /** \brief Узел КЧД.
      *
      *  Большая часть элементов класса является закрытой для внешнего мира и доступной только
@@ -124,10 +149,10 @@ public:
     public:
 
         /** \brief Возвращает константный указатель на левый дочерний узел. */
-        const Node *getLeft() const { return _left; }
+        const Node *getLeft() const { return _child[0]; }
 
         /** \brief Возвращает константный указатель на правый дочерний узел. */
-        const Node *getRight() const { return _right; }
+        const Node *getRight() const { return _child[1]; }
 
         /** \brief Возвращает константный указатель на родительский узел. */
         const Node *getParent() const { return _parent; }
@@ -159,7 +184,7 @@ public:
         {
             if (!_parent)
                 return false;
-            return (_parent->_left == this);
+            return (_parent->_child[0] == this);
         }
 
         /** \brief Возвращает истину, если у нода есть предок, для которого нод является правым ребенком.
@@ -169,7 +194,7 @@ public:
         {
             if (!_parent)
                 return false;
-            return (_parent->_right == this);
+            return (_parent->_child[1] == this);
         }
 
         /** \brief Определяет, является ли данный узел потомком родителя — левым, правым или не потомком. */
@@ -177,7 +202,7 @@ public:
         {
             if (!_parent)
                 return NONE;
-            if (_parent->_left == this)
+            if (_parent->_child[0] == this)
                 return LEFT;
             return RIGHT;
         }
@@ -186,6 +211,11 @@ public:
         /** \brief Возвращает константную ссылку на элемент/ключ, храняющийся в узле. */
         const Element &getKey() const { return _key; }
 
+#ifdef RBTREE_WITH_HASHING
+        /** \brief Возвращает сумму хешей ключей поддерева этого узла. */
+        std::uint64_t getHash() const { return _hash; }
+#endif // RBTREE_WITH_HASHING
+
     protected:
 
         Node(const Element &key = Element(),
@@ -193,18 +223,26 @@ public:
              Node *right = nullptr,
              Node *parent = nullptr,
              Color col = BLACK)
-                : _key(key), _left(left), _right(right), _parent(parent), _color(col)
+                : _key(key), _color(col), _parent(parent)
         {
+            _child[0] = left;
+            _child[1] = right;
+
             // если переданы дочерние элементы, устанавливаем себя их родителем, но
             // но не говорим родителю, что мы его дочерь!
-            if (_left)
-                _left->_parent = this;
+            if (_child[0])
+                _child[0]->_parent = this;
+
+            if (_child[1])
+                _child[1]->_parent = this;
 
-            if (_right)
-                _right->_parent = this;
+#ifdef RBTREE_WITH_HASHING
+            static_assert(HasRBTreeKeyHash<Element>::value, "Specialize xi::RBTreeKeyHash to use RBTREE_WITH_HASHING");
+            _hash = RBTreeKeyHash<Element>()(_key) + hashOf(_child[0]) + hashOf(_child[1]);
+#endif // RBTREE_WITH_HASHING
         }
 
-        ~Node();                                ///< Деструктор нода гарантированно грохнет всех потомков.
+        ~Node();                                ///< Деструктор. Потомков не трогает: узлы освобождает дерево.
 
     protected:
         Node(const Node &);                      ///< КК не доступен.
@@ -214,13 +252,18 @@ public:
         /** \brief Устанавливает левого потомка в \c lf. Если потомок не ноль, делает 
          *  для него текущий нод родителем, а у его предка отключает дочернюю связь.
          */
-        Node *setLeft(Node *lf);
+        Node *setLeft(Node *lf) { return setChild(0, lf); }
 
         /** \brief Устанавливает правого потомка в \c rg аналогично левому.
          *
          *  <b style='color:orange'>Для реализации студентами.</b>
          */
-        Node *setRight(Node *rg);
+        Node *setRight(Node *rg) { return setChild(1, rg); }
+
+        /** \brief Устанавливает потомка со стороны \c dir (0 — левый, 1 — правый) в \c ch
+         *  аналогично \c setLeft(). \returns прежнего потомка с этой стороны.
+         */
+        Node *setChild(int dir, Node *ch);
 
         /** \brief Делает узел черным. */
         void setBlack() { _color = BLACK; }
@@ -242,7 +285,7 @@ public:
                 return nullptr;
 
             // определяем, левый ли this детеныш
-            isLeftChild = (_parent->_left == this);
+            isLeftChild = (_parent->_child[0] == this);
 
             return _parent;
         }
@@ -250,7 +293,7 @@ public:
         /** \brief Возвращает ребенка этого узла: (isLeft) — левого, иначе правого. */
         Node *getChild(bool isLeft)
         {
-            return isLeft ? _left : _right;
+            return isLeft ? _child[0] : _child[1];
         }
 
         /** \brief Проверяет, является ли данный узел "правильным" потомком для существующего 
@@ -261,9 +304,9 @@ public:
         bool isSpecificChildPrv(bool isLeft) const
         {
             if (isLeft)         // проверяем, является ли левым узлом
-                return (_parent->_left == this);
+                return (_parent->_child[0] == this);
             // иначе проверяем, является ли правым узлом
-            return (_parent->_right == this);
+            return (_parent->_child[1] == this);
         }
 
 
@@ -272,12 +315,68 @@ public:
         Color _color;                         ///< Цвет элемента.
 
         Node *_parent;                        ///< Родитель узла.
-        Node *_left;                          ///< Левый потомок.
-        Node *_right;                         ///< Правый потомок.
+
+        /** \brief Потомки: [0] — левый, [1] — правый.
+         *
+         *  Массив вместо двух полей позволяет выбирать сторону индексом (\c _child[goRight])
+         *  и записывать зеркальные случаи один раз с параметром-направлением.
+         */
+        Node *_child[2];
+
+#ifdef RBTREE_WITH_HASHING
+        std::uint64_t _hash;                  ///< Сумма хешей ключей поддерева.
+#endif // RBTREE_WITH_HASHING
     }; // class RBTree::Node
 
     friend class Node;
 
+    /** \brief Константный итератор, перечисляющий элементы дерева в порядке возрастания.
+     *
+     *  Переход к следующему узлу идет по связям с родителями и не требует стека.
+     *  Итератор остается действительным, пока не изменяется структура дерева.
+     */
+    class ConstIterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Element value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Element *pointer;
+        typedef const Element &reference;
+
+    public:
+        /** \brief Создает итератор, указывающий на узел \c nd (\c nullptr — за концом). */
+        explicit ConstIterator(const Node *nd = nullptr) : _node(nd) {}
+
+        reference operator*() const { return _node->_key; }
+        pointer operator->() const { return &_node->_key; }
+
+        /** \brief Переходит к следующему по возрастанию элементу. */
+        ConstIterator &operator++()
+        {
+            _node = RBTree::nextNode(_node);
+            return *this;
+        }
+
+        ConstIterator operator++(int)
+        {
+            ConstIterator prev = *this;
+            ++*this;
+            return prev;
+        }
+
+        bool operator==(const ConstIterator &other) const { return _node == other._node; }
+        bool operator!=(const ConstIterator &other) const { return _node != other._node; }
+
+        /** \brief Возвращает узел, на который указывает итератор. */
+        const Node *getNode() const { return _node; }
+
+    protected:
+        const Node *_node;                      ///< Текущий узел; \c nullptr — за концом.
+    }; // class RBTree::ConstIterator
+
+    typedef ConstIterator const_iterator;
+
 public:
     RBTree();                                   ///< Конструктор по умолчанию.    
     ~RBTree();                                  ///< Деструктор.
@@ -314,20 +413,336 @@ public:
      *
      *  \returns узел элемента \c key, если он есть в дереве, иначе \c nullptr.
      */
-    const Node *find(const Element &key);
+    const Node *find(const Element &key) const;
 
     Node *findForRemove(const Element &key);
 
+    /** \brief Ищет сразу \c n ключей из массива \c keys и кладет найденные узлы (или \c nullptr)
+     *  в соответствующие ячейки \c out.
+     *
+     *  Спуски ведутся группами по \c FIND_BATCH_GROUP ключей вперемешку: за один проход
+     *  каждый поиск группы опускается на уровень, а его следующий узел заранее запрашивается
+     *  в кэш. Пока обрабатываются остальные поиски группы, узел успевает подгрузиться, и
+     *  промахи кэша независимых поисков перекрываются, а не идут друг за другом.
+     */
+    void findBatch(const Element *keys, std::size_t n, const Node **out) const;
+
     /** \brief Возвращает истину, если дерево пусто, ложь иначе. */
     bool isEmpty() const { return _root == nullptr; }
 
+    /** \brief Возвращает число элементов дерева.
+     *
+     *  Размер ведется всеми изменяющими операциями, поэтому обычно это O(1). Лишь размеры
+     *  частей \c split() неизвестны: первый вызов после него считает элементы обходом
+     *  и запоминает результат.
+     */
+    std::size_t getSize() const;
+
     /** \brief Возвращает неизменяемый указатель на корневой элемент. */
     const Node *getRoot() const { return _root; }
 
+    /** \brief Возвращает итератор на наименьший элемент дерева. */
+    ConstIterator begin() const { return ConstIterator(minNode(_root)); }
+
+    /** \brief Возвращает итератор за наибольшим элементом дерева. */
+    ConstIterator end() const { return ConstIterator(); }
+
+    /** \brief Возвращает итератор на наименьший элемент, не меньший \c key, или \c end(). */
+    ConstIterator lowerBound(const Element &key) const;
+
+    /** \brief Поиск от пальца: как \c lowerBound(key), но начиная с ранее найденной позиции
+     *  \c finger (\c end() — от корня). Ключ может лежать по любую сторону от пальца.
+     *
+     *  От пальца поднимаемся по \c _parent, пока поддерево не накроет \c key, и оттуда
+     *  спускаемся. Для ответа в d позициях от пальца подъем обычно O(log d); длинным он
+     *  бывает, только когда между пальцем и ответом лежит высокий предок, и при проходе
+     *  курсором по возрастанию такие подъемы окупаются так же, как у \c ConstIterator.
+     *  Слияния и курсоры по близким ключам получают почти O(1) на поиск вместо O(log n).
+     */
+    ConstIterator lowerBound(ConstIterator finger, const Element &key) const;
+
+    /** \brief Ищет \c key от пальца \c finger (см. \c lowerBound(finger, key)).
+     *
+     *  \returns итератор на элемент \c key или \c end(), если его нет.
+     */
+    ConstIterator find(ConstIterator finger, const Element &key) const;
+
+public:
+    // Снимки
+
+    /** \brief Строит неизменяемый снимок дерева в раскладке Эйтцингера.
+     *
+     *  Снимок не связан с деревом: дальнейшие изменения дерева на нем не отражаются.
+     *  Строится за O(n) одним симметричным обходом (плюс проход для подсчета элементов).
+     */
+    FrozenRBSet<Element, Compar> freeze() const;
+
+public:
+    // Разрезание и склейка
+
+    /** \brief Разрезает дерево по ключу \c key: элементы, меньшие \c key, переходят в \c left,
+     *  остальные (включая сам \c key, если он есть) — в \c right. Само дерево становится пустым.
+     *
+     *  Узлы не копируются и не выделяются заново: путь поиска \c key разбирается снизу вверх,
+     *  а отрезанные по дороге поддеревья склеиваются \c join() по черной высоте. Суммарная
+     *  стоимость склеек телескопируется, так что операция занимает O(log n).
+     *
+     *  \c left и \c right должны быть пусты (одним из них может быть само дерево) и различны,
+     *  иначе генерируется \c std::invalid_argument.
+     */
+    void split(const Element &key, RBTree &left, RBTree &right);
+
+    /** \brief Склеивает \c left, элемент \c pivot и \c right в это дерево за O(|bh(left) - bh(right)| + 1).
+     *
+     *  Все элементы \c left должны быть меньше \c pivot, а \c pivot — меньше всех элементов \c right,
+     *  иначе генерируется \c std::invalid_argument. Корень более низкого дерева с \c pivot подвешивается
+     *  на правый (левый) край более высокого на уровень той же черной высоты, после чего
+     *  выполняется обычная перебалансировка вставки. Узлы \c left и \c right переходят в это дерево
+     *  без копирования; \c left и \c right становятся пустыми.
+     *
+     *  Это дерево должно быть пустым либо совпадать с \c left или \c right.
+     */
+    void join(RBTree &left, const Element &pivot, RBTree &right);
+
+    /** \brief Склеивает \c left и \c right без разделяющего элемента: его роль играет наименьший
+     *  узел \c right, вынимаемый за O(log n). Требования те же, что и у \c join() с \c pivot.
+     */
+    void join(RBTree &left, RBTree &right);
+
+public:
+    // Операции над множествами
+
+    /** \brief Добавляет в дерево все элементы \c other; \c other становится пустым.
+     *
+     *  Алгоритм — "разделяй и властвуй" поверх \c split() / \c join(): корень одного дерева
+     *  разрезает другое, половины объединяются рекурсивно и склеиваются обратно через корень.
+     *  Работа — O(m log(n/m + 1)) для деревьев размеров m <= n, глубина рекурсии — O(log n log m).
+     *  С пулом \c pool половины достаточно больших поддеревьев обрабатываются параллельно.
+     *
+     *  Узлы обоих деревьев переиспользуются без копирования; из пар равных элементов остается
+     *  узел этого дерева, узел \c other освобождается (через менеджер эпох, если он подключен).
+     */
+    void unionWith(RBTree &other, TaskPool *pool = nullptr);
+
+    /** \brief Оставляет в дереве только элементы, которые есть и в \c other; \c other становится
+     *  пустым. Сложность и параллелизм — как у \c unionWith().
+     */
+    void intersect(RBTree &other, TaskPool *pool = nullptr);
+
+    /** \brief Удаляет из дерева все элементы \c other; \c other становится пустым.
+     *  Сложность и параллелизм — как у \c unionWith().
+     */
+    void difference(RBTree &other, TaskPool *pool = nullptr);
+
+    /** \brief Вставляет неупорядоченную пачку элементов [\c first, \c last).
+     *
+     *  Пачка сортируется (с пулом \c pool — параллельно), из нее убираются повторы,
+     *  за O(n) строится сбалансированное дерево и сливается с этим через \c unionWith().
+     *  Узлы пачки выделяются по одному, как в \c insert(), а не блоком: выброшенные как
+     *  повторы и удаленные позже сразу возвращают память, сколько бы пачек ни прошло.
+     *  В отличие от \c insert(), уже имеющиеся элементы не считаются ошибкой: в дереве
+     *  остаются прежние узлы.
+     */
+    template<typename InputIt>
+    void insertBatch(InputIt first, InputIt last, TaskPool *pool = nullptr);
+
+    /** \brief Строит дерево из \c n элементов, перечисляемых итератором \c first в строго
+     *  возрастающем порядке, за O(n) без сравнений: узлы — в одном блоке, как у \c compact().
+     *
+     *  Итератор проходится ровно один раз, так что годится и однопроходный (чтение из потока).
+     *  Дерево должно быть пустым, иначе генерируется \c std::invalid_argument.
+     */
+    template<typename InputIt>
+    void assignSorted(InputIt first, std::size_t n);
+
+    /** \brief Как \c assignSorted(first, n), но для возрастающих элементов [\c first, \c last),
+     *  число которых заранее известно лишь сверху: не больше \c maxN.
+     *
+     *  Узлы выделяются блоками фиксированного размера по мере прихода элементов, так что
+     *  лишняя память — не больше одного блока, сколько бы \c maxN ни превышало их число.
+     *  Если элементов больше \c maxN, генерируется \c std::invalid_argument.
+     */
+    template<typename InputIt>
+    void assignSorted(InputIt first, InputIt last, std::size_t maxN);
+
+public:
+    // Сериализация
+
+    /** \brief Пишет элементы дерева по возрастанию в \c os (формат описан в rbtree_serial.h).
+     *
+     *  Элементы кодирует \c Traits. При ошибке записи генерирует \c std::runtime_error.
+     */
+    template<typename Traits = RBTreeSerialTraits<Element> >
+    void serialize(std::ostream &os) const;
+
+    /** \brief Восстанавливает дерево из потока, записанного \c serialize().
+     *
+     *  Элементы уже упорядочены, поэтому дерево строится за O(n) прямо из потока, без
+     *  промежуточной копии, в блоках узлов \c assignSorted(first, last, maxN); сравнения
+     *  нужны только для проверки порядка. Дерево должно
+     *  быть пустым, иначе генерируется \c std::invalid_argument. Поврежденный, обрезанный
+     *  или неупорядоченный поток (в том числе несовпадение контрольной суммы) приводит
+     *  к \c std::runtime_error, и дерево остается пустым.
+     */
+    template<typename Traits = RBTreeSerialTraits<Element> >
+    void deserialize(std::istream &is);
+
+public:
+    // Разница и репликация
+
+    /** \brief Заполняет \c delta изменениями, переводящими это дерево в \c other: удалить то,
+     *  чего нет в \c other, вставить то, чего нет в этом.
+     *
+     *  Без \c RBTREE_WITH_HASHING деревья обходятся по возрастанию одновременно, слиянием,
+     *  за O(n + m). С ним спуск идет по этому дереву, и поддерево, чей хеш равен хешу ключей
+     *  \c other из того же интервала, пропускается целиком: d различий стоят
+     *  O(d log n log m) вместо линейного обхода. Совпадение сумм принимается за совпадение
+     *  ключей: разница может быть пропущена с вероятностью порядка 2^-64 на сравнение.
+     */
+    void diff(const RBTree &other, RBTreeDelta<Element, Compar> &delta) const;
+
+    /** \brief Возвращает истину, если в деревьях одни и те же элементы.
+     *
+     *  При \c RBTREE_WITH_HASHING разные деревья почти всегда отсекаются за O(1)
+     *  по \c contentHash(); совпадение хешей подтверждается обходом.
+     */
+    bool isEqual(const RBTree &other) const;
+
+#ifdef RBTREE_WITH_HASHING
+
+    /** \brief Возвращает хеш содержимого за O(1): сумму \c RBTreeKeyHash всех элементов
+     *  (0 — для пустого дерева).
+     *
+     *  Зависит только от множества элементов, а не от формы дерева и истории операций.
+     *  Читается без синхронизации, поэтому при конкурентных изменениях не определен.
+     */
+    std::uint64_t contentHash() const { return hashOf(_root); }
+
+#endif // RBTREE_WITH_HASHING
+
+    /** \brief Применяет \c delta пачкой: удаления — разностью с упорядоченным списком, как
+     *  \c difference(), но без узлов для удаляемых ключей; вставки — через \c unionWith()
+     *  с деревом, построенным из списка за линейное время из отдельно выделенных узлов.
+     *  Ни то, ни другое не оставляет дереву блоков узлов, так что реплика, применяющая
+     *  разницы каждый цикл синхронизации, не растет сверх своего содержимого.
+     *
+     *  Отсутствующие удаляемые и уже имеющиеся вставляемые элементы пропускаются,
+     *  так что повторное применение той же разницы ничего не меняет.
+     */
+    void applyDelta(const RBTreeDelta<Element, Compar> &delta, TaskPool *pool = nullptr);
+
+public:
+    // Параллельный обход
+
+    /** \brief Вызывает \c fn(элемент) для каждого элемента дерева.
+     *
+     *  Верхние \c pool->getSplitDepth() уровней дерева делят его на независимые поддеревья,
+     *  которые обходятся потоками пула. Порядок вызовов не определен, \c fn вызывается
+     *  одновременно из нескольких потоков. Без пула — обычный обход по возрастанию.
+     */
+    template<typename F>
+    void parallelForEach(F fn, TaskPool *pool = nullptr) const;
+
+    /** \brief Сворачивает дерево: <tt>combine(...combine(identity, map(e1))..., map(en))</tt>
+     *  для элементов по возрастанию.
+     *
+     *  Поддеревья сворачиваются параллельно, как в \c parallelForEach(), а их результаты
+     *  объединяются в порядке ключей, поэтому \c combine обязана быть лишь ассоциативной
+     *  (не обязательно коммутативной), а \c identity — ее нейтральным элементом.
+     */
+    template<typename T, typename Map, typename Combine>
+    T parallelReduce(const T &identity, Map map, Combine combine, TaskPool *pool = nullptr) const;
+
+public:
+    // Обслуживание
+
+    /** \brief Переносит все узлы дерева в один непрерывный блок памяти в порядке ван Эмде Боаса.
+     *
+     *  Дерево высоты h делится по средней глубине на верхнее поддерево высоты h/2 и нижние
+     *  поддеревья, каждое из которых раскладывается подряд тем же способом. При любом размере
+     *  кэш-линии и страницы спуск от корня затрагивает O(log_B n) блоков, так что последующие
+     *  поиски реже промахиваются мимо кэша и TLB. Связи \c _child и \c _parent
+     *  переставляются на новые адреса, ключи копируются.
+     *
+     *  Операция занимает O(n log log n) времени и рассчитана на периоды простоя. Все указатели
+     *  на узлы и итераторы после нее недействительны. Узлы, вставленные позже, выделяются
+     *  как обычно; память удаленных из блока узлов возвращается только со следующим \c compact()
+     *  или вместе с деревом. Узлы блока, ушедшие в другие деревья через \c split() / \c join(),
+     *  держат блок, пока жив хоть один из его владельцев.
+     */
+    void compact();
+
+public:
+    // Конкурентное чтение
+
+    /** \brief Подключает менеджер эпох \c em (или отключает при \c nullptr).
+     *
+     *  С менеджером \c remove() не освобождает вынутый узел сразу, а передает его
+     *  \c EpochManager::retire(): читатели, обходящие дерево под \c EpochManager::ReaderGuard
+     *  (\c find(), \c getLeft() / \c getRight() и т.п.), никогда не обращаются к освобожденной
+     *  памяти, даже если писатель одновременно удаляет узлы. Писатель должен быть один;
+     *  видимость читателем ключа, который в этот момент переставляется поворотом, не гарантируется.
+     *
+     *  Менеджер должен пережить дерево. Деструктор и \c compact() перед освобождением памяти
+     *  ждут выхода текущих читателей (\c EpochManager::synchronize()).
+     */
+    void setReclaimer(EpochManager *em) { _reclaimer = em; }
+
+    /** \brief Возвращает подключенный менеджер эпох или \c nullptr. */
+    EpochManager *getReclaimer() const { return _reclaimer; }
+
+public:
+    // Кэш частых ключей
+
+    /** \brief Включает перед \c find() кэш прямого отображения на \c slots ячеек (округляется
+     *  вверх до степени двойки; 0 — выключает кэш).
+     *
+     *  Ячейка выбирается по \c RBTreeKeyHash ключа и указывает на узел, последним найденный
+     *  поиском с этой ячейкой; попадание отвечается без спуска, за O(1). При скошенном
+     *  (например, ципфовом) распределении поисков частые ключи почти всегда в кэше.
+     *  Форма дерева не меняется, так что оценки изменений и худший случай поиска прежние.
+     *  Узлы, уходящие из дерева (\c remove(), операции над множествами, \c split(), \c join(),
+     *  \c compact()), из кэша выбрасываются.
+     *
+     *  Поиски с кэшем можно вести одновременно друг с другом и с писателем под менеджером
+     *  эпох. Сам вызов — только без конкурентных операций.
+     */
+    void setHotCacheSize(std::size_t slots);
+
+    /** \brief Возвращает число ячеек кэша частых ключей (0 — кэш выключен). */
+    std::size_t getHotCacheSize() const { return _hotCache ? _hotMask + 1 : 0; }
+
+public:
+    // Режим вставки
+
+    /** \brief Выбирает, как \c insert() балансирует дерево (по умолчанию \c INSERT_BOTTOM_UP).
+     *
+     *  \c INSERT_TOP_DOWN (Гибас—Седжвик) перекрашивает узел с двумя красными детьми прямо
+     *  на спуске и тут же снимает появившееся красное-красное поворотом у дедушки: путь
+     *  проходится один раз, подъема к корню нет. Форма дерева может отличаться от
+     *  двухпроходной вставки, но остается красно-черной.
+     *
+     *  Дубликат обнаруживается лишь на спуске, когда часть перекрасок и поворотов уже сделана:
+     *  \c std::invalid_argument тогда выбрасывается из корректного дерева с теми же ключами,
+     *  но, возможно, другой формы. При \c RBTREE_WITH_HASHING хеш нового листа по-прежнему
+     *  разносится по предкам подъемом.
+     */
+    void setInsertMode(InsertMode mode) { _insertMode = mode; }
+
+    /** \brief Возвращает текущий режим вставки. */
+    InsertMode getInsertMode() const { return _insertMode; }
+
 public:
     // Отладочные операции
 
-    /** \brief Устанавливает отладочный дампер. */
+    /** \brief Устанавливает отладочный дампер.
+     *
+     *  Массовые операции (\c split(), \c join(), операции над множествами, \c insertBatch(),
+     *  \c applyDelta(), \c assignSorted(), \c deserialize()) промежуточных событий не дают:
+     *  по их завершении каждое затронутое дерево с дампером сообщает \c DE_AFTER_REMOVE
+     *  по каждому ушедшему ключу и \c DE_AFTER_INSERT по каждому пришедшему, по возрастанию.
+     *  Для этого ключи дерева перебираются до и после операции — O(n) только при дампере.
+     */
     void setDumper(IRBTreeDumper<Element, Compar> *dumper)
     {
         _dumper = dumper;
@@ -343,6 +758,71 @@ public:
 protected:
 
 
+    /** \brief Блок узлов \c compact(): общий для всех деревьев, куда его узлы разошлись
+     *  через \c split() / \c join() и операции над множествами.
+     *
+     *  Блок считает свои живые узлы: память освобождается вместе с последним из них, даже
+     *  если деревья, получившие блок, еще держат на него ссылку. Такие пустые записи деревья
+     *  выбрасывают сами (\c pruneArenas()), заметив по \c getReleasedNum(), что блоки
+     *  освобождались.
+     */
+    struct Arena
+    {
+        Arena(Node *nd, std::size_t sz) : nodes(nd), size(sz), live(sz) {}
+
+        // блок, который так и не заполнился (исключение при построении), освобождается здесь
+        ~Arena()
+        {
+            if (live.load() != 0)
+                ::operator delete(nodes);
+        }
+
+        /** \brief Отмечает разрушение одного узла блока; с последним освобождает память. */
+        void releaseNode()
+        {
+            if (live.fetch_sub(1) == 1)
+            {
+                getReleasedNum().fetch_add(1);
+                ::operator delete(nodes);
+            }
+        }
+
+        /** \brief Возвращает истину, если живых узлов в блоке не осталось и память освобождена. */
+        bool isEmpty() const { return live.load() == 0; }
+
+        /** \brief Счетчик блоков, освобожденных за все время (всеми деревьями этого типа). */
+        static std::atomic<std::uint64_t> &getReleasedNum()
+        {
+            static std::atomic<std::uint64_t> released(0);
+            return released;
+        }
+
+        /** \brief Возвращает адрес начала блока как число: указатели на разные объекты напрямую
+         *  не упорядочены.
+         */
+        std::uintptr_t begin() const { return reinterpret_cast<std::uintptr_t>(nodes); }
+
+        /** \brief Возвращает истину, если узел \c nd лежит в блоке. */
+        bool contains(const Node *nd) const
+        {
+            std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(nd);
+            return addr >= begin() && addr < begin() + size * sizeof(Node);
+        }
+
+        Node *nodes;                            ///< Узлы подряд.
+        std::size_t size;                       ///< Число узлов.
+        std::atomic<std::size_t> live;          ///< Число еще не разрушенных узлов.
+    };
+
+    /** \brief Узел блока, отложенный через \c EpochManager: держит блок, пока узел не разрушен. */
+    struct RetiredArenaNode
+    {
+        RetiredArenaNode(Node *nd, const std::shared_ptr<Arena> &a) : node(nd), arena(a) {}
+
+        Node *node;                             ///< Узел.
+        std::shared_ptr<Arena> arena;           ///< Его блок.
+    };
+
     /** \brief Добавляет новый узел в дерево, как в обычном BST. 
      *
      *  <b style='color:orange'>Для реализации студентами.</b>
@@ -352,6 +832,24 @@ protected:
      */
     Node *insertNewBstEl(const Element &key);
 
+    /** \brief Возвращает узел с ключом \c key или \c nullptr: общий спуск \c find()
+     *  и \c findForRemove().
+     */
+    const Node *findNode(const Element &key) const;
+
+    /** \brief Возвращает наименьший узел поддерева \c node, не меньший \c key, или \c nullptr. */
+    const Node *lowerBoundNode(const Node *node, const Element &key) const;
+
+    /** \brief Вставка \c INSERT_TOP_DOWN: добавляет \c key за один спуск с балансировкой по пути.
+     *  \return Указатель на новодобавленный элемент.
+     */
+    Node *insertTopDown(const Element &key);
+
+    /** \brief Снимает на спуске нарушение красный \c nd под красным отцом одним или двумя
+     *  поворотами у дедушки (дядя черный по построению). Спуск продолжается от \c nd.
+     */
+    void splitRedRed(Node *nd);
+
     /** \brief Выполняет перебалансировку дерева после добавления нового элемента в узел \c nd. 
      *
      *  <b style='color:orange'>Для реализации студентами.</b>
@@ -367,9 +865,272 @@ protected:
      */
     Node *rebalanceDUG(Node *nd);
 
+    /** \brief Возвращает черную высоту поддерева \c nd: число черных узлов на пути от \c nd
+     *  (включительно) до листа.
+     */
+    static int getBlackHeight(const Node *nd);
+
+    /** \brief Склеивает отсоединенные поддеревья \c l и \c r черных высот \c lh и \c rh
+     *  через отсоединенный узел \c k; вращения ведутся в контексте этого дерева (его \c _root).
+     *
+     *  \param h Черная высота результата.
+     *  \returns Корень результата (черный).
+     */
+    Node *joinNodes(Node *l, int lh, Node *k, Node *r, int rh, int &h);
+
+    /** \brief Разрезает отсоединенное поддерево \c t черной высоты \c th по ключу \c key на \c l
+     *  (меньшие) и \c r (большие) с черными высотами \c lh и \c rh; вращения — в контексте этого дерева.
+     *
+     *  \returns Отсоединенный узел, эквивалентный \c key, или \c nullptr.
+     */
+    Node *splitNodes(Node *t, int th, const Element &key, Node *&l, int &lh, Node *&r, int &rh);
+
+    /** \brief Склеивает отсоединенные поддеревья \c l и \c r без разделителя (им становится
+     *  наименьший узел \c r); вращения — в контексте этого дерева.
+     */
+    Node *join2Nodes(Node *l, int lh, Node *r, int rh, int &h);
+
+    /** \brief Отделяет от поддерева \c t корень \c k: его дети \c l, \c r (черной высоты \c ch) отсоединяются. */
+    static void expose(Node *t, int th, Node *&l, Node *&r, int &ch);
+
+    /** \brief Пустое дерево — контекст вращений для операций над отсоединенными поддеревьями.
+     *  Своих узлов не владеет, поэтому каждый параллельный шаг заводит свой.
+     */
+    class ScratchTree;
+
+    /** \brief Рекурсивные части \c unionWith(), \c intersect() и \c difference() над отсоединенными
+     *  поддеревьями. Выброшенные узлы (поддеревья) дописываются в \c dropped.
+     */
+    Node *unionNodes(Node *t1, int h1, Node *t2, int h2, int &h, std::vector<Node *> &dropped, TaskPool *pool);
+    Node *intersectNodes(Node *t1, int h1, Node *t2, int h2, int &h, std::vector<Node *> &dropped, TaskPool *pool);
+    Node *differenceNodes(Node *t1, int h1, Node *t2, int h2, int &h, std::vector<Node *> &dropped, TaskPool *pool);
+
+    /** \brief Разность поддерева \c t1 и упорядоченного диапазона ключей [\c first, \c last):
+     *  вместо разрезания второго дерева — двоичный поиск в диапазоне.
+     */
+    Node *differenceSortedNodes(Node *t1, int h1, const Element *first, const Element *last, int &h,
+                                std::vector<Node *> &dropped, TaskPool *pool);
+
+    /** \brief Тип рекурсивной части операции над множествами. */
+    typedef Node *(RBTree::*SetOp)(Node *, int, Node *, int, int &, std::vector<Node *> &, TaskPool *);
+
+    /** \brief Выполняет операцию \c op над парами (\c l1, \c l2) и (\c r1, \c r2), параллельно,
+     *  если есть пул и поддеревья достаточно велики.
+     */
+    void forkSetOp(SetOp op, Node *l1, Node *l2, int lh2, Node *r1, Node *r2, int rh2, int ch,
+                   Node *&tl, int &hl, Node *&tr, int &hr, std::vector<Node *> &dropped, TaskPool *pool);
+
+    /** \brief Общая обертка операций над множествами: забирает узлы у \c other, выполняет \c op,
+     *  освобождает выброшенные узлы.
+     */
+    void runSetOp(SetOp op, RBTree &other, TaskPool *pool);
+
+    /** \brief Связывает узлы \c nodes[\c lo, \c hi) (лежащие по порядку ключей) в идеально
+     *  сбалансированное поддерево; узлы на глубине \c redDepth — неполном последнем уровне — красные.
+     *  \c nodes — блок узлов или массив указателей на них.
+     */
+    template<typename Nodes>
+    static Node *linkSorted(Nodes nodes, std::size_t lo, std::size_t hi, int depth, int redDepth);
+
+    /** \brief Связывает все \c n узлов \c nodes в КЧД и возвращает его корень (\c n > 0). */
+    template<typename Nodes>
+    static Node *linkSorted(Nodes nodes, std::size_t n);
+
+    /** \brief Размер (в узлах) блоков, которыми \c assignSorted(first, last, maxN) выделяет узлы. */
+    static constexpr std::size_t SORTED_CHUNK = std::size_t(1) << 16;
+
+    /** \brief Узлы, лежащие подряд в блоках по \c SORTED_CHUNK: \c chunks — начала блоков. */
+    struct ChunkedNodes
+    {
+        explicit ChunkedNodes(Node *const *ch) : chunks(ch) {}
+
+        Node *const *chunks;
+    };
+
+    /** \brief Возвращает \c i-й узел блока, массива указателей или блоков для \c linkSorted(). */
+    static Node *nodeAt(Node *nodes, std::size_t i) { return nodes + i; }
+    static Node *nodeAt(Node *const *nodes, std::size_t i) { return nodes[i]; }
+    static Node *nodeAt(ChunkedNodes nodes, std::size_t i)
+    {
+        return nodes.chunks[i / SORTED_CHUNK] + i % SORTED_CHUNK;
+    }
+
+    /** \brief Выделяет по отдельности узлы для \c n возрастающих элементов из \c first и
+     *  связывает их в КЧД за O(n); возвращает корень (\c nullptr при \c n == 0).
+     */
+    template<typename InputIt>
+    static Node *buildSorted(InputIt first, std::size_t n);
+
+    /** \brief Обходит поддерево \c nd по возрастанию без рекурсии, вызывая \c fn(элемент). */
+    template<typename F>
+    static void forEachNodes(const Node *nd, F &fn);
+
+#ifdef RBTREE_WITH_HASHING
+
+    /** \brief Возвращает хеш поддерева \c nd (0 — для пустого). */
+    static std::uint64_t hashOf(const Node *nd) { return nd ? nd->_hash : 0; }
+
+    /** \brief Возвращает хеш ключа самого узла \c nd (при верных хешах его детей). */
+    static std::uint64_t ownHashOf(const Node *nd) { return nd->_hash - hashOf(nd->_child[0]) - hashOf(nd->_child[1]); }
+
+    /** \brief Прибавляет \c d к хешам \c nd и всех его предков. */
+    static void addHashUp(Node *nd, std::uint64_t d)
+    {
+        for (; nd; nd = nd->_parent)
+            nd->_hash += d;
+    }
+
+    /** \brief Возвращает сумму хешей элементов, меньших \c key (при \c inclusive — не больших). */
+    std::uint64_t hashBelow(const Element &key, bool inclusive) const;
+
+    /** \brief Возвращает сумму хешей элементов из интервала (\c lo, \c hi); \c nullptr —
+     *  граница отсутствует.
+     */
+    std::uint64_t rangeHash(const Element *lo, const Element *hi) const;
+
+    /** \brief Часть \c diff() для поддерева \c nd, занимающего интервал (\c lo, \c hi). */
+    void diffNodes(const Node *nd, const Element *lo, const Element *hi, const RBTree &other,
+                   RBTreeDelta<Element, Compar> &delta) const;
+
+#endif // RBTREE_WITH_HASHING
+
+    /** \brief Части \c parallelForEach() и \c parallelReduce() для поддерева \c nd: верхние
+     *  \c depth уровней обрабатываются через \c pool->invoke(), ниже — последовательно.
+     */
+    template<typename F>
+    static void parallelForEachNodes(const Node *nd, int depth, F &fn, TaskPool *pool);
+    template<typename T, typename Map, typename Combine>
+    static T reduceNodes(const Node *nd, int depth, const T &identity, Map &map, Combine &combine, TaskPool *pool);
+
+    /** \brief Освобождает (через \c retireNode()) все узлы поддеревьев из \c dropped;
+     *  возвращает их число.
+     */
+    std::size_t dropNodes(const std::vector<Node *> &dropped);
+
+    /** \brief Значение \c _size, когда размер неизвестен. */
+    static constexpr std::size_t SIZE_UNKNOWN = ~std::size_t(0);
+
+    /** \brief Прибавляет к известному размеру \c added и отнимает \c removed; неизвестный
+     *  размер так и остается неизвестным.
+     */
+    void adjustSize(std::size_t added, std::size_t removed);
+
+    /** \brief Возвращает сумму размеров \c a и \c b или \c SIZE_UNKNOWN, если один из них неизвестен. */
+    static std::size_t addSizes(std::size_t a, std::size_t b)
+    {
+        return (a == SIZE_UNKNOWN || b == SIZE_UNKNOWN) ? SIZE_UNKNOWN : a + b;
+    }
+
+    /** \brief Возвращает ключи дерева по возрастанию, если подключен дампер (иначе — пусто):
+     *  снимок до массовой операции для \c dumpBulkChange().
+     */
+    std::vector<Element> dumperSnapshot() const;
+
+    /** \brief Сообщает дамперу итог массовой операции по сравнению с ключами \c before:
+     *  \c DE_AFTER_REMOVE для ушедших ключей и \c DE_AFTER_INSERT для новых. Без дампера
+     *  ничего не делает.
+     */
+    void dumpBulkChange(const std::vector<Element> &before);
+
+    /** \brief \c dumpBulkChange() для всех деревьев \c join(): исходных (если это не само
+     *  дерево) и этого, по их ключам до операции.
+     */
+    void dumpJoin(RBTree &left, const std::vector<Element> &leftBefore, RBTree &right,
+                  const std::vector<Element> &rightBefore, const std::vector<Element> &before);
+
+    /** \brief Вынимает узел \c nd из дерева с перебалансировкой, но не освобождает его.
+     *  При \c withEvents сообщает дамперу о событиях удаления.
+     */
+    void unlinkNode(Node *nd, bool withEvents);
+
+    /** \brief Забирает у дерева все узлы и блоки: дерево становится пустым. */
+    Node *release(std::vector<std::shared_ptr<Arena> > &arenas);
+
+    /** \brief Добавляет к блокам дерева еще не известные ему блоки из \c arenas. */
+    void adoptArenas(const std::vector<std::shared_ptr<Arena> > &arenas);
+
+    /** \brief Упорядочивает \c _arenas по адресу и убирает повторы и пустые блоки
+     *  (для поиска в \c findArena()).
+     */
+    void sortArenas();
+
+    /** \brief Выбрасывает из \c _arenas пустые блоки, если с прошлого раза какие-то блоки
+     *  освобождались: память пустого блока могла уйти под новые узлы, и его диапазон
+     *  адресов больше ничего не значит.
+     */
+    void pruneArenas();
+
+    /** \brief Проверяет, что поддеревья \c left и \c right (любое может быть пустым) можно склеить
+     *  через \c pivot, иначе генерирует исключение.
+     */
+    void checkJoinOrder(const Node *left, const Element &pivot, const Node *right) const;
+
+    /** \brief Возвращает самый левый (наименьший) узел поддерева \c nd или \c nullptr для пустого. */
+    static const Node *minNode(const Node *nd);
+
+    /** \brief Возвращает следующий по возрастанию за \c nd узел или \c nullptr, если его нет. */
+    static const Node *nextNode(const Node *nd);
+
     /** \brief Удаляет нод со всеми его потомками, освобождая память из-под них. */
     void deleteNode(Node *nd);
 
+    /** \brief Освобождает один узел \c nd: узел из блока \c compact() только разрушается,
+     *  остальные удаляются обычным \c delete.
+     */
+    void freeNode(Node *nd);
+
+    /** \brief Возвращает блок дерева, в котором лежит узел \c nd, или \c nullptr, если узел
+     *  выделен отдельно. Двоичный поиск по \c _arenas; пустые блоки должны быть выброшены.
+     */
+    const std::shared_ptr<Arena> *findArena(const Node *nd) const;
+
+    /** \brief Освобождает вынутый из дерева узел \c nd: при подключенном менеджере эпох — отложенно,
+     *  иначе сразу через \c freeNode().
+     */
+    void retireNode(Node *nd);
+
+    /** \brief Функции отложенного освобождения для \c EpochManager: узла, выделенного
+     *  отдельно, и \c RetiredArenaNode.
+     */
+    static void deleteHeapNode(void *nd);
+    static void destroyArenaNode(void *rec);
+
+    /** \brief Ячейка кэша частых ключей. */
+    typedef std::atomic<const Node *> HotSlot;
+
+    /** \brief Возвращает ячейку кэша для \c key (кэш должен быть включен). */
+    HotSlot &hotSlotOf(const Element &key) const { return _hotCache[RBTreeKeyHash<Element>()(key) & _hotMask]; }
+
+    /** \brief Кладет найденный узел \c nd в ячейку \c slot. \c gen — счетчик выбрасываний
+     *  на начало поиска: если он изменился, \c nd мог уже уйти из дерева и убирается обратно.
+     */
+    void rememberHot(HotSlot &slot, const Node *nd, std::uint64_t gen) const;
+
+    /** \brief Выбрасывает \c nd из кэша частых ключей, если он там есть. */
+    void evictHot(const Node *nd);
+
+    /** \brief Очищает кэш частых ключей. */
+    void clearHot();
+
+    /** \brief Ставит поддерево \c v (возможно, пустое) на место поддерева \c u в родителе \c u. */
+    void transplant(Node *u, Node *v);
+
+    /** \brief Восстанавливает свойства дерева после удаления черного узла.
+     *
+     *  \c x — узел, занявший место удаленного (возможно, \c nullptr), \c xParent — его родитель:
+     *  у пустого \c x родителя не узнать иначе.
+     */
+    void removeFixup(Node *x, Node *xParent);
+
+    /** \brief Возвращает высоту поддерева \c nd (0 для пустого). */
+    static int getHeight(const Node *nd);
+
+    /** \brief Дописывает в \c out узлы поддерева \c nd высоты не более \c h в порядке ван Эмде Боаса. */
+    static void collectVeb(Node *nd, int h, std::vector<Node *> &out);
+
+    /** \brief Дописывает в \c out слева направо узлы поддерева \c nd, лежащие на глубине \c depth. */
+    static void collectAtDepth(Node *nd, int depth, std::vector<Node *> &out);
+
     /** \brief Вращает поддерево относительно узла \c nd влево.
      *
      *  <b style='color:orange'>Для реализации студентами.</b>
@@ -377,14 +1138,30 @@ protected:
      *  Требование: правый ребенок узла \c nd не должен быть null, иначе генерируется
      *  исключительная ситуация \c std::invalid_argument.
      */
-    void rotLeft(Node *nd);
+    void rotLeft(Node *nd) { rotate(nd, 0); }
 
     /** \brief Вращает поддерево относительно узла \c nd вправо. Условия и ограничения 
       * аналогичны (симметрично) левому вращению. 
       *
       *  <b style='color:orange'>Для реализации студентами.</b>
       */
-    void rotRight(Node *nd);
+    void rotRight(Node *nd) { rotate(nd, 1); }
+
+    /** \brief Вращает поддерево относительно узла \c nd так, что \c nd опускается в сторону
+     *  \c dir (0 — левое вращение, 1 — правое): зеркальные случаи записаны один раз.
+     *
+     *  Сын \c nd с другой стороны не должен быть null, иначе генерируется \c std::invalid_argument.
+     */
+    void rotate(Node *nd, int dir);
+
+public:
+    /** \brief Число одновременно ведущихся спусков в \c findBatch(). */
+    static const std::size_t FIND_BATCH_GROUP = 16;
+
+    /** \brief Операции над множествами отдают половину работы в пул, только если черная высота
+     *  поддерева не меньше этой (в нем хотя бы 2^h - 1 узлов): меньшие дешевле сделать самим.
+     */
+    static const int PARALLEL_MIN_BLACK_HEIGHT = 8;
 
 protected:
     RBTree(const RBTree &);                      ///< КК не доступен.
@@ -408,6 +1185,34 @@ protected:
      */
     Node *_root;
 
+    /** \brief Блоки, в которых лежат узлы этого дерева: свой от \c compact() и полученные
+     *  вместе с узлами через \c split() / \c join(). Упорядочены по адресу блока.
+     */
+    std::vector<std::shared_ptr<Arena> > _arenas;
+
+    /** \brief Значение \c Arena::getReleasedNum() при последнем \c pruneArenas(). */
+    std::uint64_t _arenasReleasedSeen;
+
+    /** \brief Число элементов или \c SIZE_UNKNOWN. Атомарно, т.к. \c getSize() запоминает
+     *  посчитанный размер и из константных (читающих) вызовов.
+     */
+    mutable std::atomic<std::size_t> _size;
+
+    /** \brief Менеджер эпох для отложенного освобождения узлов или \c nullptr. */
+    EpochManager *_reclaimer;
+
+    /** \brief Ячейки кэша частых ключей; пусто, если кэш выключен. */
+    std::unique_ptr<HotSlot[]> _hotCache;
+    std::size_t _hotMask;                       ///< Число ячеек кэша минус один.
+
+    /** \brief Счетчик выбрасываний из кэша: поиск, заметивший его изменение, не оставляет
+     *  в кэше найденный узел.
+     */
+    std::atomic<std::uint64_t> _hotGeneration;
+
+    /** \brief Способ балансировки в \c insert(). */
+    InsertMode _insertMode;
+
 
 protected:
     // Секция отладочных компонент
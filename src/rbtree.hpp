@@ -13,6 +13,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <stdexcept>        // std::invalid_argument
+#include <new>              // placement new
+#include <cstdint>          // std::uintptr_t
 
 
 namespace xi
@@ -26,173 +28,1808 @@ namespace xi
 template<typename Element, typename Compar>
 RBTree<Element, Compar>::Node::~Node()
 {
-    if (_left)
-        delete _left;
-    if (_right)
-        delete _right;
+    // потомков освобождает дерево (deleteNode()), т.к. узлы могут лежать
+    // в общем блоке compact() и не допускать delete по отдельности
 }
 
 
 template<typename Element, typename Compar>
-typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::Node::setLeft(Node *lf)
+typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::Node::setChild(int dir, Node *ch)
 {
     // предупреждаем повторное присвоение
-    if (_left == lf)
+    if (_child[dir] == ch)
         return nullptr;
 
-    // если новый левый — действительный элемент
-    if (lf)
+    // если новый потомок — действительный элемент
+    if (ch)
     {
-        // если у него был родитель
-        if (lf->_parent)
+        // если у него был родитель, вместо него у родителя ставим бублик
+        if (ch->_parent)
+            ch->_parent->_child[ch->_parent->_child[1] == ch] = nullptr;
+
+        // задаем нового родителя
+        ch->_parent = this;
+    }
+
+    // если на этой стороне уже был потомок — отменяем его родительскую связь и вернем его
+    Node *prev = _child[dir];
+    _child[dir] = ch;
+
+    if (prev)
+        prev->_parent = nullptr;
+
+    return prev;
+}
+
+
+//==============================================================================
+// class RBTree
+//==============================================================================
+
+template<typename Element, typename Compar>
+RBTree<Element, Compar>::RBTree()
+{
+    _root = nullptr;
+    _arenasReleasedSeen = 0;
+    _size.store(0);
+    _reclaimer = nullptr;
+    _dumper = nullptr;
+    _hotMask = 0;
+    _hotGeneration.store(0);
+    _insertMode = INSERT_BOTTOM_UP;
+}
+
+template<typename Element, typename Compar>
+RBTree<Element, Compar>::~RBTree()
+{
+    // отложенные узлы из блока compact() должны быть разрушены до освобождения блока
+    if (_reclaimer)
+        _reclaimer->synchronize();
+
+    // грохаем всех через корень; память блока compact() уходит с последним его узлом
+    deleteNode(_root);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::deleteNode(Node *nd)
+{
+    // если переданный узел не существует, просто ничего не делаем, т.к. в вызывающем проверок нет
+    if (nd == nullptr)
+        return;
+
+    // обходим только по дочерним связям и без рекурсии: глубина дерева тут не важна
+    std::vector<Node *> stack(1, nd);
+    while (!stack.empty())
+    {
+        Node *cur = stack.back();
+        stack.pop_back();
+
+        if (cur->_child[0])
+            stack.push_back(cur->_child[0]);
+        if (cur->_child[1])
+            stack.push_back(cur->_child[1]);
+
+        freeNode(cur);
+    }
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::freeNode(Node *nd)
+{
+    pruneArenas();
+    const std::shared_ptr<Arena> *arena = findArena(nd);
+    if (!arena)
+    {
+        delete nd;
+        return;
+    }
+
+    nd->~Node();
+    (*arena)->releaseNode();
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::pruneArenas()
+{
+    std::uint64_t released = Arena::getReleasedNum().load();
+    if (released == _arenasReleasedSeen)
+        return;
+
+    _arenas.erase(std::remove_if(_arenas.begin(), _arenas.end(),
+                                 [](const std::shared_ptr<Arena> &a) { return a->isEmpty(); }),
+                  _arenas.end());
+    _arenasReleasedSeen = released;
+}
+
+
+template<typename Element, typename Compar>
+const std::shared_ptr<typename RBTree<Element, Compar>::Arena> *
+RBTree<Element, Compar>::findArena(const Node *nd) const
+{
+    // последний блок, начинающийся не правее nd; блоки не пересекаются
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(nd);
+    typename std::vector<std::shared_ptr<Arena> >::const_iterator it =
+            std::upper_bound(_arenas.begin(), _arenas.end(), addr,
+                             [](std::uintptr_t a, const std::shared_ptr<Arena> &b) { return a < b->begin(); });
+    if (it == _arenas.begin())
+        return nullptr;
+
+    --it;
+    return (*it)->contains(nd) ? &*it : nullptr;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::retireNode(Node *nd)
+{
+    evictHot(nd);
+
+    if (!_reclaimer)
+    {
+        freeNode(nd);
+        return;
+    }
+
+    pruneArenas();
+    const std::shared_ptr<Arena> *arena = findArena(nd);
+    if (!arena)
+    {
+        _reclaimer->retire(nd, &deleteHeapNode);
+        return;
+    }
+
+    // блок должен дожить до разрушения узла, даже если дерево к тому времени его отпустит
+    _reclaimer->retire(new RetiredArenaNode(nd, *arena), &destroyArenaNode);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::deleteHeapNode(void *nd)
+{
+    delete static_cast<Node *>(nd);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::destroyArenaNode(void *rec)
+{
+    RetiredArenaNode *r = static_cast<RetiredArenaNode *>(rec);
+    r->node->~Node();
+    r->arena->releaseNode();
+    delete r;
+}
+
+
+template<typename Element, typename Compar>
+const typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::minNode(const Node *nd)
+{
+    if (!nd)
+        return nullptr;
+
+    while (nd->_child[0])
+        nd = nd->_child[0];
+    return nd;
+}
+
+
+template<typename Element, typename Compar>
+const typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::nextNode(const Node *nd)
+{
+    // есть правое поддерево — следующий в нем самый левый
+    if (nd->_child[1])
+        return minNode(nd->_child[1]);
+
+    // иначе поднимаемся, пока идем из правого поддерева
+    while (nd->_parent && nd->_parent->_child[1] == nd)
+        nd = nd->_parent;
+    return nd->_parent;
+}
+
+
+template<typename Element, typename Compar>
+FrozenRBSet<Element, Compar> RBTree<Element, Compar>::freeze() const
+{
+    std::size_t n = 0;
+    for (ConstIterator it = begin(); it != end(); ++it)
+        ++n;
+
+    return FrozenRBSet<Element, Compar>(begin(), n);
+}
+
+
+template<typename Element, typename Compar>
+int RBTree<Element, Compar>::getHeight(const Node *nd)
+{
+    if (!nd)
+        return 0;
+
+    int hl = getHeight(nd->_child[0]);
+    int hr = getHeight(nd->_child[1]);
+    return 1 + (hl > hr ? hl : hr);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::collectAtDepth(Node *nd, int depth, std::vector<Node *> &out)
+{
+    if (!nd)
+        return;
+
+    if (depth == 0)
+    {
+        out.push_back(nd);
+        return;
+    }
+
+    collectAtDepth(nd->_child[0], depth - 1, out);
+    collectAtDepth(nd->_child[1], depth - 1, out);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::collectVeb(Node *nd, int h, std::vector<Node *> &out)
+{
+    if (!nd || h <= 0)
+        return;
+
+    if (h == 1)
+    {
+        out.push_back(nd);
+        return;
+    }
+
+    // сначала верхняя половина уровней, затем по порядку все нижние поддеревья
+    int topH = h / 2;
+    collectVeb(nd, topH, out);
+
+    std::vector<Node *> bottoms;
+    collectAtDepth(nd, topH, bottoms);
+    for (std::size_t i = 0; i < bottoms.size(); ++i)
+        collectVeb(bottoms[i], h - topH, out);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::compact()
+{
+    if (!_root)
+        return;
+
+    std::vector<Node *> order;
+    collectVeb(_root, getHeight(_root), order);
+    std::size_t n = order.size();
+
+    // новые узлы: ключи и цвета — копии, связи пока указывают на старых детей
+    Node *arena = static_cast<Node *>(::operator new(n * sizeof(Node)));
+    std::shared_ptr<Arena> block;
+    try
+    {
+        block.reset(new Arena(arena, n));
+    }
+    catch (...)
+    {
+        ::operator delete(arena);
+        throw;
+    }
+
+    std::size_t built = 0;
+    try
+    {
+        for (; built < n; ++built)
+            new (arena + built) Node(order[built]->_key, nullptr, nullptr, nullptr, order[built]->_color);
+    }
+    catch (...)
+    {
+        for (std::size_t i = 0; i < built; ++i)
+            arena[i].~Node();
+        throw;
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        arena[i]._child[0] = order[i]->_child[0];
+        arena[i]._child[1] = order[i]->_child[1];
+#ifdef RBTREE_WITH_HASHING
+        arena[i]._hash = order[i]->_hash;
+#endif // RBTREE_WITH_HASHING
+    }
+
+    // старые родительские связи больше не нужны: превращаем их в адрес переезда
+    for (std::size_t i = 0; i < n; ++i)
+        order[i]->_parent = arena + i;
+
+    // переводим дочерние связи на новые адреса и восстанавливаем родителей
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        Node *nd = arena + i;
+        if (nd->_child[0])
+        {
+            nd->_child[0] = nd->_child[0]->_parent;
+            nd->_child[0]->_parent = nd;
+        }
+        if (nd->_child[1])
+        {
+            nd->_child[1] = nd->_child[1]->_parent;
+            nd->_child[1]->_parent = nd;
+        }
+    }
+
+    // корень лег первым; переключаемся на новые узлы и только потом, дождавшись
+    // читателей, которые могли войти в старые, освобождаем старые узлы и старый блок
+    _root = arena;
+    clearHot();
+
+    if (_reclaimer)
+        _reclaimer->synchronize();
+
+    // _arenas пока держит старые блоки, так что freeNode() отличит их узлы
+    for (std::size_t i = 0; i < n; ++i)
+        freeNode(order[i]);
+
+    _arenas.clear();
+    _arenas.push_back(block);
+}
+
+
+template<typename Element, typename Compar>
+int RBTree<Element, Compar>::getBlackHeight(const Node *nd)
+{
+    // черная высота одинакова на всех путях — считаем по левому краю
+    int h = 0;
+    for (; nd; nd = nd->_child[0])
+        if (nd->isBlack())
+            ++h;
+    return h;
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::joinNodes(Node *l, int lh, Node *k, Node *r, int rh, int &h)
+{
+    // корни частей делаем черными: для отдельного дерева это всегда допустимо
+    if (l)
+    {
+        l->_parent = nullptr;
+        if (l->isRed())
+        {
+            l->setBlack();
+            ++lh;
+        }
+    }
+    if (r)
+    {
+        r->_parent = nullptr;
+        if (r->isRed())
+        {
+            r->setBlack();
+            ++rh;
+        }
+    }
+
+    k->_parent = nullptr;
+
+    // равные высоты: k — новый черный корень
+    if (lh == rh)
+    {
+        k->_child[0] = l;
+        k->_child[1] = r;
+        if (l)
+            l->_parent = k;
+        if (r)
+            r->_parent = k;
+#ifdef RBTREE_WITH_HASHING
+        k->_hash += hashOf(l) + hashOf(r);
+#endif // RBTREE_WITH_HASHING
+        k->setBlack();
+        h = lh + 1;
+        return k;
+    }
+
+    // Спускаемся по краю более высокой части, обращенному к низкой, до черного узла
+    // той же черной высоты, что у низкой части, и ставим на его место красный k
+    // с ним и низкой частью в детях. Черные высоты не меняются, возможен лишь
+    // красный папа у k — его устраняет обычная перебалансировка вставки.
+    bool tallLeft = lh > rh;
+    Node *cur = tallLeft ? l : r;
+    int curH = tallLeft ? lh : rh;
+    int lowH = tallLeft ? rh : lh;
+    Node *dad = nullptr;
+    while (curH != lowH || (cur && cur->isRed()))
+    {
+        if (cur->isBlack())
+            --curH;
+        dad = cur;
+        cur = cur->_child[tallLeft];
+    }
+
+    k->setRed();
+    k->_child[!tallLeft] = cur;
+    k->_child[tallLeft] = tallLeft ? r : l;
+    dad->_child[tallLeft] = k;
+    k->_parent = dad;
+    if (k->_child[0])
+        k->_child[0]->_parent = k;
+    if (k->_child[1])
+        k->_child[1]->_parent = k;
+
+#ifdef RBTREE_WITH_HASHING
+    // k пришел со своим хешом; к нему добавляются дети, а к пути над ним — k и низкая часть
+    std::uint64_t added = k->_hash + hashOf(tallLeft ? r : l);
+    k->_hash += hashOf(k->_child[0]) + hashOf(k->_child[1]);
+    addHashUp(dad, added);
+#endif // RBTREE_WITH_HASHING
+
+    _root = tallLeft ? l : r;
+    h = tallLeft ? lh : rh;
+
+    Node *nd = k;
+    while (nd->isDaddyRed())
+        nd = rebalanceDUG(nd);
+
+    // перекраска, дошедшая до корня, делает его красным: чернение поднимает высоту
+    if (_root->isRed())
+    {
+        _root->setBlack();
+        ++h;
+    }
+
+    return _root;
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::release(std::vector<std::shared_ptr<Arena> > &arenas)
+{
+    Node *root = _root;
+    _root = nullptr;
+    _size.store(0);
+    clearHot();
+    arenas.insert(arenas.end(), _arenas.begin(), _arenas.end());
+    _arenas.clear();
+    return root;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::adoptArenas(const std::vector<std::shared_ptr<Arena> > &arenas)
+{
+    _arenas.insert(_arenas.end(), arenas.begin(), arenas.end());
+    sortArenas();
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::sortArenas()
+{
+    // O(A log A) вместо попарной проверки: один блок — одна запись; блоки, чьи узлы
+    // все уже разрушены, не нужны никому
+    _arenas.erase(std::remove_if(_arenas.begin(), _arenas.end(),
+                                 [](const std::shared_ptr<Arena> &a) { return a->isEmpty(); }),
+                  _arenas.end());
+    std::sort(_arenas.begin(), _arenas.end(),
+              [](const std::shared_ptr<Arena> &a, const std::shared_ptr<Arena> &b) { return a->begin() < b->begin(); });
+    _arenas.erase(std::unique(_arenas.begin(), _arenas.end()), _arenas.end());
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::splitNodes(Node *t, int th, const Element &key, Node *&l, int &lh, Node *&r, int &rh)
+{
+    if (!t)
+    {
+        l = r = nullptr;
+        lh = rh = 0;
+        return nullptr;
+    }
+
+    // Спускаемся по пути поиска; на возврате узел пути вместе с поддеревом, не лежащим
+    // на пути, приклеивается к левой или правой части, собранной ниже.
+    Node *lc, *rc;
+    int ch;
+    expose(t, th, lc, rc, ch);
+
+    if (_compar(key, t->_key))
+    {
+        // путь ушел влево: t и правое поддерево — в правую часть, после собранной
+        Node *found = splitNodes(lc, ch, key, l, lh, r, rh);
+        r = joinNodes(r, rh, t, rc, ch, rh);
+        return found;
+    }
+
+    if (_compar(t->_key, key))
+    {
+        Node *found = splitNodes(rc, ch, key, l, lh, r, rh);
+        l = joinNodes(lc, ch, t, l, lh, lh);
+        return found;
+    }
+
+    // сам key; ниже по пути ничего нет
+    l = lc;
+    r = rc;
+    lh = rh = ch;
+    if (l)
+        l->_parent = nullptr;
+    if (r)
+        r->_parent = nullptr;
+    return t;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::split(const Element &key, RBTree &left, RBTree &right)
+{
+    if (&left == &right || (&left != this && !left.isEmpty()) || (&right != this && !right.isEmpty()))
+        throw std::invalid_argument("Split targets must be distinct and empty");
+
+    std::vector<Element> before = dumperSnapshot();
+
+    int th = getBlackHeight(_root);
+    std::vector<std::shared_ptr<Arena> > arenas;
+    Node *t = release(arenas);
+
+    // склейки идут в контексте пустого дерева, так что вращения не трогают других деревьев
+    ScratchTree ctx(_compar);
+    Node *l = nullptr;
+    Node *r = nullptr;
+    int lh = 0;
+    int rh = 0;
+    Node *found = ctx.splitNodes(t, th, key, l, lh, r, rh);
+
+    // сам key — наименьший в правой части
+    if (found)
+        r = ctx.joinNodes(nullptr, 0, found, r, rh, rh);
+
+    if (l)
+    {
+        l->_parent = nullptr;
+        l->setBlack();
+    }
+    if (r)
+    {
+        r->_parent = nullptr;
+        r->setBlack();
+    }
+
+    left._root = l;
+    right._root = r;
+
+    // размеры частей без обхода неизвестны — их посчитает getSize(), если понадобится
+    left._size.store(l ? SIZE_UNKNOWN : 0);
+    right._size.store(r ? SIZE_UNKNOWN : 0);
+
+    // блоки compact() могут понадобиться обеим частям
+    left.adoptArenas(arenas);
+    right.adoptArenas(arenas);
+
+    // части, отличные от этого дерева, были пустыми
+    std::vector<Element> none;
+    if (&left != this && &right != this)
+        dumpBulkChange(before);
+    left.dumpBulkChange(&left == this ? before : none);
+    right.dumpBulkChange(&right == this ? before : none);
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::join2Nodes(Node *l, int lh, Node *r, int rh, int &h)
+{
+    if (!l || !r)
+    {
+        Node *t = l ? l : r;
+        h = l ? lh : rh;
+        if (t)
+            t->_parent = nullptr;
+        return t;
+    }
+
+    // разделителем служит наименьший узел r; вынимаем его в контексте этого дерева
+    r->_parent = nullptr;
+    r->setBlack();
+    _root = r;
+    Node *k = r;
+    while (k->_child[0])
+        k = k->_child[0];
+    unlinkNode(k, false);
+    k->_child[0] = k->_child[1] = k->_parent = nullptr;
+
+    r = _root;
+    _root = nullptr;
+    return joinNodes(l, lh, k, r, getBlackHeight(r), h);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::expose(Node *t, int th, Node *&l, Node *&r, int &ch)
+{
+    l = t->_child[0];
+    r = t->_child[1];
+    ch = th - (t->isBlack() ? 1 : 0);
+#ifdef RBTREE_WITH_HASHING
+    t->_hash = ownHashOf(t);
+#endif // RBTREE_WITH_HASHING
+    t->_child[0] = t->_child[1] = t->_parent = nullptr;
+}
+
+
+template<typename Element, typename Compar>
+class RBTree<Element, Compar>::ScratchTree : public RBTree<Element, Compar>
+{
+public:
+    explicit ScratchTree(const Compar &compar) { this->_compar = compar; }
+
+    // узлы принадлежат настоящему дереву — базовый деструктор не должен их трогать
+    ~ScratchTree() { this->_root = nullptr; }
+}; // class RBTree::ScratchTree
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::forkSetOp(SetOp op, Node *l1, Node *l2, int lh2, Node *r1, Node *r2, int rh2, int ch,
+                                        Node *&tl, int &hl, Node *&tr, int &hr,
+                                        std::vector<Node *> &dropped, TaskPool *pool)
+{
+    if (!pool || ch < PARALLEL_MIN_BLACK_HEIGHT)
+    {
+        tl = (this->*op)(l1, ch, l2, lh2, hl, dropped, pool);
+        tr = (this->*op)(r1, ch, r2, rh2, hr, dropped, pool);
+        return;
+    }
+
+    // у второй половины свой контекст вращений и свой список выброшенного
+    ScratchTree ctx(_compar);
+    std::vector<Node *> rightDropped;
+    pool->invoke(
+        [&]() { tl = (this->*op)(l1, ch, l2, lh2, hl, dropped, pool); },
+        [&]() { tr = (ctx.*op)(r1, ch, r2, rh2, hr, rightDropped, pool); });
+    dropped.insert(dropped.end(), rightDropped.begin(), rightDropped.end());
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::unionNodes(Node *t1, int h1, Node *t2, int h2, int &h,
+                                    std::vector<Node *> &dropped, TaskPool *pool)
+{
+    if (!t1 || !t2)
+        return join2Nodes(t1, h1, t2, h2, h);
+
+    Node *l1, *r1, *l2, *r2;
+    int ch, lh2, rh2;
+    expose(t1, h1, l1, r1, ch);
+    Node *found = splitNodes(t2, h2, t1->_key, l2, lh2, r2, rh2);
+    if (found)
+        dropped.push_back(found);               // остается узел этого дерева
+
+    Node *tl, *tr;
+    int hl, hr;
+    forkSetOp(&RBTree::unionNodes, l1, l2, lh2, r1, r2, rh2, ch, tl, hl, tr, hr, dropped, pool);
+    return joinNodes(tl, hl, t1, tr, hr, h);
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::intersectNodes(Node *t1, int h1, Node *t2, int h2, int &h,
+                                        std::vector<Node *> &dropped, TaskPool *pool)
+{
+    if (!t1 || !t2)
+    {
+        if (t1 || t2)
+            dropped.push_back(t1 ? t1 : t2);
+        h = 0;
+        return nullptr;
+    }
+
+    Node *l1, *r1, *l2, *r2;
+    int ch, lh2, rh2;
+    expose(t1, h1, l1, r1, ch);
+    Node *found = splitNodes(t2, h2, t1->_key, l2, lh2, r2, rh2);
+
+    Node *tl, *tr;
+    int hl, hr;
+    forkSetOp(&RBTree::intersectNodes, l1, l2, lh2, r1, r2, rh2, ch, tl, hl, tr, hr, dropped, pool);
+
+    if (found)
+    {
+        dropped.push_back(found);
+        return joinNodes(tl, hl, t1, tr, hr, h);
+    }
+
+    dropped.push_back(t1);
+    return join2Nodes(tl, hl, tr, hr, h);
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::differenceNodes(Node *t1, int h1, Node *t2, int h2, int &h,
+                                         std::vector<Node *> &dropped, TaskPool *pool)
+{
+    if (!t1 || !t2)
+    {
+        if (t2)
+            dropped.push_back(t2);
+        h = h1;
+        if (t1)
+            t1->_parent = nullptr;
+        return t1;
+    }
+
+    Node *l1, *r1, *l2, *r2;
+    int ch, lh2, rh2;
+    expose(t1, h1, l1, r1, ch);
+    Node *found = splitNodes(t2, h2, t1->_key, l2, lh2, r2, rh2);
+
+    Node *tl, *tr;
+    int hl, hr;
+    forkSetOp(&RBTree::differenceNodes, l1, l2, lh2, r1, r2, rh2, ch, tl, hl, tr, hr, dropped, pool);
+
+    if (!found)
+        return joinNodes(tl, hl, t1, tr, hr, h);
+
+    dropped.push_back(found);
+    dropped.push_back(t1);
+    return join2Nodes(tl, hl, tr, hr, h);
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::differenceSortedNodes(Node *t1, int h1, const Element *first, const Element *last, int &h,
+                                               std::vector<Node *> &dropped, TaskPool *pool)
+{
+    if (!t1 || first == last)
+    {
+        h = h1;
+        if (t1)
+            t1->_parent = nullptr;
+        return t1;
+    }
+
+    Node *l1, *r1;
+    int ch;
+    expose(t1, h1, l1, r1, ch);
+    const Element *mid = std::lower_bound(first, last, t1->_key, _compar);
+    bool found = (mid != last && !_compar(t1->_key, *mid));
+    const Element *rightFirst = found ? mid + 1 : mid;
+
+    Node *tl, *tr;
+    int hl, hr;
+    if (!pool || ch < PARALLEL_MIN_BLACK_HEIGHT)
+    {
+        tl = differenceSortedNodes(l1, ch, first, mid, hl, dropped, pool);
+        tr = differenceSortedNodes(r1, ch, rightFirst, last, hr, dropped, pool);
+    }
+    else
+    {
+        // как в forkSetOp(): у второй половины свой контекст вращений и список выброшенного
+        ScratchTree ctx(_compar);
+        std::vector<Node *> rightDropped;
+        pool->invoke(
+            [&]() { tl = differenceSortedNodes(l1, ch, first, mid, hl, dropped, pool); },
+            [&]() { tr = ctx.differenceSortedNodes(r1, ch, rightFirst, last, hr, rightDropped, pool); });
+        dropped.insert(dropped.end(), rightDropped.begin(), rightDropped.end());
+    }
+
+    if (!found)
+        return joinNodes(tl, hl, t1, tr, hr, h);
+
+    dropped.push_back(t1);
+    return join2Nodes(tl, hl, tr, hr, h);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::runSetOp(SetOp op, RBTree &other, TaskPool *pool)
+{
+    if (&other == this)
+        throw std::invalid_argument("Set operation argument must be another tree");
+
+    std::vector<Element> before = dumperSnapshot();
+    std::vector<Element> otherBefore = other.dumperSnapshot();
+
+    // все узлы обоих деревьев либо попадут в результат, либо будут выброшены
+    std::size_t total = addSizes(_size.load(), other._size.load());
+
+    int h1 = getBlackHeight(_root);
+    int h2 = getBlackHeight(other._root);
+    std::vector<std::shared_ptr<Arena> > arenas;
+    Node *t2 = other.release(arenas);
+    Node *t1 = _root;
+    _root = nullptr;
+
+    // рекурсия идет в контексте пустого дерева: отладочных событий о промежуточных
+    // состояниях нет, а _root этого дерева не трогается до конца
+    std::vector<Node *> dropped;
+    int h = 0;
+    ScratchTree ctx(_compar);
+    Node *root = (ctx.*op)(t1, h1, t2, h2, h, dropped, pool);
+    if (root)
+    {
+        root->_parent = nullptr;
+        root->setBlack();
+    }
+    _root = root;
+
+    // Узлы из блоков other должны опознаваться при освобождении. Блок, все узлы которого
+    // выброшены (например, аргумент difference()), освобождается вместе с последним из них
+    // и при следующем поиске уходит из _arenas.
+    adoptArenas(arenas);
+    _size.store(total);
+    adjustSize(0, dropNodes(dropped));
+    pruneArenas();
+
+    dumpBulkChange(before);
+    other.dumpBulkChange(otherBefore);
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void RBTree<Element, Compar>::insertBatch(InputIt first, InputIt last, TaskPool *pool)
+{
+    std::vector<Element> keys(first, last);
+    if (keys.empty())
+        return;
+
+    if (pool)
+        pool->sort(keys.begin(), keys.end(), _compar);
+    else
+        std::sort(keys.begin(), keys.end(), _compar);
+
+    // после сортировки равные рядом: соседи равны, если левый не меньше правого
+    Compar compar = _compar;
+    keys.erase(std::unique(keys.begin(), keys.end(),
+                           [&compar](const Element &a, const Element &b) { return !compar(a, b); }),
+               keys.end());
+
+    RBTree batch;
+    batch._compar = _compar;
+    batch._root = buildSorted(keys.begin(), keys.size());
+    batch._size.store(keys.size());
+
+    unionWith(batch, pool);
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::buildSorted(InputIt first, std::size_t n)
+{
+    if (n == 0)
+        return nullptr;
+
+    std::vector<Node *> nodes;
+    nodes.reserve(n);
+    try
+    {
+        for (; nodes.size() < n; ++first)
+            nodes.push_back(new Node(*first, nullptr, nullptr, nullptr, BLACK));
+    }
+    catch (...)
+    {
+        for (std::size_t i = 0; i < nodes.size(); ++i)
+            delete nodes[i];
+        throw;
+    }
+
+    return linkSorted(static_cast<Node *const *>(nodes.data()), n);
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void RBTree<Element, Compar>::assignSorted(InputIt first, std::size_t n)
+{
+    if (!isEmpty())
+        throw std::invalid_argument("Target tree must be empty");
+    if (n == 0)
+        return;
+
+    // все узлы — в одном блоке, по порядку ключей
+    Node *arena = static_cast<Node *>(::operator new(n * sizeof(Node)));
+    std::shared_ptr<Arena> block;
+    try
+    {
+        block.reset(new Arena(arena, n));
+    }
+    catch (...)
+    {
+        ::operator delete(arena);
+        throw;
+    }
+
+    std::size_t built = 0;
+    try
+    {
+        for (; built < n; ++built, ++first)
+            new (arena + built) Node(*first, nullptr, nullptr, nullptr, BLACK);
+    }
+    catch (...)
+    {
+        for (std::size_t i = 0; i < built; ++i)
+            arena[i].~Node();
+        throw;
+    }
+
+    _arenas.push_back(block);
+    sortArenas();
+    _root = linkSorted(arena, n);
+    _size.store(n);
+    dumpBulkChange(std::vector<Element>());
+}
+
+
+template<typename Element, typename Compar>
+template<typename InputIt>
+void RBTree<Element, Compar>::assignSorted(InputIt first, InputIt last, std::size_t maxN)
+{
+    if (!isEmpty())
+        throw std::invalid_argument("Target tree must be empty");
+
+    // Число элементов известно лишь сверху, поэтому блоки по SORTED_CHUNK узлов выделяются
+    // по мере прихода элементов: без узлов остается разве что хвост последнего блока.
+    std::vector<std::shared_ptr<Arena> > chunks;
+    std::vector<Node *> starts;
+    std::size_t n = 0;
+    try
+    {
+        for (; first != last; ++first, ++n)
+        {
+            if (n == maxN)
+                throw std::invalid_argument("More sorted elements than declared");
+
+            if (n % SORTED_CHUNK == 0)
+            {
+                std::size_t size = std::min(SORTED_CHUNK, maxN - n);
+                Node *mem = static_cast<Node *>(::operator new(size * sizeof(Node)));
+                std::shared_ptr<Arena> chunk;
+                try
+                {
+                    chunk.reset(new Arena(mem, size));
+                }
+                catch (...)
+                {
+                    ::operator delete(mem);
+                    throw;
+                }
+                chunks.push_back(chunk);
+                starts.push_back(mem);
+            }
+
+            new (nodeAt(ChunkedNodes(starts.data()), n)) Node(*first, nullptr, nullptr, nullptr, BLACK);
+        }
+    }
+    catch (...)
+    {
+        // память блоков освободят их деструкторы: счетчики живых еще не выставлены
+        for (std::size_t i = 0; i < n; ++i)
+            nodeAt(ChunkedNodes(starts.data()), i)->~Node();
+        throw;
+    }
+
+    if (n == 0)
+        return;
+
+    // хвост последнего блока остается без узлов: живых в нем столько, сколько построено
+    chunks.back()->live.store(n - (chunks.size() - 1) * SORTED_CHUNK);
+    _arenas.insert(_arenas.end(), chunks.begin(), chunks.end());
+    sortArenas();
+    _root = linkSorted(ChunkedNodes(starts.data()), n);
+    _size.store(n);
+    dumpBulkChange(std::vector<Element>());
+}
+
+
+template<typename Element, typename Compar>
+template<typename Traits>
+void RBTree<Element, Compar>::serialize(std::ostream &os) const
+{
+    serial::writeStream<Traits>(os, getSize(), [this](auto &write) { forEachNodes(_root, write); });
+}
+
+
+template<typename Element, typename Compar>
+template<typename Traits>
+void RBTree<Element, Compar>::deserialize(std::istream &is)
+{
+    if (!isEmpty())
+        throw std::invalid_argument("Deserialize target must be empty");
+
+    // Элементы идут прямо в узлы, без промежуточного вектора. Число из заголовка не проверено,
+    // поэтому лишь ограничивает их: узлы выделяются блоками по мере чтения.
+    serial::StreamReader<Traits, Element, Compar> reader(is, _compar);
+    std::uint64_t n = reader.getSize();
+    std::size_t maxN = (n < static_cast<std::uint64_t>(~std::size_t(0))) ? static_cast<std::size_t>(n) : ~std::size_t(0);
+    assignSorted(reader.begin(), reader.end(), maxN);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::diff(const RBTree &other, RBTreeDelta<Element, Compar> &delta) const
+{
+    delta.clear();
+
+#ifdef RBTREE_WITH_HASHING
+    diffNodes(_root, nullptr, nullptr, other, delta);
+#else
+    ConstIterator a = begin();
+    ConstIterator b = other.begin();
+    while (a != end() && b != other.end())
+    {
+        if (_compar(*a, *b))
+            delta.removes.push_back(*a++);
+        else if (_compar(*b, *a))
+            delta.inserts.push_back(*b++);
+        else
+        {
+            ++a;
+            ++b;
+        }
+    }
+
+    for (; a != end(); ++a)
+        delta.removes.push_back(*a);
+    for (; b != other.end(); ++b)
+        delta.inserts.push_back(*b);
+#endif // RBTREE_WITH_HASHING
+}
+
+
+template<typename Element, typename Compar>
+bool RBTree<Element, Compar>::isEqual(const RBTree &other) const
+{
+#ifdef RBTREE_WITH_HASHING
+    if (contentHash() != other.contentHash())
+        return false;
+#endif // RBTREE_WITH_HASHING
+
+    ConstIterator a = begin();
+    ConstIterator b = other.begin();
+    for (; a != end() && b != other.end(); ++a, ++b)
+        if (_compar(*a, *b) || _compar(*b, *a))
+            return false;
+
+    return a == end() && b == other.end();
+}
+
+
+#ifdef RBTREE_WITH_HASHING
+
+template<typename Element, typename Compar>
+std::uint64_t RBTree<Element, Compar>::hashBelow(const Element &key, bool inclusive) const
+{
+    // уходя вправо, берем узел вместе с левым поддеревом
+    std::uint64_t sum = 0;
+    const Node *nd = _root;
+    while (nd)
+    {
+        if (inclusive ? !_compar(key, nd->_key) : _compar(nd->_key, key))
+        {
+            sum += nd->_hash - hashOf(nd->_child[1]);
+            nd = nd->_child[1];
+        }
+        else
+            nd = nd->_child[0];
+    }
+    return sum;
+}
+
+
+template<typename Element, typename Compar>
+std::uint64_t RBTree<Element, Compar>::rangeHash(const Element *lo, const Element *hi) const
+{
+    std::uint64_t sum = hi ? hashBelow(*hi, false) : hashOf(_root);
+    if (lo)
+        sum -= hashBelow(*lo, true);
+    return sum;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::diffNodes(const Node *nd, const Element *lo, const Element *hi, const RBTree &other,
+                                        RBTreeDelta<Element, Compar> &delta) const
+{
+    // те же ключи в том же интервале дают ту же сумму: поддерево совпадает, спускаться незачем
+    if (other.rangeHash(lo, hi) == hashOf(nd))
+        return;
+
+    if (!nd)
+    {
+        // здесь интервал пуст — вставляются все ключи other из него
+        const Node *cur = nullptr;
+        for (const Node *x = other._root; x; )
+        {
+            if (lo && !_compar(*lo, x->_key))
+                x = x->_child[1];
+            else
+            {
+                cur = x;
+                x = x->_child[0];
+            }
+        }
+        for (; cur && (!hi || _compar(cur->_key, *hi)); cur = nextNode(cur))
+            delta.inserts.push_back(cur->_key);
+        return;
+    }
+
+    // по возрастанию: левое поддерево, сам узел, правое
+    diffNodes(nd->_child[0], lo, &nd->_key, other, delta);
+
+    ConstIterator it = other.lowerBound(nd->_key);
+    if (it == other.end() || _compar(nd->_key, *it))
+        delta.removes.push_back(nd->_key);
+
+    diffNodes(nd->_child[1], &nd->_key, hi, other, delta);
+}
+
+#endif // RBTREE_WITH_HASHING
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::applyDelta(const RBTreeDelta<Element, Compar> &delta, TaskPool *pool)
+{
+    if (!delta.removes.empty() && _root)
+    {
+        // как в runSetOp(): рекурсия в контексте пустого дерева, _root — только в конце
+        std::vector<Element> before = dumperSnapshot();
+        const Element *first = delta.removes.data();
+        std::vector<Node *> dropped;
+        int h = 0;
+        Node *t1 = _root;
+        _root = nullptr;
+        ScratchTree ctx(_compar);
+        Node *root = ctx.differenceSortedNodes(t1, getBlackHeight(t1), first, first + delta.removes.size(),
+                                               h, dropped, pool);
+        if (root)
+        {
+            root->_parent = nullptr;
+            root->setBlack();
+        }
+        _root = root;
+        adjustSize(0, dropNodes(dropped));
+        dumpBulkChange(before);
+    }
+
+    // вставки дамперу сообщит unionWith()
+    if (!delta.inserts.empty())
+    {
+        RBTree inserts;
+        inserts._compar = _compar;
+        inserts._root = buildSorted(delta.inserts.begin(), delta.inserts.size());
+        inserts._size.store(delta.inserts.size());
+        unionWith(inserts, pool);
+    }
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void RBTree<Element, Compar>::parallelForEach(F fn, TaskPool *pool) const
+{
+    parallelForEachNodes(_root, pool ? pool->getSplitDepth() : 0, fn, pool);
+}
+
+
+template<typename Element, typename Compar>
+template<typename T, typename Map, typename Combine>
+T RBTree<Element, Compar>::parallelReduce(const T &identity, Map map, Combine combine, TaskPool *pool) const
+{
+    return reduceNodes(_root, pool ? pool->getSplitDepth() : 0, identity, map, combine, pool);
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void RBTree<Element, Compar>::forEachNodes(const Node *nd, F &fn)
+{
+    // стек левого края: глубина дерева O(log n), так что стек невелик
+    std::vector<const Node *> stack;
+    const Node *cur = nd;
+    while (cur || !stack.empty())
+    {
+        for (; cur; cur = cur->_child[0])
+            stack.push_back(cur);
+
+        cur = stack.back();
+        stack.pop_back();
+        fn(cur->_key);
+        cur = cur->_child[1];
+    }
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void RBTree<Element, Compar>::parallelForEachNodes(const Node *nd, int depth, F &fn, TaskPool *pool)
+{
+    if (!nd)
+        return;
+
+    if (depth <= 0 || !pool)
+    {
+        forEachNodes(nd, fn);
+        return;
+    }
+
+    pool->invoke([&]() { parallelForEachNodes(nd->_child[0], depth - 1, fn, pool); },
+                 [&]() { parallelForEachNodes(nd->_child[1], depth - 1, fn, pool); });
+    fn(nd->_key);
+}
+
+
+template<typename Element, typename Compar>
+template<typename T, typename Map, typename Combine>
+T RBTree<Element, Compar>::reduceNodes(const Node *nd, int depth, const T &identity,
+                                        Map &map, Combine &combine, TaskPool *pool)
+{
+    if (!nd)
+        return identity;
+
+    if (depth <= 0 || !pool)
+    {
+        T acc = identity;
+        auto step = [&](const Element &key) { acc = combine(acc, map(key)); };
+        forEachNodes(nd, step);
+        return acc;
+    }
+
+    T left = identity;
+    T right = identity;
+    pool->invoke([&]() { left = reduceNodes(nd->_child[0], depth - 1, identity, map, combine, pool); },
+                 [&]() { right = reduceNodes(nd->_child[1], depth - 1, identity, map, combine, pool); });
+
+    // порядок ключей: левое поддерево, узел, правое
+    return combine(combine(left, map(nd->_key)), right);
+}
+
+
+template<typename Element, typename Compar>
+template<typename Nodes>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::linkSorted(Nodes nodes, std::size_t n)
+{
+    // полных уровней — floor(log2(n + 1)); узлы ниже них красные
+    int fullLevels = 0;
+    while ((std::size_t(2) << fullLevels) - 1 <= n)
+        ++fullLevels;
+
+    Node *root = linkSorted(nodes, 0, n, 0, fullLevels);
+    root->_parent = nullptr;
+    return root;
+}
+
+
+template<typename Element, typename Compar>
+template<typename Nodes>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::linkSorted(Nodes nodes, std::size_t lo, std::size_t hi, int depth, int redDepth)
+{
+    if (lo >= hi)
+        return nullptr;
+
+    std::size_t mid = lo + (hi - lo) / 2;
+    Node *nd = nodeAt(nodes, mid);
+    nd->_color = (depth == redDepth) ? RED : BLACK;
+
+    nd->_child[0] = linkSorted(nodes, lo, mid, depth + 1, redDepth);
+    nd->_child[1] = linkSorted(nodes, mid + 1, hi, depth + 1, redDepth);
+    if (nd->_child[0])
+        nd->_child[0]->_parent = nd;
+    if (nd->_child[1])
+        nd->_child[1]->_parent = nd;
+#ifdef RBTREE_WITH_HASHING
+    nd->_hash += hashOf(nd->_child[0]) + hashOf(nd->_child[1]);
+#endif // RBTREE_WITH_HASHING
+
+    return nd;
+}
+
+
+template<typename Element, typename Compar>
+std::vector<Element> RBTree<Element, Compar>::dumperSnapshot() const
+{
+    std::vector<Element> keys;
+    if (_dumper)
+        for (const Node *nd = minNode(_root); nd; nd = nextNode(nd))
+            keys.push_back(nd->_key);
+    return keys;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::dumpBulkChange(const std::vector<Element> &before)
+{
+    if (!_dumper)
+        return;
+
+    // слияние прежних ключей с нынешними по возрастанию
+    typename std::vector<Element>::const_iterator old = before.begin();
+    const Node *nd = minNode(_root);
+    while (old != before.end() || nd)
+    {
+        if (nd && (old == before.end() || _compar(nd->_key, *old)))
+        {
+            _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_INSERT, this, const_cast<Node *>(nd));
+            nd = nextNode(nd);
+        }
+        else if (!nd || _compar(*old, nd->_key))
+        {
+#ifdef RBTREE_WITH_DELETION
+            // узла ушедшего ключа уже нет: дамперу — временный с тем же ключом
+            Node gone(*old);
+            _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_REMOVE, this, &gone);
+#endif // RBTREE_WITH_DELETION
+            ++old;
+        }
+        else
         {
-            // ищем у родителя, кем был этот элемент, и вместо него ставим бублик
-            if (lf->_parent->_left == lf)
-                lf->_parent->_left = nullptr;
-            else                                    // доп. не проверяем, что он был правым, иначе нарушение целостности
-                lf->_parent->_right = nullptr;
+            ++old;
+            nd = nextNode(nd);
         }
+    }
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::dumpJoin(RBTree &left, const std::vector<Element> &leftBefore, RBTree &right,
+                                       const std::vector<Element> &rightBefore, const std::vector<Element> &before)
+{
+    // исходные деревья, отличные от этого, опустели
+    if (&left != this)
+        left.dumpBulkChange(leftBefore);
+    if (&right != this)
+        right.dumpBulkChange(rightBefore);
+    dumpBulkChange(before);
+}
+
+
+template<typename Element, typename Compar>
+std::size_t RBTree<Element, Compar>::dropNodes(const std::vector<Node *> &dropped)
+{
+    std::size_t n = 0;
+    std::vector<Node *> stack(dropped);
+    while (!stack.empty())
+    {
+        Node *cur = stack.back();
+        stack.pop_back();
+
+        if (cur->_child[0])
+            stack.push_back(cur->_child[0]);
+        if (cur->_child[1])
+            stack.push_back(cur->_child[1]);
+
+        retireNode(cur);
+        ++n;
+    }
+    return n;
+}
+
+
+template<typename Element, typename Compar>
+std::size_t RBTree<Element, Compar>::getSize() const
+{
+    std::size_t n = _size.load(std::memory_order_relaxed);
+    if (n != SIZE_UNKNOWN)
+        return n;
+
+    // читатели, посчитавшие одновременно, запишут одно и то же
+    n = 0;
+    for (const Node *nd = minNode(_root); nd; nd = nextNode(nd))
+        ++n;
+    _size.store(n, std::memory_order_relaxed);
+    return n;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::adjustSize(std::size_t added, std::size_t removed)
+{
+    std::size_t n = _size.load(std::memory_order_relaxed);
+    if (n != SIZE_UNKNOWN)
+        _size.store(n + added - removed, std::memory_order_relaxed);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::unionWith(RBTree &other, TaskPool *pool)
+{
+    runSetOp(&RBTree::unionNodes, other, pool);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::intersect(RBTree &other, TaskPool *pool)
+{
+    runSetOp(&RBTree::intersectNodes, other, pool);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::difference(RBTree &other, TaskPool *pool)
+{
+    runSetOp(&RBTree::differenceNodes, other, pool);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::checkJoinOrder(const Node *left, const Element &pivot, const Node *right) const
+{
+    if (left)
+    {
+        const Node *mx = left;
+        while (mx->_child[1])
+            mx = mx->_child[1];
+        if (!_compar(mx->_key, pivot))
+            throw std::invalid_argument("Left tree must be less than pivot");
+    }
+
+    if (right)
+    {
+        const Node *mn = minNode(right);
+        if (!_compar(pivot, mn->_key))
+            throw std::invalid_argument("Right tree must be greater than pivot");
+    }
+}
+
 
-        // задаем нового родителя
-        lf->_parent = this;
-    }
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::join(RBTree &left, const Element &pivot, RBTree &right)
+{
+    if (&left == &right || (this != &left && this != &right && !isEmpty()))
+        throw std::invalid_argument("Join target must be empty or one of the joined trees");
 
-    // если у текущего уже был один левый — отменяем его родительскую связь и вернем его
-    Node *prevLeft = _left;
-    _left = lf;
+    checkJoinOrder(left._root, pivot, right._root);
 
-    if (prevLeft)
-        prevLeft->_parent = nullptr;
+    std::vector<Element> before = dumperSnapshot();
+    std::vector<Element> leftBefore = left.dumperSnapshot();
+    std::vector<Element> rightBefore = right.dumperSnapshot();
 
-    return prevLeft;
+    Node *k = new Node(pivot, nullptr, nullptr, nullptr, RED);
+    std::size_t total = addSizes(addSizes(left._size.load(), right._size.load()), 1);
+
+    std::vector<std::shared_ptr<Arena> > arenas;
+    Node *l = left.release(arenas);
+    Node *r = right.release(arenas);
+
+    int h = 0;
+    _root = joinNodes(l, getBlackHeight(l), k, r, getBlackHeight(r), h);
+    _size.store(total);
+    adoptArenas(arenas);
+
+    dumpJoin(left, leftBefore, right, rightBefore, before);
 }
 
 
 template<typename Element, typename Compar>
-typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::Node::setRight(Node *rg)
+void RBTree<Element, Compar>::join(RBTree &left, RBTree &right)
 {
-    // предупреждаем повторное присвоение
-    if (_right == rg)
-        return nullptr;
+    if (&left == &right || (this != &left && this != &right && !isEmpty()))
+        throw std::invalid_argument("Join target must be empty or one of the joined trees");
+
+    std::vector<Element> before = dumperSnapshot();
+    std::vector<Element> leftBefore = left.dumperSnapshot();
+    std::vector<Element> rightBefore = right.dumperSnapshot();
 
-    // если новый правый — действительный элемент
-    if (rg)
+    // разделитель переходит из правого дерева вместе с остальными узлами
+    std::size_t total = addSizes(left._size.load(), right._size.load());
+
+    if (right.isEmpty())
     {
-        // если у него был родитель
-        if (rg->_parent)
-        {
-            // ищем у родителя, кем был этот элемент, и вместо него ставим бублик
-            if (rg->_parent->_left == rg)
-                rg->_parent->_left = nullptr;
-            else                                    // доп. не проверяем, что он был правым, иначе нарушение целостности
-                rg->_parent->_right = nullptr;
-        }
+        std::vector<std::shared_ptr<Arena> > arenas;
+        Node *l = left.release(arenas);
+        _root = l;
+        _size.store(total);
+        adoptArenas(arenas);
+        dumpJoin(left, leftBefore, right, rightBefore, before);
+        return;
+    }
 
-        // задаем нового родителя
-        rg->_parent = this;
+    // разделителем служит наименьший узел правого дерева
+    Node *k = const_cast<Node *>(minNode(right._root));
+    checkJoinOrder(left._root, k->_key, nullptr);
+    right.unlinkNode(k, false);
+    k->_child[0] = k->_child[1] = k->_parent = nullptr;
+
+    std::vector<std::shared_ptr<Arena> > arenas;
+    Node *l = left.release(arenas);
+    Node *r = right.release(arenas);
+
+    int h = 0;
+    _root = joinNodes(l, getBlackHeight(l), k, r, getBlackHeight(r), h);
+    _size.store(total);
+    adoptArenas(arenas);
+
+    dumpJoin(left, leftBefore, right, rightBefore, before);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::insert(const Element &key)
+{
+    // балансировка по ходу спуска, без второго прохода
+    if (_insertMode == INSERT_TOP_DOWN)
+    {
+        Node *newNode = insertTopDown(key);
+        adjustSize(1, 0);
+
+        if (_dumper)
+            _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_INSERT, this, newNode);
+        return;
     }
 
-    // если у текущего уже был один левый — отменяем его родительскую связь и вернем его
-    Node *prevRight = _right;
-    _right = rg;
+    // этот метод можно оставить студентам целиком
+    Node *newNode = insertNewBstEl(key);
+
+    // отладочное событие
+    if (_dumper)
+        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_BST_INS, this, newNode);
+
+    rebalance(newNode);
+    adjustSize(1, 0);
 
-    if (prevRight)
-        prevRight->_parent = nullptr;
+    // отладочное событие
+    if (_dumper)
+        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_INSERT, this, newNode);
 
-    return prevRight;
 }
 
 
-//==============================================================================
-// class RBTree
-//==============================================================================
+template<typename Element, typename Compar>
+const typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::find(const Element &key) const
+{
+    // частый ключ отвечается из кэша без спуска
+    HotSlot *slot = nullptr;
+    std::uint64_t gen = 0;
+    if (_hotCache)
+    {
+        slot = &hotSlotOf(key);
+        const Node *hot = slot->load(std::memory_order_acquire);
+        if (hot && !_compar(key, hot->_key) && !_compar(hot->_key, key))
+            return hot;
+        gen = _hotGeneration.load();
+    }
+
+    const Node *node = findNode(key);
+    if (node && slot)
+        rememberHot(*slot, node, gen);
+    return node;
+}
+
 
 template<typename Element, typename Compar>
-RBTree<Element, Compar>::RBTree()
+void RBTree<Element, Compar>::rememberHot(HotSlot &slot, const Node *nd, std::uint64_t gen) const
 {
-    _root = nullptr;
-    _dumper = nullptr;
+    slot.store(nd);
+
+    // Писатель сначала увеличивает счетчик, потом выбрасывает узел. Если за время спуска
+    // счетчик не изменился, выбрасывание, затронувшее nd, еще впереди и увидит его в ячейке;
+    // иначе оно могло пройти раньше записи — убираем nd сами, пока его держит эпоха поиска.
+    if (_hotGeneration.load() != gen)
+    {
+        const Node *expected = nd;
+        slot.compare_exchange_strong(expected, nullptr);
+    }
 }
 
+
 template<typename Element, typename Compar>
-RBTree<Element, Compar>::~RBTree()
+void RBTree<Element, Compar>::evictHot(const Node *nd)
 {
-    // грохаем пока что всех через корень
-    if (_root)
-        delete _root;
+    if (!_hotCache)
+        return;
+
+    _hotGeneration.fetch_add(1);
+    const Node *expected = nd;
+    hotSlotOf(nd->_key).compare_exchange_strong(expected, nullptr);
 }
 
 
 template<typename Element, typename Compar>
-void RBTree<Element, Compar>::deleteNode(Node *nd)
+void RBTree<Element, Compar>::clearHot()
 {
-    // если переданный узел не существует, просто ничего не делаем, т.к. в вызывающем проверок нет
-    if (nd == nullptr)
+    if (!_hotCache)
         return;
 
-    // потомков убьет в деструкторе
-    delete nd;
+    _hotGeneration.fetch_add(1);
+    for (std::size_t i = 0; i <= _hotMask; ++i)
+        _hotCache[i].store(nullptr);
 }
 
 
 template<typename Element, typename Compar>
-void RBTree<Element, Compar>::insert(const Element &key)
+void RBTree<Element, Compar>::setHotCacheSize(std::size_t slots)
 {
-    // этот метод можно оставить студентам целиком
-    Node *newNode = insertNewBstEl(key);
+    static_assert(HasRBTreeKeyHash<Element>::value, "Specialize xi::RBTreeKeyHash to use the hot key cache");
 
-    // отладочное событие
-    if (_dumper)
-        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_BST_INS, this, newNode);
+    if (slots == 0)
+    {
+        _hotCache.reset();
+        _hotMask = 0;
+        return;
+    }
 
-    rebalance(newNode);
+    std::size_t size = 1;
+    while (size < slots)
+        size <<= 1;
 
-    // отладочное событие
-    if (_dumper)
-        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_INSERT, this, newNode);
+    std::unique_ptr<HotSlot[]> cache(new HotSlot[size]);
+    for (std::size_t i = 0; i < size; ++i)
+        cache[i].store(nullptr);
+
+    _hotCache.swap(cache);
+    _hotMask = size - 1;
+}
 
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::ConstIterator RBTree<Element, Compar>::lowerBound(const Element &key) const
+{
+    return ConstIterator(lowerBoundNode(_root, key));
 }
 
 
 template<typename Element, typename Compar>
-const typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::find(const Element &key)
+const typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::findNode(const Element &key) const
 {
-    //put a pointer to the root of the tree
-    Node *node = _root;
+    // Сторона спуска — индекс в _child, а не переход. Проверка равенства остается ветвлением,
+    // но почти всегда ложна и хорошо предсказывается, а найденный выше листа узел
+    // избавляет от промахов кэша на оставшихся уровнях.
+    const Node *node = _root;
+    while (node)
+    {
+        bool goRight = _compar(node->_key, key);
+        if (!goRight && !_compar(key, node->_key))
+            return node;
+        node = node->_child[goRight];
+    }
+
+    return nullptr;
+}
 
-    //cycle for running through the tree
+
+template<typename Element, typename Compar>
+const typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::lowerBoundNode(const Node *node, const Element &key) const
+{
+    // Последний узел, от которого ушли влево, — наименьший из не меньших key. Сторона
+    // спуска — индекс в _child, кандидат обновляется выбором, а не переходом: в цикле нет
+    // ветвлений, зависящих от ключей, и случайные ключи не срывают предсказание переходов.
+    const Node *res = nullptr;
     while (node)
     {
-        /** as the left child is less than the parent, and the right one is more,
-         then for finding we will need 2 checks and if neither one is fulfilled,
-         then we have found the necessary element */
-        if (key < node->getKey())
+        bool goRight = _compar(node->_key, key);
+        res = goRight ? res : node;
+        node = node->_child[goRight];
+    }
+
+    return res;
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::ConstIterator
+RBTree<Element, Compar>::lowerBound(ConstIterator finger, const Element &key) const
+{
+    const Node *node = finger.getNode();
+    if (!node)
+        return lowerBound(key);
+
+    // Поднимаемся, пока поддерево node не накроет key. Со стороны key поддерево ограничено
+    // ключом предка, к которому оно примыкает этой стороной: вперед — родителем, чей node
+    // левый сын, назад — родителем, чей node правый сын.
+    const Node *res = nullptr;
+    bool forward = !_compar(key, node->_key);
+    while (node->_parent)
+    {
+        const Node *dad = node->_parent;
+        if (forward && dad->_child[0] == node && !_compar(dad->_key, key))
+        {
+            res = dad;                          // ответ — в node или сам dad
+            break;
+        }
+        if (!forward && dad->_child[1] == node && _compar(dad->_key, key))
+            break;                              // ответ — в node, не дальше пальца
+        node = dad;
+    }
+
+    // дальше — обычный спуск lowerBound(), но от node
+    const Node *below = lowerBoundNode(node, key);
+    return ConstIterator(below ? below : res);
+}
+
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::ConstIterator
+RBTree<Element, Compar>::find(ConstIterator finger, const Element &key) const
+{
+    ConstIterator it = lowerBound(finger, key);
+    if (it != end() && !_compar(key, *it))
+        return it;
+    return end();
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::findBatch(const Element *keys, std::size_t n, const Node **out) const
+{
+    // текущие узлы спусков группы; nullptr — спуск завершен
+    const Node *cur[FIND_BATCH_GROUP];
+
+    for (std::size_t base = 0; base < n; base += FIND_BATCH_GROUP)
+    {
+        std::size_t groupSize = (n - base < FIND_BATCH_GROUP) ? (n - base) : FIND_BATCH_GROUP;
+        const Element *gKeys = keys + base;
+        const Node **gOut = out + base;
+
+        for (std::size_t i = 0; i < groupSize; ++i)
         {
-            node = node->getChild(true);    //go to the left child
-        } else
+            cur[i] = _root;
+            gOut[i] = nullptr;
+        }
+
+        // за проход опускаем каждый активный спуск на один уровень
+        std::size_t active = _root ? groupSize : 0;
+        while (active)
         {
-            if (key > node->getKey())   //if you hit this block, the key is greater than or equal to
+            active = 0;
+            for (std::size_t i = 0; i < groupSize; ++i)
             {
-                node = node->getChild(false);  //if you hit this block, then the key is larger, so go to the right child
-            } else
-            {
-                return node;    //if you hit this block, the key is found
-            }
+                const Node *nd = cur[i];
+                if (!nd)
+                    continue;
+
+                if (_compar(gKeys[i], nd->_key))
+                    nd = nd->_child[0];
+                else if (_compar(nd->_key, gKeys[i]))
+                    nd = nd->_child[1];
+                else
+                {
+                    gOut[i] = nd;
+                    nd = nullptr;
+                }
 
+                // следующий узел понадобится только через groupSize шагов — запрашиваем его заранее
+                if (nd)
+                {
+                    XI_RBTREE_PREFETCH(nd);
+                    ++active;
+                }
+                cur[i] = nd;
+            }
         }
     }
-    return nullptr;
 }
 
 template<typename Element, typename Compar>
 typename RBTree<Element, Compar>::Node *
 RBTree<Element, Compar>::insertNewBstEl(const Element &key)
 {
-    //create element to insert
-    Node *newElement = new Node(key, nullptr, nullptr, nullptr, RED);
+    // Спуск как в lowerBoundNode(), но с запоминанием отца и стороны: сторона — индекс
+    // в _child, а равенство (дубликат) проверяется один раз внизу по кандидату.
+    Node *parent = nullptr;
+    Node *cand = nullptr;
+    bool goRight = false;
+    for (Node *node = _root; node; node = node->_child[goRight])
+    {
+        parent = node;
+        goRight = _compar(node->_key, key);
+        cand = goRight ? cand : node;
+    }
+
+    if (cand && !_compar(key, cand->_key))
+        throw std::invalid_argument("Key already exist");
+
+    // узел создается только после проверки на дубликат
+    Node *newElement = new Node(key, nullptr, nullptr, parent, RED);
 
     //if the tree is empty, then add the root
-    if (isEmpty())
+    if (!parent)
     {
         _root = newElement;
 
@@ -201,39 +1838,11 @@ RBTree<Element, Compar>::insertNewBstEl(const Element &key)
         return newElement;
     }
 
-    //Create parently for parent
-    Node *parent = nullptr;
-
-    //pointer to the root
-    Node *node = _root;
-
-    //loop to find a place to insert
-    while (node)
-    {
-        /** It works on the same principle as find, but if you find such a key,
-         then we throw an exception. It is also necessary to remember the parent
-         in order to define our new node by the left or right child. */
-        parent = node;
-        if (key < node->getKey())
-        {
-            node = node->getChild(true);    //go to the left child
-        } else
-        {
-            if (key > node->getKey())   //if you hit this block, the key is greater than or equal to
-            {
-                node = node->getChild(false);  //if you hit this block, then the key is larger, so go to the right child
-            } else
-            {
-                throw std::invalid_argument("Key already exist");    //if you hit this block, the key is found
-            }
-        }
-    }
+    parent->_child[goRight] = newElement;
 
-    //add our new element to parent
-    if (key < parent->getKey())
-        parent->setLeft(newElement);    //if the key is smaller, then we put it with the left child
-    else
-        parent->setRight(newElement); //if greater or equal - right child
+#ifdef RBTREE_WITH_HASHING
+    addHashUp(parent, newElement->_hash);
+#endif // RBTREE_WITH_HASHING
 
     return newElement;
 }
@@ -241,259 +1850,365 @@ RBTree<Element, Compar>::insertNewBstEl(const Element &key)
 
 template<typename Element, typename Compar>
 typename RBTree<Element, Compar>::Node *
-RBTree<Element, Compar>::rebalanceDUG(Node *nd)
+RBTree<Element, Compar>::insertTopDown(const Element &key)
 {
-}
-
+    if (!_root)
+    {
+        _root = new Node(key, nullptr, nullptr, nullptr, BLACK);
+        return _root;
+    }
 
-template<typename Element, typename Compar>
-void RBTree<Element, Compar>::rebalance(Node *nd)
-{
-    Node *temp;
-    //as long as the parent is red
-    while (nd->_parent != nullptr && nd->_parent->isRed())
+    // Инвариант спуска: дети узлов на пути, пройденных после разделения, черные, поэтому
+    // дядя появившегося красного-красного всегда черный и поворотов хватает. Дерево
+    // корректно после каждого шага, так что и дубликат выбрасывается из корректного дерева.
+    // Равенство, как в insertNewBstEl(), проверяется один раз внизу по кандидату.
+    Node *dad = nullptr;
+    Node *node = _root;
+    Node *cand = nullptr;
+    Node *newElement = nullptr;
+    bool goRight = false;
+    for (;;)
     {
-        //check if the parent is the left child
-        if (nd->_parent == nd->_parent->_parent->_left)
+        if (!node)
         {
-            //then remember uncle
-            temp = nd->_parent->_parent->_right;
-            //if uncle is red case 1
-            if (temp != nullptr && temp->_color == RED)
-            {
-                //we paint parents black
-                nd->_parent->_color = BLACK;
-                //Uncle paint in black
-                temp->_color = BLACK;
-                //grandpa in red
-                nd->_parent->_parent->_color = RED;
-                //grandpa becomes current node
-                nd = nd->_parent->_parent;
-            } else
-            {   //if the node is the right child
-                if (nd == nd->_parent->_right)
-                {
-                    //then left turn зфкуте
-                    nd = nd->_parent;
-                    rotLeft(nd);
-                }
-                //we paint parents black
-                nd->_parent->_color = BLACK;
-                //grandpa in red
-                nd->_parent->_parent->_color = RED;
-                //turn right relative to grandfather
-                rotRight(nd->_parent->_parent);
-            }
-        } else
+            // ключи, пройденные после поворотов, лежат в том же сужающемся интервале,
+            // так что последний поворот налево — по-прежнему кандидат в дубликаты
+            if (cand && !_compar(key, cand->_key))
+                throw std::invalid_argument("Key already exist");
+
+            node = newElement = new Node(key, nullptr, nullptr, dad, RED);
+            dad->_child[goRight] = newElement;
+#ifdef RBTREE_WITH_HASHING
+            addHashUp(dad, newElement->_hash);
+#endif // RBTREE_WITH_HASHING
+            if (_dumper)
+                _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_BST_INS, this, newElement);
+        }
+        else
         {
-            //left uncle
-            temp = nd->_parent->_parent->_left;
-            //and if he is red
-            if (temp != nullptr && temp->_color == RED)
-            {
-                //parent to black
-                nd->_parent->_color = BLACK;
-                //uncle in black
-                temp->_color = BLACK;
-                //grandpa in red
-                nd->_parent->_parent->_color = RED;
-                //current node - grandfather
-                nd = nd->_parent->_parent;
-            } else
+            // сторона спуска от node поворотами ниже не меняется; брат следующего узла
+            // читается, только если сам следующий красный
+            goRight = _compar(node->_key, key);
+            cand = goRight ? cand : node;
+
+            Node *next = node->_child[goRight];
+            Node *other = node->_child[!goRight];
+            if (next && next->_color == RED && other && other->_color == RED)
             {
-                //if the node is the left child
-                if (nd == nd->_parent->_left)
-                {
-                    //then right turn relative to father
-                    nd = nd->_parent;
-                    rotRight(nd);
-                }
-                //parent to black
-                nd->_parent->_color = BLACK;
-                //grandpa in red
-                nd->_parent->_parent->_color = RED;
-                //left turn relative to grandfather
-                rotLeft(nd->_parent->_parent);
+                // 4-узел разделяется: черная высота путей через node не меняется; корень
+                // остается черным (высота растет на всех путях сразу), так что у красного
+                // отца ниже всегда есть дедушка
+                node->_color = dad ? RED : BLACK;
+                next->setBlack();
+                other->setBlack();
             }
         }
 
+        if (node->_color == RED && dad && dad->_color == RED)
+            splitRedRed(node);
+
+        if (newElement)
+            break;
+
+        dad = node;
+        node = node->_child[goRight];
     }
-    _root->setBlack();
+
+    return newElement;
 }
 
 
 template<typename Element, typename Compar>
-void RBTree<Element, Compar>::rotLeft(typename RBTree<Element, Compar>::Node *nd)
+void RBTree<Element, Compar>::splitRedRed(Node *nd)
 {
-    Node *y = nd->_right;
+    // папа красный, значит, не корень, и дедушка есть
+    Node *dad = nd->_parent;
+    Node *grand = dad->_parent;
+    int dadDir = (dad == grand->_child[1]);
 
-    if (!y)
-        throw std::invalid_argument("Can't rotate left since the right child is nil");
+    // внешний внук: папа поднимается на место дедушки
+    if (nd == dad->_child[dadDir])
+    {
+        dad->setBlack();
+        grand->setRed();
+        rotate(grand, !dadDir);
+        return;
+    }
 
-    Node *tempLeftChild = y->getChild(true);
-    //make the left child y right at nd
-    nd->setRight(tempLeftChild);
-    //then we make nd a parent of the left child y  //UPD: Check if children have y
-    if (tempLeftChild != nullptr)
-        tempLeftChild->_parent = nd;
+    // внутренний внук поднимается на место дедушки двумя поворотами
+    rotate(dad, dadDir);
+    nd->setBlack();
+    grand->setRed();
+    rotate(grand, !dadDir);
+}
 
-    //now parent nd must be made parent y
-    if (nd->_parent == nullptr) //if nd was root
-    {
-        _root = y;
-    } else
+
+template<typename Element, typename Compar>
+typename RBTree<Element, Compar>::Node *
+RBTree<Element, Compar>::rebalanceDUG(Node *nd)
+{
+    // папа красный, значит, не корень, и дедушка есть
+    Node *dad = nd->_parent;
+    Node *grand = dad->_parent;
+    int dadDir = (dad == grand->_child[1]);         // сторона папы у дедушки
+    Node *uncle = grand->_child[!dadDir];
+
+    //if uncle is red: recolor and go up to grandpa
+    if (uncle != nullptr && uncle->isRed())
     {
+        dad->setBlack();
+        uncle->setBlack();
+        grand->setRed();
+        return grand;
+    }
 
-        //if the child is left, then put the parent nd of the left descendant y, otherwise
-        if (nd->isLeftChild())
-            nd->_parent->setLeft(y);
-        else
-            nd->_parent->setRight(y);
+    // внутренний внук (на другой стороне у папы, чем папа у дедушки) поворотом
+    // делаем внешним
+    if (nd == dad->_child[!dadDir])
+    {
+        nd = dad;
+        rotate(nd, dadDir);
     }
-    //now nd - a child y
-    y->setLeft(nd);
-    //now y - parent nd
-    if (nd != nullptr)
-        nd->_parent = y;
 
-    // отладочное событие
-    if (_dumper)
-        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_LROT, this, nd);
+    // папа черный, дедушка красный, поворот дедушки в сторону дяди
+    nd->_parent->setBlack();
+    nd->_parent->_parent->setRed();
+    rotate(nd->_parent->_parent, !dadDir);
 
+    // папа nd теперь черный: нарушений выше нет
+    return nd;
 }
 
 
 template<typename Element, typename Compar>
-void RBTree<Element, Compar>::rotRight(typename RBTree<Element, Compar>::Node *nd)
+void RBTree<Element, Compar>::rebalance(Node *nd)
 {
-    // left потомок, который станет после right поворота "выше"
-    Node *y = nd->_left;
+    //as long as the parent is red
+    while (nd->isDaddyRed())
+        nd = rebalanceDUG(nd);
 
-    if (!y)
-        throw std::invalid_argument("Can't rotate left since the right child is nil");
+    _root->setBlack();
+}
 
-    Node *tempRightChild = y->getChild(false);
-    //make the right child y left at nd
-    nd->setLeft(tempRightChild);
-    //then we make nd a parent of the right child y   //UPD: Check if children have y
-    if (tempRightChild != nullptr)
-        tempRightChild->_parent = nd;
 
-    //now parent nd must be made parent y
-    if (nd->_parent == nullptr) //if nd was root
-    {
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::rotate(Node *nd, int dir)
+{
+    // сын с другой стороны поднимается на место nd
+    Node *y = nd->_child[!dir];
+
+    if (!y)
+        throw std::invalid_argument(dir == 0 ? "Can't rotate left since the right child is nil"
+                                             : "Can't rotate right since the left child is nil");
+
+#ifdef RBTREE_WITH_HASHING
+    // y забирает все поддерево nd, а nd теряет y с его внешней частью
+    std::uint64_t total = nd->_hash;
+    nd->_hash = total - y->_hash + hashOf(y->_child[dir]);
+    y->_hash = total;
+#endif // RBTREE_WITH_HASHING
+
+    // внутреннее поддерево y переходит к nd
+    Node *inner = y->_child[dir];
+    nd->_child[!dir] = inner;
+    if (inner)
+        inner->_parent = nd;
+
+    // y встает на место nd у его отца
+    Node *dad = nd->_parent;
+    y->_parent = dad;
+    if (!dad)
         _root = y;
-    } else
-    {
+    else
+        dad->_child[dad->_child[1] == nd] = y;
 
-        //if the child is right, then put the parent nd of the tight descendant y, otherwise
-        if (nd->isRightChild())
-            nd->_parent->setRight(y);
-        else
-            nd->_parent->setLeft(y);
-    }
-    //now nd - a child y
-    y->setRight(nd);
-    //now y - parent nd
+    y->_child[dir] = nd;
     nd->_parent = y;
 
     // отладочное событие
     if (_dumper)
-        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_RROT, this, nd);
-
+        _dumper->rbTreeEvent(dir == 0 ? IRBTreeDumper<Element, Compar>::DE_AFTER_LROT
+                                      : IRBTreeDumper<Element, Compar>::DE_AFTER_RROT, this, nd);
 }
 
+
 template<typename Element, typename Compar>
 typename RBTree<Element, Compar>::Node *RBTree<Element, Compar>::findForRemove(const Element &key)
 {
-    Node *node = _root;
-
-    if (node == nullptr)
+    if (_root == nullptr)
         throw std::invalid_argument("node is nullptr");
-    //cycle for running through the tree
-    while (node)
-    {
-        /** as the left child is less than the parent, and the right one is more,
-         then for finding we will need 2 checks and if neither one is fulfilled,
-         then we have found the necessary element */
-        if (key < node->getKey())
-        {
-            node = node->getChild(true);    //go to the left child
-        } else
-        {
-            if (key > node->getKey())   //if you hit this block, the key is greater than or equal to
-            {
-                node = node->getChild(
-                        false);  //if you hit this block, then the key is larger, so go to the right child
-            } else
-            {
-                return node;    //if you hit this block, the key is found
-            }
 
-        }
-    }
-    return nullptr;
+    return const_cast<Node *>(findNode(key));
 }
 
 template<typename Element, typename Compar>
-void RBTree<Element, Compar>::remove(const Element &key)
+void RBTree<Element, Compar>::transplant(Node *u, Node *v)
 {
-    Node *tempChildChild, *tempChildNodeForRemove;
+    if (!u->_parent)
+        _root = v;
+    else if (u == u->_parent->_child[0])
+        u->_parent->_child[0] = v;
+    else
+        u->_parent->_child[1] = v;
 
+    if (v)
+        v->_parent = u->_parent;
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::remove(const Element &key)
+{
     Node *tempNode = findForRemove(key);
 
     //throw an exception if the node is not found
     if (tempNode == nullptr)
         throw std::invalid_argument("Key not find");
 
-    //check if one of the children does not exist, assign the value of the temp node
-    if (tempNode->_left == nullptr || tempNode->_right == nullptr)
-    {
-        tempChildNodeForRemove = tempNode;
+    unlinkNode(tempNode, true);
+    adjustSize(0, 1);
+
+    // связи вынутого узла могут еще читаться конкурентными читателями, поэтому не трогаем их
+    retireNode(tempNode);
+}
+
 
-    } else
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::unlinkNode(Node *tempNode, bool withEvents)
+{
+    // Узел вынимается из дерева целиком, а на его место переставляется (а не копируется
+    // ключом) преемник: ключи живых узлов не меняются, и конкурентный читатель
+    // не увидит полузаписанного ключа.
+    Node *child;                            // узел, занявший место вынутого (может быть null)
+    Node *childParent;                      // его родитель
+    Color removedColor = tempNode->_color;  // цвет, ушедший из дерева
+#ifdef RBTREE_WITH_HASHING
+    std::uint64_t removedHash = ownHashOf(tempNode);
+    std::uint64_t subtreeHash = tempNode->_hash;
+    Node *hashFrom = nullptr;               // нижний узел, потерявший ключ вынутого
+#endif // RBTREE_WITH_HASHING
+
+    if (!tempNode->_child[0])
     {
-        //if not found, then go to the end of the right descendant
-        tempChildNodeForRemove = tempNode->_right;
-        while (tempChildNodeForRemove->_left != nullptr)
-            tempChildNodeForRemove = tempChildNodeForRemove->_left;
+        child = tempNode->_child[1];
+        childParent = tempNode->_parent;
+        transplant(tempNode, tempNode->_child[1]);
+    }
+    else if (!tempNode->_child[1])
+    {
+        child = tempNode->_child[0];
+        childParent = tempNode->_parent;
+        transplant(tempNode, tempNode->_child[0]);
     }
-
-    //Check if tempChildNodeForRemove is the only descendant
-    if (tempChildNodeForRemove->_left != nullptr)  //and remember the existing descendant
-        tempChildChild = tempChildNodeForRemove->_left;
     else
-        tempChildChild = tempChildNodeForRemove->_right;
+    {
+        // преемник — самый левый в правом поддереве, левого сына у него нет
+        Node *succ = tempNode->_child[1];
+        while (succ->_child[0])
+            succ = succ->_child[0];
+
+        removedColor = succ->_color;
+        child = succ->_child[1];
+#ifdef RBTREE_WITH_HASHING
+        std::uint64_t succHash = ownHashOf(succ);
+#endif // RBTREE_WITH_HASHING
+
+        if (succ->_parent == tempNode)
+            childParent = succ;
+        else
+        {
+            childParent = succ->_parent;
+            transplant(succ, succ->_child[1]);
+            succ->_child[1] = tempNode->_child[1];
+            succ->_child[1]->_parent = succ;
+        }
+
+        transplant(tempNode, succ);
+        succ->_child[0] = tempNode->_child[0];
+        succ->_child[0]->_parent = succ;
+        succ->_color = tempNode->_color;
+
+#ifdef RBTREE_WITH_HASHING
+        // путь от старого места преемника до нового потерял его ключ; на новом месте
+        // он несет все поддерево вынутого узла, из которого ключ вынутого вычтется ниже
+        for (Node *nd = childParent; nd != succ; nd = nd->_parent)
+            nd->_hash -= succHash;
+        succ->_hash = subtreeHash;
+        hashFrom = succ;
+#endif // RBTREE_WITH_HASHING
+    }
+
+#ifdef RBTREE_WITH_HASHING
+    addHashUp(hashFrom ? hashFrom : childParent, 0 - removedHash);
+
+    // связи вынутого узла остаются для читателей, а хеш — только его собственного ключа,
+    // как ждут joinNodes() для разделителя
+    tempNode->_hash = removedHash;
+#endif // RBTREE_WITH_HASHING
+
+    // отладочное событие: узел уже вынут из дерева
+    if (withEvents && _dumper)
+        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_BST_REMOVE, this, tempNode);
 
-    //check that everyone had parents and they were not zero
-    if (tempChildChild != nullptr && tempChildNodeForRemove != nullptr && tempChildChild->_parent != nullptr &&
-        tempChildNodeForRemove->_parent)
-        tempChildChild->_parent = tempChildNodeForRemove->_parent; //and remove parents tempChildNodeForRemove
+    // из дерева ушел черный узел — черная высота на пути через child уменьшилась
+    if (removedColor == BLACK)
+        removeFixup(child, childParent);
 
-    //if he has parents
-    if (tempChildNodeForRemove->_parent != nullptr)
+    // отладочное событие
+    if (withEvents && _dumper)
+        _dumper->rbTreeEvent(IRBTreeDumper<Element, Compar>::DE_AFTER_REMOVE, this, tempNode);
+}
+
+
+template<typename Element, typename Compar>
+void RBTree<Element, Compar>::removeFixup(Node *x, Node *xParent)
+{
+    // x несет "лишнюю" черноту; поднимаем ее, пока не встретим красный узел или корень
+    while (x != _root && (!x || x->isBlack()))
     {
-        //if the left child is the left parent
-        if (tempChildNodeForRemove == tempChildNodeForRemove->_parent->_left)
-            tempChildNodeForRemove->_parent->_left = tempChildChild; //then we assign the child's tempChildNodeForRemove value to the left parent
-        else
-            tempChildNodeForRemove->_parent->_right = tempChildChild; //otherwise
-    } else
-        _root = tempChildChild; //if there were no parents, then this is the root
+        // сторона x у отца; пустой x опознается по непустому брату
+        int dir = (x != xParent->_child[0]);
+        Node *brother = xParent->_child[!dir];
 
+        // красный брат — поворотом делаем брата черным
+        if (brother->isRed())
+        {
+            brother->setBlack();
+            xParent->setRed();
+            rotate(xParent, dir);
+            brother = xParent->_child[!dir];
+        }
 
-    //if tempChildNodeForRemove is not equal to the node to be deleted
-    if (tempChildNodeForRemove != tempNode)
-        tempNode->_key = tempChildNodeForRemove->_key; //then in the node we assign the value of the child
+        bool nearBlack = !brother->_child[dir] || brother->_child[dir]->isBlack();
+        bool farBlack = !brother->_child[!dir] || brother->_child[!dir]->isBlack();
+        if (nearBlack && farBlack)
+        {
+            // оба племянника черные — перекрашиваем брата и поднимаемся
+            brother->setRed();
+            x = xParent;
+            xParent = x->_parent;
+        }
+        else
+        {
+            // дальний племянник черный — поворотом делаем его красным
+            if (farBlack)
+            {
+                brother->_child[dir]->setBlack();
+                brother->setRed();
+                rotate(brother, !dir);
+                brother = xParent->_child[!dir];
+            }
 
-    //if the node to remove is black, then rebalance
-    if (tempChildNodeForRemove->_color == BLACK){
-        if(tempChildChild != nullptr)
-            rebalance(tempChildChild);
+            brother->_color = xParent->_color;
+            xParent->setBlack();
+            brother->_child[!dir]->setBlack();
+            rotate(xParent, dir);
+            x = _root;
+        }
     }
 
-    //delete
-    free(tempChildNodeForRemove);
+    if (x)
+        x->setBlack();
 }
 
 } // namespace xi
@@ -0,0 +1,84 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Разница между двумя RBTree и ее компактная запись
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// \c RBTree::diff() выражает разницу двух деревьев двумя упорядоченными списками:
+/// какие элементы удалить и какие вставить. \c RBTree::applyDelta() применяет их
+/// пачкой через \c difference() / \c unionWith(), а сериализация пишет оба списка
+/// подряд в формате \c RBTree::serialize() — объем передачи пропорционален числу
+/// изменений, а не размеру дерева.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_RBTREE_DELTA_H_
+#define RBTREE_RBTREE_DELTA_H_
+
+#include <functional>       // std::less
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "rbtree_serial.h"
+
+
+namespace xi
+{
+
+
+/** \brief Изменения, переводящие одно множество в другое.
+ *
+ *  Оба списка строго возрастают в смысле \c Compar и не пересекаются.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+struct RBTreeDelta
+{
+    std::vector<Element> removes;               ///< Удаляемые элементы.
+    std::vector<Element> inserts;               ///< Вставляемые элементы.
+
+    /** \brief Возвращает истину, если изменений нет. */
+    bool isEmpty() const { return removes.empty() && inserts.empty(); }
+
+    /** \brief Очищает оба списка. */
+    void clear()
+    {
+        removes.clear();
+        inserts.clear();
+    }
+
+    /** \brief Пишет изменения в \c os: удаляемые, затем вставляемые, каждый список —
+     *  потоком \c RBTree::serialize(). При ошибке записи генерирует \c std::runtime_error.
+     */
+    template<typename Traits = RBTreeSerialTraits<Element> >
+    void serialize(std::ostream &os) const
+    {
+        serial::writeStream<Traits>(os, removes.size(), [this](auto &write) {
+            for (const Element &el : removes)
+                write(el);
+        });
+        serial::writeStream<Traits>(os, inserts.size(), [this](auto &write) {
+            for (const Element &el : inserts)
+                write(el);
+        });
+    }
+
+    /** \brief Читает изменения, записанные \c serialize(), заменяя текущие.
+     *
+     *  Поврежденный или неупорядоченный поток приводит к \c std::runtime_error.
+     */
+    template<typename Traits = RBTreeSerialTraits<Element> >
+    void deserialize(std::istream &is)
+    {
+        clear();
+        Compar compar;
+        serial::readStream<Traits>(is, compar, removes);
+        serial::readStream<Traits>(is, compar, inserts);
+    }
+}; // struct RBTreeDelta
+
+
+} // namespace xi
+
+
+#endif // RBTREE_RBTREE_DELTA_H_
@@ -0,0 +1,94 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Хеш ключа для хешей поддеревьев RBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// При включенном \c RBTREE_WITH_HASHING каждый узел \c RBTree хранит сумму
+/// (по модулю 2^64) хешей ключей своего поддерева. Сумма не зависит ни от порядка,
+/// ни от формы дерева: деревья с одинаковыми ключами имеют одинаковый хеш, как бы
+/// они ни были построены, а вращения меняют хеши двух узлов парой сложений.
+///
+/// Тот же хеш выбирает ячейку кэша частых ключей (\c RBTree::setHotCacheSize()).
+///
+/// Чтобы хешировать свой тип, специализируйте \c RBTreeKeyHash (или \c std::hash).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_RBTREE_HASH_H_
+#define RBTREE_RBTREE_HASH_H_
+
+#include <cstdint>
+#include <functional>       // std::hash
+#include <type_traits>      // std::enable_if, std::is_default_constructible
+
+
+namespace xi
+{
+
+
+namespace hashing
+{
+
+/** \brief Перемешивание splitmix64 (шаг и финализатор).
+ *
+ *  \c std::hash целых часто тождественен, а у сумм тождественных хешей коллизии
+ *  тривиальны ({1, 4} и {2, 3}); после перемешивания слагаемые ведут себя как случайные.
+ *  Шаг перед финализатором нужен, чтобы ключ с нулевым \c std::hash не получил нулевой
+ *  хеш, неотличимый от пустого поддерева.
+ */
+inline std::uint64_t mix(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+
+/** \brief Метка хеша-заглушки для типов без \c std::hash. */
+struct Unavailable
+{
+};
+
+} // namespace hashing
+
+
+/** \brief Хеш ключа: для типов без \c std::hash — заглушка, с которой деревья компилируются,
+ *  но хеши поддеревьев и кэш частых ключей недоступны.
+ *
+ *  Эквивалентные в смысле компаратора дерева ключи должны иметь равные хеши.
+ */
+template<typename Element, typename Enable = void>
+struct RBTreeKeyHash : hashing::Unavailable
+{
+    std::uint64_t operator()(const Element &) const { return 0; }
+}; // struct RBTreeKeyHash
+
+
+/** \brief Хеш ключа с \c std::hash: перемешанный \c std::hash. */
+template<typename Element>
+struct RBTreeKeyHash<Element, typename std::enable_if<std::is_default_constructible<std::hash<Element> >::value>::type>
+{
+    std::uint64_t operator()(const Element &el) const
+    {
+        return hashing::mix(static_cast<std::uint64_t>(std::hash<Element>()(el)));
+    }
+}; // struct RBTreeKeyHash
+
+
+/** \brief Истина, если для \c Element есть настоящий \c RBTreeKeyHash. */
+template<typename Element>
+struct HasRBTreeKeyHash
+        : std::integral_constant<bool, !std::is_base_of<hashing::Unavailable, RBTreeKeyHash<Element> >::value>
+{
+};
+
+
+} // namespace xi
+
+
+#endif // RBTREE_RBTREE_HASH_H_
@@ -0,0 +1,369 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Кодирование элементов и контрольная сумма для сериализации RBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Формат потока \c RBTree::serialize():
+///   - заголовок: сигнатура "RBT1", версия формата (4 байта), число элементов (8 байт);
+///   - элементы по возрастанию, каждый закодирован \c RBTreeSerialTraits;
+///   - контрольная сумма FNV-1a (8 байт) всех байтов элементов.
+/// Целые поля заголовка и суммы пишутся в порядке little-endian. Сумма стоит после
+/// элементов, чтобы писать можно было за один проход и в неперематываемый поток.
+///
+/// Чтобы сериализовать свой тип, специализируйте \c RBTreeSerialTraits.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_RBTREE_SERIAL_H_
+#define RBTREE_RBTREE_SERIAL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>        // std::runtime_error
+#include <streambuf>
+#include <string>
+#include <type_traits>      // std::is_trivially_copyable
+#include <vector>
+
+
+namespace xi
+{
+
+
+/** \brief Кодирование элемента в поток сериализации.
+ *
+ *  По умолчанию — байты объекта как есть (порядок байтов машины), что годится только
+ *  для тривиально копируемых типов. Специализация должна предоставлять
+ *  <tt>static void write(std::ostream &, const Element &)</tt> и
+ *  <tt>static Element read(std::istream &)</tt>; ошибку чтения \c read() сообщает
+ *  состоянием потока.
+ */
+template<typename Element>
+struct RBTreeSerialTraits
+{
+    static_assert(std::is_trivially_copyable<Element>::value,
+                  "Specialize xi::RBTreeSerialTraits for non-trivially-copyable elements");
+
+    static void write(std::ostream &os, const Element &el)
+    {
+        os.write(reinterpret_cast<const char *>(&el), sizeof(Element));
+    }
+
+    static Element read(std::istream &is)
+    {
+        Element el;
+        is.read(reinterpret_cast<char *>(&el), sizeof(Element));
+        return el;
+    }
+}; // struct RBTreeSerialTraits
+
+
+namespace serial
+{
+
+/** \brief Сигнатура потока. */
+static const char SIGNATURE[4] = { 'R', 'B', 'T', '1' };
+
+/** \brief Версия формата. */
+static const std::uint32_t FORMAT_VERSION = 1;
+
+
+/** \brief Пишет \c v в \c os как \c bytes байтов little-endian. */
+inline void writeUInt(std::ostream &os, std::uint64_t v, std::size_t bytes)
+{
+    char buf[8];
+    for (std::size_t i = 0; i < bytes; ++i)
+        buf[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    os.write(buf, static_cast<std::streamsize>(bytes));
+}
+
+
+/** \brief Читает \c bytes байтов little-endian из \c is. */
+inline std::uint64_t readUInt(std::istream &is, std::size_t bytes)
+{
+    unsigned char buf[8];
+    is.read(reinterpret_cast<char *>(buf), static_cast<std::streamsize>(bytes));
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < bytes; ++i)
+        v |= static_cast<std::uint64_t>(buf[i]) << (8 * i);
+    return v;
+}
+
+
+/** \brief Начальное значение суммы FNV-1a. */
+static const std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+/** \brief Множитель FNV-1a. */
+static const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+
+/** \brief Продолжает сумму FNV-1a \c hash байтами \c s[0..n). */
+inline std::uint64_t fnv1a(const char *s, std::size_t n, std::uint64_t hash = FNV_OFFSET)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        hash ^= static_cast<unsigned char>(s[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+} // namespace serial
+
+
+/** \brief Строки: длина (8 байт little-endian) и символы. */
+template<>
+struct RBTreeSerialTraits<std::string>
+{
+    static void write(std::ostream &os, const std::string &el)
+    {
+        serial::writeUInt(os, el.size(), 8);
+        os.write(el.data(), static_cast<std::streamsize>(el.size()));
+    }
+
+    static std::string read(std::istream &is)
+    {
+        std::uint64_t len = serial::readUInt(is, 8);
+        std::string el;
+        if (!is)
+            return el;
+
+        // длина читается из непроверенного потока — растим строку кусками, а не сразу
+        const std::uint64_t CHUNK = 1 << 16;
+        while (len > 0 && is)
+        {
+            std::size_t part = static_cast<std::size_t>(len < CHUNK ? len : CHUNK);
+            std::size_t old = el.size();
+            el.resize(old + part);
+            is.read(&el[old], static_cast<std::streamsize>(part));
+            len -= part;
+        }
+        return el;
+    }
+}; // struct RBTreeSerialTraits<std::string>
+
+
+/** \brief Прозрачная обертка буфера потока, считающая FNV-1a всех прошедших байтов.
+ *
+ *  Своего буфера нет: запись и чтение сразу передаются нижнему буферу, поэтому он
+ *  не читает вперед и после снятия обертки поток продолжается ровно с того же места.
+ */
+class FnvStreamBuf : public std::streambuf
+{
+public:
+    explicit FnvStreamBuf(std::streambuf *inner) : _inner(inner), _hash(serial::FNV_OFFSET) {}
+
+    /** \brief Возвращает сумму прошедших байтов. */
+    std::uint64_t getHash() const { return _hash; }
+
+protected:
+    void add(const char *s, std::streamsize n)
+    {
+        if (n > 0)
+            _hash = serial::fnv1a(s, static_cast<std::size_t>(n), _hash);
+    }
+
+    // запись
+    int_type overflow(int_type ch) override
+    {
+        if (traits_type::eq_int_type(ch, traits_type::eof()))
+            return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        add(&c, 1);
+        return _inner->sputc(c);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        std::streamsize done = _inner->sputn(s, n);
+        add(s, done);
+        return done;
+    }
+
+    // чтение
+    int_type underflow() override { return _inner->sgetc(); }
+
+    int_type uflow() override
+    {
+        int_type ch = _inner->sbumpc();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            char c = traits_type::to_char_type(ch);
+            add(&c, 1);
+        }
+        return ch;
+    }
+
+    std::streamsize xsgetn(char *s, std::streamsize n) override
+    {
+        std::streamsize done = _inner->sgetn(s, n);
+        add(s, done);
+        return done;
+    }
+
+protected:
+    std::streambuf *_inner;                     ///< Нижний буфер.
+    std::uint64_t _hash;                        ///< Текущая сумма.
+}; // class FnvStreamBuf
+
+
+namespace serial
+{
+
+/** \brief Пишет в \c os поток в формате \c RBTree::serialize(): заголовок, \c n элементов
+ *  и сумму.
+ *
+ *  Элементы перечисляет \c each: ему передается функтор записи, который он должен
+ *  вызвать для каждого элемента по возрастанию ровно \c n раз.
+ *  При ошибке записи генерирует \c std::runtime_error.
+ */
+template<typename Traits, typename Each>
+void writeStream(std::ostream &os, std::uint64_t n, Each each)
+{
+    os.write(SIGNATURE, sizeof(SIGNATURE));
+    writeUInt(os, FORMAT_VERSION, 4);
+    writeUInt(os, n, 8);
+
+    // элементы — через обертку, считающую сумму
+    FnvStreamBuf fnv(os.rdbuf());
+    std::ostream body(&fnv);
+    auto write = [&body](const auto &key) { Traits::write(body, key); };
+    each(write);
+
+    writeUInt(os, fnv.getHash(), 8);
+    if (!body || !os)
+        throw std::runtime_error("Failed to write RBTree stream");
+}
+
+
+/** \brief Поэлементное чтение потока в формате \c RBTree::serialize().
+ *
+ *  Конструктор проверяет сигнатуру и версию и читает число элементов, \c advance() —
+ *  очередной элемент, проверяя строгое возрастание (в смысле \c compar), а за последним —
+ *  сумму. При нарушении генерируется \c std::runtime_error. Пока читатель жив, поток
+ *  \c is читать в обход него нельзя.
+ */
+template<typename Traits, typename Element, typename Compar>
+class StreamReader
+{
+public:
+    /** \brief Однопроходный итератор по элементам — вход для \c RBTree::assignSorted(). */
+    class Iterator
+    {
+    public:
+        /** \brief Итератор конца. */
+        Iterator() : _reader(nullptr), _atEnd(true) {}
+
+        explicit Iterator(StreamReader &reader) : _reader(&reader), _atEnd(!reader.advance()) {}
+
+        const Element &operator*() const { return _reader->current(); }
+
+        /** \brief Различает лишь конец и не конец: другого сравнения однопроходному не нужно. */
+        bool operator!=(const Iterator &other) const { return _atEnd != other._atEnd; }
+
+        Iterator &operator++()
+        {
+            _atEnd = !_reader->advance();
+            return *this;
+        }
+
+    protected:
+        StreamReader *_reader;                  ///< Читатель.
+        bool _atEnd;                            ///< Элементы кончились.
+    }; // class Iterator
+
+public:
+    StreamReader(std::istream &is, const Compar &compar)
+            : _is(is), _compar(compar), _n(0), _read(0), _done(false), _fnv(is.rdbuf()), _body(&_fnv)
+    {
+        char sig[sizeof(SIGNATURE)];
+        is.read(sig, sizeof(sig));
+        if (!is || std::char_traits<char>::compare(sig, SIGNATURE, sizeof(sig)) != 0)
+            throw std::runtime_error("Not an RBTree stream");
+        if (readUInt(is, 4) != FORMAT_VERSION)
+            throw std::runtime_error("Unsupported RBTree stream version");
+        _n = readUInt(is, 8);
+        if (!is)
+            throw std::runtime_error("Truncated RBTree stream");
+    }
+
+    /** \brief Возвращает число элементов по заголовку (еще не проверенное). */
+    std::uint64_t getSize() const { return _n; }
+
+    /** \brief Читает очередной элемент в \c current(). Возвращает ложь, если элементы кончились
+     *  и сумма сошлась.
+     */
+    bool advance()
+    {
+        if (_done)
+            return false;
+        if (_read == _n)
+        {
+            _done = true;
+            std::uint64_t sum = readUInt(_is, 8);
+            if (!_is || sum != _fnv.getHash())
+                throw std::runtime_error("RBTree stream checksum mismatch");
+            return false;
+        }
+
+        Element el = Traits::read(_body);
+        if (!_body)
+            throw std::runtime_error("Truncated RBTree stream");
+        if (_cur && !_compar(*_cur, el))
+            throw std::runtime_error("RBTree stream is not strictly increasing");
+        _cur = std::move(el);
+        ++_read;
+        return true;
+    }
+
+    /** \brief Возвращает последний прочитанный элемент. */
+    const Element &current() const { return *_cur; }
+
+    Iterator begin() { return Iterator(*this); }
+    Iterator end() { return Iterator(); }
+
+protected:
+    StreamReader(const StreamReader &);                 ///< КК не доступен.
+    StreamReader &operator=(const StreamReader &);      ///< Присваивание недоступно.
+
+protected:
+    std::istream &_is;                          ///< Поток.
+    Compar _compar;                             ///< Компаратор для проверки порядка.
+    std::uint64_t _n;                           ///< Число элементов по заголовку.
+    std::uint64_t _read;                        ///< Прочитано элементов.
+    bool _done;                                 ///< Сумма прочитана и проверена.
+    FnvStreamBuf _fnv;                          ///< Считает сумму байтов элементов.
+    std::istream _body;                         ///< Поток элементов поверх \c _fnv.
+    std::optional<Element> _cur;                ///< Последний прочитанный элемент.
+}; // class StreamReader
+
+
+/** \brief Читает из \c is поток в формате \c RBTree::serialize() и добавляет его элементы
+ *  в \c keys.
+ *
+ *  Проверки и ошибки — как у \c StreamReader.
+ */
+template<typename Traits, typename Element, typename Compar>
+void readStream(std::istream &is, const Compar &compar, std::vector<Element> &keys)
+{
+    StreamReader<Traits, Element, Compar> reader(is, compar);
+
+    // число из непроверенного потока — резервируем не больше разумного, дальше вектор растет сам
+    std::uint64_t n = reader.getSize();
+    keys.reserve(keys.size() + static_cast<std::size_t>(n < (1 << 20) ? n : (1 << 20)));
+
+    while (reader.advance())
+        keys.push_back(reader.current());
+}
+
+} // namespace serial
+
+
+} // namespace xi
+
+
+#endif // RBTREE_RBTREE_SERIAL_H_
@@ -0,0 +1,216 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Бинарная трассировка событий красно-черного дерева и ее воспроизведение
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// В отличие от дампера по умолчанию (tests/def_dumper.h), который на каждое
+/// событие пишет полный GraphViz-файл, рекордер складывает события в компактные
+/// бинарные записи фиксированного размера (тип события, ключ, метка времени)
+/// и сбрасывает их на диск крупными блоками в фоновом потоке. Воспроизводящий класс по такому
+/// журналу восстанавливает любое промежуточное состояние дерева.
+///
+/// По умолчанию пишутся только события \c DE_AFTER_INSERT и \c DE_AFTER_REMOVE — те, что
+/// нужны для воспроизведения; структурные события включаются маской.
+///
+/// Формат файла: заголовок (сигнатура, версия, размер ключа), затем записи
+/// <tt>[uint64 время, нс][uint8 событие][байты ключа]</tt>.
+///
+/// "Реализация" соответствующих методов располагается в файле rbtree_trace.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_RBTREE_TRACE_H_
+#define RBTREE_RBTREE_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+
+/** \brief Рекордер событий дерева в бинарный журнал.
+ *
+ *  Реализует интерфейс \c IRBTreeDumper, поэтому подключается к дереву обычным
+ *  \c RBTree::setDumper(). Записи копятся в буфере фиксированной емкости; заполненный
+ *  буфер меняется местами со вторым, который фоновый поток рекордера пишет в файл,
+ *  пока дерево продолжает работу. Поток-писатель дерева ждет только тогда, когда
+ *  следующий буфер заполнен раньше, чем дописан предыдущий.
+ *
+ *  Дерево вызывает дампер синхронно из своего (единственного) потока-писателя,
+ *  поэтому запись события в текущий буфер не требует ни блокировок, ни атомарных
+ *  операций; мьютекс берется лишь при обмене буферами.
+ *
+ *  Пишутся только события из маски \c eventMask; отброшенные стоят одного виртуального
+ *  вызова. Метка времени снимается один раз на операцию дерева (вставку или удаление)
+ *  и достается всем ее записанным событиям. На Linux метки берутся с грубых монотонных
+ *  часов: они упорядочены, но различаются лишь с точностью до тика ядра (1–4 мс).
+ *
+ *  \tparam Element Тип ключа; должен быть тривиально копируемым, т.к. пишется побайтно.
+ */
+template<typename Element, typename Compar>
+class RBTreeTraceRecorder : public IRBTreeDumper<Element, Compar>
+{
+public:
+    typedef IRBTreeDumper<Element, Compar> TDumper;
+    typedef typename TDumper::TTree TTree;
+    typedef typename TDumper::TTreeNode TTreeNode;
+    typedef typename TDumper::RBTreeDumperEvent TEvent;
+
+public:
+    /** \brief Размер буфера (в записях) по умолчанию. */
+    static const std::size_t DEF_BUFFER_RECORDS = 1 << 16;
+
+    /** \brief Бит события \c ev в маске записываемых событий. */
+    static constexpr unsigned eventBit(TEvent ev) { return 1u << ev; }
+
+    /** \brief Маска по умолчанию: события, которые использует \c RBTreeTraceReplayer. */
+#ifdef RBTREE_WITH_DELETION
+    static constexpr unsigned DEF_EVENT_MASK = (1u << TDumper::DE_AFTER_INSERT) | (1u << TDumper::DE_AFTER_REMOVE);
+#else
+    static constexpr unsigned DEF_EVENT_MASK = 1u << TDumper::DE_AFTER_INSERT;
+#endif // RBTREE_WITH_DELETION
+
+    /** \brief Маска всех событий, включая структурные. */
+    static constexpr unsigned ALL_EVENTS = ~0u;
+
+public:
+    /** \brief Открывает журнал \c fileName на запись и пишет в него заголовок.
+     *
+     *  \param eventMask Маска записываемых событий (см. \c eventBit()).
+     *
+     *  Если файл не может быть открыт, генерирует исключительную ситуацию \c std::invalid_argument.
+     */
+    RBTreeTraceRecorder(const std::string &fileName, std::size_t bufferRecords = DEF_BUFFER_RECORDS,
+                        unsigned eventMask = DEF_EVENT_MASK);
+
+    /** \brief Сбрасывает на диск остаток буфера и закрывает журнал.
+     *
+     *  Ошибку записи деструктор сообщить не может; чтобы ее узнать, вызовите \c flush().
+     */
+    ~RBTreeTraceRecorder();
+
+public:
+    /** \brief Добавляет в буфер запись о событии \c ev над узлом \c nd. */
+    void rbTreeEvent(TEvent ev, TTree *tr, TTreeNode *nd) override;
+
+    /** \brief Принудительно сбрасывает накопленные записи в файл и дожидается их записи.
+     *
+     *  Если какой-либо блок журнала не удалось записать, генерирует \c std::runtime_error.
+     */
+    void flush();
+
+    /** \brief Возвращает число записанных (в т.ч. еще не сброшенных) событий. */
+    std::uint64_t getEventsNum() const { return _eventsNum; }
+
+    /** \brief Возвращает маску записываемых событий. */
+    unsigned getEventMask() const { return _eventMask; }
+
+protected:
+    RBTreeTraceRecorder(const RBTreeTraceRecorder &);               ///< КК не доступен.
+    RBTreeTraceRecorder &operator=(const RBTreeTraceRecorder &);    ///< Присваивание недоступно.
+
+protected:
+    /** \brief Отдает заполненную часть буфера фоновому потоку, дождавшись, пока тот допишет предыдущую. */
+    void submit();
+
+    /** \brief Отдает остаток буфера и дожидается, пока фоновый поток его допишет. */
+    void drain();
+
+    /** \brief Цикл фонового потока: пишет в файл отданные буферы до остановки рекордера. */
+    void writerLoop();
+
+protected:
+    std::ofstream _file;                        ///< Файл журнала; после конструктора пишется только фоновым потоком.
+    std::vector<unsigned char> _buf;            ///< Заполняемый буфер записей.
+    std::vector<unsigned char> _backBuf;        ///< Буфер, отданный фоновому потоку.
+    std::size_t _bufRecords;                    ///< Емкость буфера в записях.
+    std::size_t _head;                          ///< Число записей, лежащих в буфере.
+    std::size_t _backBytes;                     ///< Байт к записи в \c _backBuf; 0 — буфер свободен.
+    std::uint64_t _eventsNum;                   ///< Общее число событий.
+    unsigned _eventMask;                        ///< Маска записываемых событий.
+    bool _inOp;                                 ///< Метка \c _opStamp снята для текущей операции дерева.
+    std::uint64_t _opStamp;                     ///< Метка времени текущей операции, нс.
+    bool _stop;                                 ///< Признак остановки фонового потока.
+    bool _failed;                               ///< Фоновому потоку не удалось записать блок.
+
+    std::mutex _mtx;                            ///< Защищает \c _backBuf, \c _backBytes, \c _stop и \c _failed.
+    std::condition_variable _cv;                ///< Сигналит об отданном и о дописанном буфере.
+
+    std::uint64_t _startNs;                     ///< Момент открытия журнала (нуль меток времени), нс.
+    std::thread _writer;                        ///< Фоновый поток записи; запускается последним.
+}; // class RBTreeTraceRecorder
+
+
+/** \brief Воспроизводит бинарный журнал, записанный \c RBTreeTraceRecorder.
+ *
+ *  Структурные события (повороты, перекраски) являются детерминированным следствием
+ *  вставок и удалений, поэтому для восстановления состояния достаточно повторить
+ *  над деревом события \c DE_AFTER_INSERT и \c DE_AFTER_REMOVE. Массовые операции
+ *  (\c split(), \c join(), операции над множествами и т.п.) пишут в журнал те же события
+ *  по каждому пришедшему и ушедшему ключу (см. \c RBTree::setDumper()), так что и их
+ *  итог воспроизводится, хотя форма дерева может отличаться от исходной. Остальные события,
+ *  если рекордер их писал (см. маску событий), учитываются только в нумерации.
+ */
+template<typename Element, typename Compar>
+class RBTreeTraceReplayer
+{
+public:
+    typedef RBTree<Element, Compar> TTree;
+    typedef IRBTreeDumper<Element, Compar> TDumper;
+
+    /** \brief Одна запись журнала. */
+    struct Record
+    {
+        std::uint64_t timestamp;                ///< Время от открытия журнала, нс.
+        typename TDumper::RBTreeDumperEvent event;  ///< Тип события.
+        Element key;                            ///< Ключ узла-инициатора.
+    };
+
+public:
+    /** \brief Открывает журнал \c fileName и проверяет заголовок.
+     *
+     *  Если файл не открывается или заголовок не соответствует типу \c Element,
+     *  генерирует исключительную ситуацию \c std::invalid_argument.
+     */
+    explicit RBTreeTraceReplayer(const std::string &fileName);
+
+public:
+    /** \brief Читает очередную запись в \c rec. Возвращает ложь, если журнал кончился. */
+    bool next(Record &rec);
+
+    /** \brief Перематывает журнал в начало. */
+    void rewind();
+
+    /** \brief Восстанавливает в (пустом) дереве \c tree состояние после первых \c eventsNum событий.
+     *
+     *  Если дерево не пусто, генерирует исключительную ситуацию \c std::invalid_argument.
+     *  \returns число реально прочитанных событий (меньше \c eventsNum, если журнал короче).
+     */
+    std::uint64_t replayTo(TTree &tree, std::uint64_t eventsNum);
+
+protected:
+    std::ifstream _file;                        ///< Файл журнала.
+    std::streampos _dataPos;                    ///< Позиция первой записи.
+}; // class RBTreeTraceReplayer
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "rbtree_trace.hpp"
+
+#endif // RBTREE_RBTREE_TRACE_H_
@@ -0,0 +1,302 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация бинарной трассировки событий красно-черного дерева
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле rbtree_trace.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>          // std::memcpy
+#include <stdexcept>        // std::invalid_argument, std::runtime_error
+#include <type_traits>      // std::is_trivially_copyable
+
+#if defined(__linux__)
+#include <time.h>           // clock_gettime
+#endif
+
+
+namespace xi
+{
+
+namespace trace_detail
+{
+
+/** \brief Сигнатура журнала. */
+static const char TRACE_MAGIC[8] = { 'X', 'I', 'R', 'B', 'T', 'R', 'C', '1' };
+
+/** \brief Версия формата журнала. */
+static const std::uint32_t TRACE_VERSION = 1;
+
+/** \brief Размер одной записи для ключа размером \c keySize. */
+inline std::size_t recordSize(std::size_t keySize)
+{
+    return sizeof(std::uint64_t) + sizeof(std::uint8_t) + keySize;
+}
+
+/** \brief Возвращает показание монотонных часов в наносекундах.
+ *
+ *  На Linux берутся грубые часы \c CLOCK_MONOTONIC_COARSE: их чтение на порядок дешевле
+ *  \c std::chrono::steady_clock (единицы нс против десятков), а разрешение — тик ядра.
+ */
+inline std::uint64_t nowNs()
+{
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000u + static_cast<std::uint64_t>(ts.tv_nsec);
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // namespace trace_detail
+
+
+//==============================================================================
+// class RBTreeTraceRecorder
+//==============================================================================
+
+template<typename Element, typename Compar>
+RBTreeTraceRecorder<Element, Compar>::RBTreeTraceRecorder(const std::string &fileName,
+                                                          std::size_t bufferRecords,
+                                                          unsigned eventMask)
+        : _bufRecords(bufferRecords ? bufferRecords : 1)
+        , _head(0)
+        , _backBytes(0)
+        , _eventsNum(0)
+        , _eventMask(eventMask)
+        , _inOp(false)
+        , _opStamp(0)
+        , _stop(false)
+        , _failed(false)
+        , _startNs(trace_detail::nowNs())
+{
+    static_assert(std::is_trivially_copyable<Element>::value,
+                  "Trace recorder writes keys byte-wise, Element must be trivially copyable");
+
+    _file.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!_file.is_open())
+        throw std::invalid_argument("Error opening trace file for output");
+
+    _buf.resize(_bufRecords * trace_detail::recordSize(sizeof(Element)));
+    _backBuf.resize(_buf.size());
+
+    // заголовок: сигнатура, версия, размер ключа
+    std::uint32_t keySize = sizeof(Element);
+    _file.write(trace_detail::TRACE_MAGIC, sizeof(trace_detail::TRACE_MAGIC));
+    _file.write(reinterpret_cast<const char *>(&trace_detail::TRACE_VERSION), sizeof(std::uint32_t));
+    _file.write(reinterpret_cast<const char *>(&keySize), sizeof(keySize));
+    if (!_file)
+        throw std::runtime_error("Failed to write trace file header");
+
+    _writer = std::thread(&RBTreeTraceRecorder::writerLoop, this);
+}
+
+
+template<typename Element, typename Compar>
+RBTreeTraceRecorder<Element, Compar>::~RBTreeTraceRecorder()
+{
+    drain();
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _writer.join();
+    _file.close();
+}
+
+
+template<typename Element, typename Compar>
+void RBTreeTraceRecorder<Element, Compar>::rbTreeEvent(TEvent ev, TTree *tr, TTreeNode *nd)
+{
+    (void)tr;
+
+    // вставка и удаление завершаются событиями DE_AFTER_INSERT / DE_AFTER_REMOVE
+    bool opEnd = ev == TDumper::DE_AFTER_INSERT;
+#ifdef RBTREE_WITH_DELETION
+    opEnd = opEnd || ev == TDumper::DE_AFTER_REMOVE;
+#endif // RBTREE_WITH_DELETION
+
+    if (!(_eventMask & eventBit(ev)))
+    {
+        if (opEnd)
+            _inOp = false;
+        return;
+    }
+
+    if (_head == _bufRecords)
+        submit();
+
+    // часы — самая дорогая часть записи: одна метка на операцию
+    if (!_inOp)
+    {
+        _opStamp = trace_detail::nowNs() - _startNs;
+        _inOp = true;
+    }
+    std::uint8_t evCode = static_cast<std::uint8_t>(ev);
+
+    unsigned char *rec = &_buf[_head * trace_detail::recordSize(sizeof(Element))];
+    std::memcpy(rec, &_opStamp, sizeof(_opStamp));
+    std::memcpy(rec + sizeof(_opStamp), &evCode, sizeof(evCode));
+    std::memcpy(rec + sizeof(_opStamp) + sizeof(evCode), &nd->getKey(), sizeof(Element));
+
+    ++_head;
+    ++_eventsNum;
+    if (opEnd)
+        _inOp = false;
+}
+
+
+template<typename Element, typename Compar>
+void RBTreeTraceRecorder<Element, Compar>::flush()
+{
+    drain();
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    if (_failed)
+        throw std::runtime_error("Failed to write trace file");
+}
+
+
+template<typename Element, typename Compar>
+void RBTreeTraceRecorder<Element, Compar>::drain()
+{
+    if (_head != 0)
+        submit();
+
+    std::unique_lock<std::mutex> lock(_mtx);
+    _cv.wait(lock, [this]() { return _backBytes == 0; });
+}
+
+
+template<typename Element, typename Compar>
+void RBTreeTraceRecorder<Element, Compar>::submit()
+{
+    std::unique_lock<std::mutex> lock(_mtx);
+    _cv.wait(lock, [this]() { return _backBytes == 0; });
+
+    _buf.swap(_backBuf);
+    _backBytes = _head * trace_detail::recordSize(sizeof(Element));
+    _head = 0;
+
+    lock.unlock();
+    _cv.notify_all();
+}
+
+
+template<typename Element, typename Compar>
+void RBTreeTraceRecorder<Element, Compar>::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mtx);
+    for (;;)
+    {
+        _cv.wait(lock, [this]() { return _backBytes != 0 || _stop; });
+        if (_backBytes == 0)
+            return;                             // остановка, и все отданное уже записано
+
+        // пишем без мьютекса: _backBuf не трогают, пока _backBytes не обнулен;
+        // после первой ошибки журнал уже неполон, блоки лишь освобождаем
+        std::size_t bytes = _backBytes;
+        bool failed = _failed;
+        lock.unlock();
+        if (!failed)
+        {
+            _file.write(reinterpret_cast<const char *>(&_backBuf[0]), bytes);
+            _file.flush();
+            failed = !_file;
+        }
+        lock.lock();
+
+        _failed = failed;
+        _backBytes = 0;
+        _cv.notify_all();
+    }
+}
+
+
+//==============================================================================
+// class RBTreeTraceReplayer
+//==============================================================================
+
+template<typename Element, typename Compar>
+RBTreeTraceReplayer<Element, Compar>::RBTreeTraceReplayer(const std::string &fileName)
+{
+    _file.open(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!_file.is_open())
+        throw std::invalid_argument("Error opening trace file for input");
+
+    char magic[sizeof(trace_detail::TRACE_MAGIC)];
+    std::uint32_t version = 0;
+    std::uint32_t keySize = 0;
+    _file.read(magic, sizeof(magic));
+    _file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    _file.read(reinterpret_cast<char *>(&keySize), sizeof(keySize));
+
+    if (!_file || std::memcmp(magic, trace_detail::TRACE_MAGIC, sizeof(magic)) != 0)
+        throw std::invalid_argument("Not a RBTree trace file");
+    if (version != trace_detail::TRACE_VERSION)
+        throw std::invalid_argument("Unsupported RBTree trace version");
+    if (keySize != sizeof(Element))
+        throw std::invalid_argument("Trace key size does not match Element");
+
+    _dataPos = _file.tellg();
+}
+
+
+template<typename Element, typename Compar>
+bool RBTreeTraceReplayer<Element, Compar>::next(Record &rec)
+{
+    unsigned char raw[sizeof(std::uint64_t) + sizeof(std::uint8_t) + sizeof(Element)];
+    if (!_file.read(reinterpret_cast<char *>(raw), sizeof(raw)))
+        return false;
+
+    std::uint8_t evCode;
+    std::memcpy(&rec.timestamp, raw, sizeof(rec.timestamp));
+    std::memcpy(&evCode, raw + sizeof(rec.timestamp), sizeof(evCode));
+    std::memcpy(&rec.key, raw + sizeof(rec.timestamp) + sizeof(evCode), sizeof(Element));
+    rec.event = static_cast<typename TDumper::RBTreeDumperEvent>(evCode);
+
+    return true;
+}
+
+
+template<typename Element, typename Compar>
+void RBTreeTraceReplayer<Element, Compar>::rewind()
+{
+    _file.clear();
+    _file.seekg(_dataPos);
+}
+
+
+template<typename Element, typename Compar>
+std::uint64_t RBTreeTraceReplayer<Element, Compar>::replayTo(TTree &tree, std::uint64_t eventsNum)
+{
+    if (!tree.isEmpty())
+        throw std::invalid_argument("Trace can be replayed into an empty tree only");
+
+    rewind();
+
+    Record rec;
+    std::uint64_t done = 0;
+    while (done < eventsNum && next(rec))
+    {
+        ++done;
+
+        // повторяем только события, меняющие множество ключей
+        if (rec.event == TDumper::DE_AFTER_INSERT)
+            tree.insert(rec.key);
+#ifdef RBTREE_WITH_DELETION
+        else if (rec.event == TDumper::DE_AFTER_REMOVE)
+            tree.remove(rec.key);
+#endif // RBTREE_WITH_DELETION
+    }
+
+    return done;
+}
+
+
+} // namespace xi
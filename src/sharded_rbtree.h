@@ -0,0 +1,233 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Красно-черное дерево, разбитое на шарды по диапазонам ключей
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Пространство ключей делится разделителями на полуинтервалы, каждый из которых
+/// хранится в отдельном \c RBTree со своей блокировкой. Писатели, попадающие в разные
+/// шарды, не мешают друг другу, поэтому при равномерных ключах пропускная способность
+/// вставок растет с числом ядер. Разбиение подстраивается под нагрузку: переполненный
+/// или "горячий" шард делится пополам, маленькие соседи сливаются.
+///
+/// "Реализация" соответствующих методов располагается в файле sharded_rbtree.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_SHARDED_RBTREE_H_
+#define RBTREE_SHARDED_RBTREE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "epoch.h"
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+
+/** \brief Красно-черное дерево из независимых шардов по диапазонам ключей.
+ *
+ *  Шард \c i хранит ключи из [\c splitter[i-1], \c splitter[i]). Карта шардов неизменяема
+ *  и публикуется атомарным указателем: операция над ключом читает карту под
+ *  \c EpochManager::ReaderGuard (запись только в собственный слот читателя) и берет
+ *  блокировку одного шарда. Перестройка (деление и слияние) строит новую карту,
+ *  помечает вынутые шарды выведенными под их блокировками и публикует карту;
+ *  старые карта и шарды освобождаются, когда их не может видеть ни один читатель.
+ *  Операция, заставшая свой шард выведенным, перечитывает карту.
+ *
+ *  Обход и диапазонные запросы идут по шардам по возрастанию их диапазонов, поэтому
+ *  порядок глобальный; согласованность снимка гарантируется только внутри шарда.
+ */
+template<typename Element, typename Compar = std::less<Element> >
+class ShardedRBTree
+{
+public:
+    typedef RBTree<Element, Compar> TTree;
+
+    /** \brief Наибольший размер шарда по умолчанию. */
+    static const std::size_t DEF_MAX_SHARD_SIZE = 1 << 16;
+
+    /** \brief Шард, получивший больше \c HOT_FACTOR средних долей обращений, считается горячим. */
+    static const std::size_t HOT_FACTOR = 4;
+
+    /** \brief Горячий шард меньше этого размера не делится: дальше делить бесполезно. */
+    static const std::size_t MIN_SPLIT_SIZE = 64;
+
+    /** \brief Через сколько записей в шард проверяется, не пора ли перестроить карту вокруг него. */
+    static const std::size_t HOT_CHECK_PERIOD = 1024;
+
+    /** \brief Сколько ключей делимого шарда пересчитывается за одно взятие его блокировки. */
+    static const std::size_t SPLIT_COUNT_CHUNK = 1024;
+
+public:
+    /** \brief Создает пустое дерево из одного шарда; шарды делятся, когда превышают \c maxShardSize. */
+    explicit ShardedRBTree(std::size_t maxShardSize = DEF_MAX_SHARD_SIZE);
+
+    /** \brief Создает пустое дерево с заранее заданными (строго возрастающими) разделителями. */
+    ShardedRBTree(const std::vector<Element> &splitters, std::size_t maxShardSize = DEF_MAX_SHARD_SIZE);
+
+    /** \brief Деструктор. Одновременных операций к этому моменту быть не должно. */
+    ~ShardedRBTree();
+
+public:
+    // Запись
+
+    /** \brief Вставляет \c key. Если он уже есть, генерирует \c std::invalid_argument, как \c RBTree::insert(). */
+    void insert(const Element &key);
+
+#ifdef RBTREE_WITH_DELETION
+
+    /** \brief Удаляет \c key. Если его нет, генерирует \c std::invalid_argument, как \c RBTree::remove(). */
+    void remove(const Element &key);
+
+#endif // RBTREE_WITH_DELETION
+
+public:
+    // Чтение
+
+    /** \brief Возвращает истину, если \c key есть в дереве. */
+    bool contains(const Element &key) const;
+
+    /** \brief Вызывает \c fn для каждого элемента в порядке возрастания. */
+    template<typename F>
+    void forEach(F fn) const;
+
+    /** \brief Вызывает \c fn для каждого элемента из полуинтервала [\c lo, \c hi) в порядке возрастания. */
+    template<typename F>
+    void forEachInRange(const Element &lo, const Element &hi, F fn) const;
+
+    /** \brief Возвращает число элементов. */
+    std::size_t getSize() const;
+
+    /** \brief Возвращает текущее число шардов. */
+    std::size_t getShardsNum() const;
+
+    /** \brief Возвращает текущие разделители шардов. */
+    std::vector<Element> getSplitters() const;
+
+protected:
+    ShardedRBTree(const ShardedRBTree &);                   ///< КК не доступен.
+    ShardedRBTree &operator=(const ShardedRBTree &);        ///< Присваивание недоступно.
+
+protected:
+    /** \brief Шард: дерево, его блокировка и счетчики для перестройки.
+     *
+     *  Пока шард готовится к делению, \c below — число его ключей меньше \c countedTo:
+     *  перестройка досчитывает их порциями, а запись ключа из уже сосчитанной части
+     *  поправляет счетчик (\c countKey()). Дойдя до \c pivot, она знает размер левой
+     *  половины без обхода под блокировкой.
+     */
+    struct Shard
+    {
+        Shard() : size(0), hits(0), retired(false), below(0) {}
+
+        /** \brief Учитывает вставку (\c added) или удаление ключа \c key в счетчике \c below. Под lock. */
+        void countKey(const Compar &compar, const Element &key, bool added)
+        {
+            if (!countedTo || !compar(key, *countedTo))
+                return;
+            if (added)
+                ++below;
+            else
+                --below;
+        }
+
+        TTree tree;                             ///< Ключи шарда.
+        mutable std::mutex lock;                ///< Блокировка дерева шарда.
+        std::size_t size;                       ///< Число ключей (под lock).
+        std::atomic<std::size_t> hits;          ///< Обращения на запись с последней перестройки.
+        bool retired;                           ///< Шард вынут из карты делением или слиянием (под lock).
+
+        std::optional<Element> pivot;           ///< Ключ будущего деления (под lock).
+        std::optional<Element> countedTo;       ///< Граница сосчитанной части: ключи меньше нее (под lock).
+        std::size_t below;                      ///< Число ключей меньше \c countedTo (под lock).
+    };
+
+    /** \brief Неизменяемая карта шардов. */
+    struct ShardMap
+    {
+        std::vector<Shard *> shards;            ///< Шарды по возрастанию диапазонов.
+        std::vector<Element> splitters;         ///< Разделители: splitters[i] — наименьший ключ шарда i + 1.
+    };
+
+    /** \brief Возвращает номер шарда карты \c map, которому принадлежит \c key. */
+    std::size_t shardOf(const ShardMap &map, const Element &key) const;
+
+    /** \brief Находит шард ключа \c key в текущей карте и блокирует его в \c sl.
+     *
+     *  Вызывается под \c EpochManager::ReaderGuard. Если шард успели вывести из карты,
+     *  перечитывает карту, поэтому возвращенный шард всегда действующий.
+     */
+    Shard &lockShardOf(const Element &key, std::unique_lock<std::mutex> &sl) const;
+
+    /** \brief Вызывает \c fn для каждого элемента из [\c *lo, \c *hi) по возрастанию;
+     *  пустой указатель — отсутствие соответствующей границы.
+     */
+    template<typename F>
+    void visit(const Element *lo, const Element *hi, F fn) const;
+
+    /** \brief Перестраивает карту вокруг шарда \c sh, если он все еще нуждается в этом. */
+    void maintain(const Shard *sh);
+
+    /** \brief Возвращает суммарное число обращений ко всем шардам карты \c map. */
+    static std::size_t getTotalHits(const ShardMap &map);
+
+    /** \brief Возвращает число ключей шарда \c sh, взяв его блокировку. */
+    static std::size_t sizeOf(const Shard &sh);
+
+    /** \brief Возвращает истину, если шард с \c hits обращениями из \c total горячий
+     *  при общем числе шардов \c shardsNum.
+     */
+    static bool isHot(std::size_t hits, std::size_t total, std::size_t shardsNum);
+
+    /** \brief Выбирает ключ деления шарда \c sh (ключ корня) и считает ключи меньше него
+     *  порциями по \c SPLIT_COUNT_CHUNK, отпуская блокировку шарда между порциями.
+     *  Вызывается под \c _maintainLock.
+     */
+    void countForSplit(Shard &sh);
+
+    /** \brief Делит шард \c idx текущей карты по ключу, подготовленному \c countForSplit():
+     *  ключи от него и больше уходят во второй из двух новых шардов. Вызывается под \c _maintainLock.
+     */
+    void splitShard(std::size_t idx);
+
+    /** \brief Сливает шард \c idx + 1 текущей карты в шард \c idx. Вызывается под \c _maintainLock. */
+    void mergeShards(std::size_t idx);
+
+    /** \brief Публикует карту \c next вместо текущей и откладывает освобождение старой. */
+    void publish(ShardMap *next);
+
+    /** \brief Функции отложенного освобождения для \c EpochManager. */
+    static void destroyShard(void *sh);
+    static void destroyMap(void *map);
+
+protected:
+    std::atomic<const ShardMap *> _map;         ///< Текущая карта шардов.
+    std::mutex _maintainLock;                   ///< Сериализует перестройки карты.
+    mutable EpochManager _epochs;               ///< Отложенное освобождение старых карт и вынутых шардов.
+
+    std::size_t _maxShardSize;                  ///< Наибольший размер шарда.
+    Compar _compar;                             ///< Компаратор.
+
+
+    // Специальный подход, позволяющий следующему классу иметь доступ к закрытым членам для их тестирования.
+    template<typename, typename>
+    friend
+    class ShardedRBTreeTest;
+
+}; // class ShardedRBTree
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "sharded_rbtree.hpp"
+
+#endif // RBTREE_SHARDED_RBTREE_H_
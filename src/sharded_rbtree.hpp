@@ -0,0 +1,447 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация красно-черного дерева, разбитого на шарды
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле sharded_rbtree.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>        // std::upper_bound
+#include <optional>
+#include <stdexcept>        // std::invalid_argument
+#include <thread>           // std::this_thread::yield
+
+
+namespace xi
+{
+
+
+template<typename Element, typename Compar>
+ShardedRBTree<Element, Compar>::ShardedRBTree(std::size_t maxShardSize)
+        : _maxShardSize(maxShardSize ? maxShardSize : 1)
+{
+    ShardMap *map = new ShardMap;
+    map->shards.push_back(new Shard);
+    _map.store(map);
+}
+
+
+template<typename Element, typename Compar>
+ShardedRBTree<Element, Compar>::ShardedRBTree(const std::vector<Element> &splitters, std::size_t maxShardSize)
+        : _maxShardSize(maxShardSize ? maxShardSize : 1)
+{
+    for (std::size_t i = 1; i < splitters.size(); ++i)
+        if (!_compar(splitters[i - 1], splitters[i]))
+            throw std::invalid_argument("Splitters must be strictly increasing");
+
+    ShardMap *map = new ShardMap;
+    map->splitters = splitters;
+    for (std::size_t i = 0; i <= splitters.size(); ++i)
+        map->shards.push_back(new Shard);
+    _map.store(map);
+}
+
+
+template<typename Element, typename Compar>
+ShardedRBTree<Element, Compar>::~ShardedRBTree()
+{
+    // выведенные шарды и старые карты освободит _epochs
+    const ShardMap *map = _map.load();
+    for (std::size_t i = 0; i < map->shards.size(); ++i)
+        delete map->shards[i];
+    delete map;
+}
+
+
+template<typename Element, typename Compar>
+std::size_t ShardedRBTree<Element, Compar>::shardOf(const ShardMap &map, const Element &key) const
+{
+    // шард i начинается с splitters[i - 1]: ищем первый разделитель больше ключа
+    return static_cast<std::size_t>(std::upper_bound(map.splitters.begin(), map.splitters.end(), key, _compar)
+                                    - map.splitters.begin());
+}
+
+
+template<typename Element, typename Compar>
+typename ShardedRBTree<Element, Compar>::Shard &
+ShardedRBTree<Element, Compar>::lockShardOf(const Element &key, std::unique_lock<std::mutex> &sl) const
+{
+    for (;;)
+    {
+        const ShardMap *map = _map.load(std::memory_order_acquire);
+        Shard &sh = *map->shards[shardOf(*map, key)];
+        sl = std::unique_lock<std::mutex>(sh.lock);
+        if (!sh.retired)
+            return sh;
+
+        // шард поделили или слили после чтения карты: новая карта уже опубликована
+        sl.unlock();
+    }
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::insert(const Element &key)
+{
+    const Shard *needsMaintain = nullptr;
+    {
+        EpochManager::ReaderGuard guard(_epochs);
+        std::unique_lock<std::mutex> sl;
+        Shard &sh = lockShardOf(key, sl);
+
+        // дубликат RBTree::insert() отвергает исключением, не меняя множества ключей
+        sh.tree.insert(key);
+        ++sh.size;
+        sh.countKey(_compar, key, true);
+
+        std::size_t hits = ++sh.hits;
+        if (sh.size > _maxShardSize || hits % HOT_CHECK_PERIOD == 0)
+            needsMaintain = &sh;
+    }
+
+    // перестройка берет блокировки шардов, поэтому только после снятия своей
+    if (needsMaintain)
+        maintain(needsMaintain);
+}
+
+
+#ifdef RBTREE_WITH_DELETION
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::remove(const Element &key)
+{
+    const Shard *needsMaintain = nullptr;
+    {
+        EpochManager::ReaderGuard guard(_epochs);
+        std::unique_lock<std::mutex> sl;
+        Shard &sh = lockShardOf(key, sl);
+
+        sh.tree.remove(key);
+        --sh.size;
+        sh.countKey(_compar, key, false);
+
+        // слияние проверяем, когда шард только что стал маленьким или опустел
+        std::size_t hits = ++sh.hits;
+        if (hits % HOT_CHECK_PERIOD == 0 || sh.size + 1 == _maxShardSize / 8 || sh.size == 0)
+            needsMaintain = &sh;
+    }
+
+    if (needsMaintain)
+        maintain(needsMaintain);
+}
+
+#endif // RBTREE_WITH_DELETION
+
+
+template<typename Element, typename Compar>
+bool ShardedRBTree<Element, Compar>::contains(const Element &key) const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    std::unique_lock<std::mutex> sl;
+    const Shard &sh = lockShardOf(key, sl);
+    return sh.tree.find(key) != nullptr;
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void ShardedRBTree<Element, Compar>::forEach(F fn) const
+{
+    visit(nullptr, nullptr, fn);
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void ShardedRBTree<Element, Compar>::forEachInRange(const Element &lo, const Element &hi, F fn) const
+{
+    visit(&lo, &hi, fn);
+}
+
+
+template<typename Element, typename Compar>
+template<typename F>
+void ShardedRBTree<Element, Compar>::visit(const Element *lo, const Element *hi, F fn) const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+
+    // Диапазоны шардов не пересекаются и упорядочены — сливать достаточно подряд.
+    // from — наименьший еще не пройденный ключ: с него продолжаем по новой карте,
+    // если очередной шард успели вывести.
+    std::optional<Element> from;
+    if (lo)
+        from = *lo;
+
+    const ShardMap *map = _map.load(std::memory_order_acquire);
+    std::size_t i = from ? shardOf(*map, *from) : 0;
+    while (i < map->shards.size())
+    {
+        // только шарды, чьи диапазоны пересекаются с [lo, hi)
+        if (hi && i > 0 && !_compar(map->splitters[i - 1], *hi))
+            break;
+
+        const Shard &sh = *map->shards[i];
+        std::unique_lock<std::mutex> sl(sh.lock);
+        if (sh.retired)
+        {
+            sl.unlock();
+            map = _map.load(std::memory_order_acquire);
+            i = from ? shardOf(*map, *from) : 0;
+            continue;
+        }
+
+        // Шард ограничиваем диапазоном по карте: слияние могло добавить в него ключи следующего
+        // шарда, а тот, выведенный, пройдем заново по новой карте.
+        const Element *last = (i < map->splitters.size()) ? &map->splitters[i] : nullptr;
+        typename TTree::ConstIterator it = from ? sh.tree.lowerBound(*from) : sh.tree.begin();
+        for (; it != sh.tree.end() && (!hi || _compar(*it, *hi)) && (!last || _compar(*it, *last)); ++it)
+            fn(*it);
+
+        if (i < map->splitters.size())
+            from = map->splitters[i];
+        ++i;
+    }
+}
+
+
+template<typename Element, typename Compar>
+std::size_t ShardedRBTree<Element, Compar>::getSize() const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    const ShardMap *map = _map.load(std::memory_order_acquire);
+
+    // у слитого шарда размер обнулен, у поделенного — прежний: сумма по любой карте верна
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < map->shards.size(); ++i)
+        n += sizeOf(*map->shards[i]);
+    return n;
+}
+
+
+template<typename Element, typename Compar>
+std::size_t ShardedRBTree<Element, Compar>::getShardsNum() const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    return _map.load(std::memory_order_acquire)->shards.size();
+}
+
+
+template<typename Element, typename Compar>
+std::vector<Element> ShardedRBTree<Element, Compar>::getSplitters() const
+{
+    EpochManager::ReaderGuard guard(_epochs);
+    return _map.load(std::memory_order_acquire)->splitters;
+}
+
+
+template<typename Element, typename Compar>
+std::size_t ShardedRBTree<Element, Compar>::getTotalHits(const ShardMap &map)
+{
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < map.shards.size(); ++i)
+        total += map.shards[i]->hits.load();
+    return total;
+}
+
+
+template<typename Element, typename Compar>
+std::size_t ShardedRBTree<Element, Compar>::sizeOf(const Shard &sh)
+{
+    std::lock_guard<std::mutex> sl(sh.lock);
+    return sh.size;
+}
+
+
+template<typename Element, typename Compar>
+bool ShardedRBTree<Element, Compar>::isHot(std::size_t hits, std::size_t total, std::size_t shardsNum)
+{
+    // горячий — забирает больше половины всех записей или в HOT_FACTOR раз больше средней доли
+    return hits > 0 && (2 * hits > total || hits * shardsNum > HOT_FACTOR * total);
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::maintain(const Shard *sh)
+{
+    // карту меняет только перестройка, поэтому под _maintainLock она и ее шарды неизменны
+    std::lock_guard<std::mutex> ml(_maintainLock);
+    const ShardMap *map = _map.load();
+
+    // пока ждали, шард могли уже поделить или слить
+    std::size_t idx = 0;
+    while (idx < map->shards.size() && map->shards[idx] != sh)
+        ++idx;
+    if (idx == map->shards.size())
+        return;
+
+    Shard &cur = *map->shards[idx];
+    std::size_t curSize = sizeOf(cur);
+    std::size_t total = getTotalHits(*map);
+    std::size_t n = map->shards.size();
+
+    if (curSize > _maxShardSize || (curSize >= MIN_SPLIT_SIZE && isHot(cur.hits.load(), total, n)))
+    {
+        countForSplit(cur);
+        splitShard(idx);
+    }
+    else if (n > 1 && curSize < _maxShardSize / 8)
+    {
+        // Маленький шард сливаем с меньшим из соседей, если результат не станет горячим:
+        // иначе слитый шард тут же поделился бы снова. Пустой сливаем всегда.
+        std::size_t left = idx;
+        if (idx + 1 == n || (idx > 0 && sizeOf(*map->shards[idx - 1]) < sizeOf(*map->shards[idx + 1])))
+            left = idx - 1;
+
+        const Shard &a = *map->shards[left];
+        const Shard &b = *map->shards[left + 1];
+        if (curSize == 0
+            || (sizeOf(a) + sizeOf(b) <= _maxShardSize / 2 && !isHot(a.hits.load() + b.hits.load(), total, n - 1)))
+            mergeShards(left);
+    }
+
+    // старые обращения постепенно забываются, чтобы горячими считались текущие диапазоны
+    map = _map.load();
+    for (std::size_t i = 0; i < map->shards.size(); ++i)
+        map->shards[i]->hits.store(map->shards[i]->hits.load() / 2);
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::countForSplit(Shard &sh)
+{
+    for (bool first = true; ; first = false)
+    {
+        // между порциями пропускаем ждущих писателей шарда
+        if (!first)
+            std::this_thread::yield();
+
+        std::lock_guard<std::mutex> sl(sh.lock);
+        if (!sh.pivot)
+        {
+            if (!sh.tree.getRoot())
+                return;
+
+            // корень красно-черного дерева делит его ключи примерно пополам
+            sh.pivot = sh.tree.getRoot()->getKey();
+            sh.below = 0;
+        }
+
+        // порция: от первого несосчитанного ключа, но не дальше pivot
+        typename TTree::ConstIterator it = sh.countedTo ? sh.tree.lowerBound(*sh.countedTo) : sh.tree.begin();
+        std::size_t n = 0;
+        for (; n < SPLIT_COUNT_CHUNK && it != sh.tree.end() && _compar(*it, *sh.pivot); ++n, ++it)
+            ++sh.below;
+
+        if (it == sh.tree.end() || !_compar(*it, *sh.pivot))
+        {
+            sh.countedTo = sh.pivot;
+            return;
+        }
+        sh.countedTo = *it;
+    }
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::splitShard(std::size_t idx)
+{
+    const ShardMap *map = _map.load();
+    Shard &old = *map->shards[idx];
+
+    Shard *left = new Shard;
+    Shard *right = new Shard;
+    {
+        std::lock_guard<std::mutex> sl(old.lock);
+
+        // размер левой половины сосчитан заранее: сам раздел обхода не требует
+        std::size_t leftSize = old.below;
+        std::optional<Element> pivot = old.pivot;
+        old.pivot.reset();
+        old.countedTo.reset();
+        old.below = 0;
+
+        if (!pivot || leftSize == 0 || leftSize == old.size)
+        {
+            delete left;
+            delete right;
+            return;
+        }
+
+        // узлы переходят в новые шарды без копирования, за O(log n)
+        old.tree.split(*pivot, left->tree, right->tree);
+        left->size = leftSize;
+        right->size = old.size - leftSize;
+
+        left->hits.store(old.hits.load() / 2);
+        right->hits.store(old.hits.load() / 2);
+
+        ShardMap *next = new ShardMap(*map);
+        next->shards[idx] = left;
+        next->shards.insert(next->shards.begin() + idx + 1, right);
+        next->splitters.insert(next->splitters.begin() + idx, *pivot);
+
+        // карту публикуем, пока держим шард: заставший его выведенным уже увидит новую
+        old.retired = true;
+        publish(next);
+    }
+
+    _epochs.retire(&old, &destroyShard);
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::mergeShards(std::size_t idx)
+{
+    const ShardMap *map = _map.load();
+    Shard &a = *map->shards[idx];
+    Shard &b = *map->shards[idx + 1];
+    {
+        // писатели держат не больше одного шарда, поэтому двум блокировкам порядок не важен
+        std::lock_guard<std::mutex> la(a.lock);
+        std::lock_guard<std::mutex> lb(b.lock);
+
+        // склейка за O(log n): все ключи a меньше разделителя, а значит, и ключей b
+        a.tree.join(a.tree, b.tree);
+        a.size += b.size;
+        b.size = 0;
+        a.hits.store(a.hits.load() + b.hits.load());
+
+        ShardMap *next = new ShardMap(*map);
+        next->shards.erase(next->shards.begin() + idx + 1);
+        next->splitters.erase(next->splitters.begin() + idx);
+
+        // a остается в карте и лишь расширяет диапазон, выводится только b
+        b.retired = true;
+        publish(next);
+    }
+
+    _epochs.retire(&b, &destroyShard);
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::publish(ShardMap *next)
+{
+    const ShardMap *prev = _map.load();
+    _map.store(next, std::memory_order_release);
+    _epochs.retire(const_cast<ShardMap *>(prev), &destroyMap);
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::destroyShard(void *sh)
+{
+    delete static_cast<Shard *>(sh);
+}
+
+
+template<typename Element, typename Compar>
+void ShardedRBTree<Element, Compar>::destroyMap(void *map)
+{
+    delete static_cast<ShardMap *>(map);
+}
+
+
+} // namespace xi
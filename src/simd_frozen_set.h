@@ -0,0 +1,156 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Неизменяемое множество целых чисел в статической B-древесной раскладке
+///            с поиском внутри узла на SIMD
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Для целочисленных ключей (4 и 8 байт) снимок дерева раскладывается по узлам
+/// из \c NODE_KEYS ключей, выровненным по кэш-линиям (для 4-байтных ключей узел —
+/// ровно одна линия, для 8-байтных — две соседние). Узел k имеет NODE_KEYS+1 сыновей,
+/// k*(NODE_KEYS+1)+i+1, поэтому указатели не хранятся. Внутри узла ранг ключа
+/// считается сравнением сразу всех ключей узла (AVX2 или SSE) и подсчетом единиц
+/// в маске; вариант выбирается в рантайме по возможностям процессора, при их
+/// отсутствии используется скалярный код. Один промах кэша приходится на
+/// log2(NODE_KEYS + 1) уровней двоичного дерева вместо одного.
+///
+/// "Реализация" соответствующих методов располагается в файле simd_frozen_set.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_SIMD_FROZEN_SET_H_
+#define RBTREE_SIMD_FROZEN_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+
+/** \brief Неизменяемое множество целых чисел со SIMD-поиском по узлам B-дерева.
+ *
+ *  \tparam T Целочисленный тип размером 4 или 8 байт (знаковый или беззнаковый).
+ *  Беззнаковые ключи хранятся со сдвигом на знаковый бит, чтобы все варианты
+ *  поиска пользовались знаковым сравнением.
+ */
+template<typename T>
+class SimdFrozenSet
+{
+public:
+    static_assert(std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8),
+                  "SimdFrozenSet supports 4- and 8-byte integral keys only");
+
+    /** \brief Знаковый тип того же размера, в котором хранятся ключи. */
+    typedef typename std::conditional<sizeof(T) == 4, std::int32_t, std::int64_t>::type TStored;
+
+    /** \brief Вариант поиска внутри узла. */
+    enum SimdLevel
+    {
+        SIMD_SCALAR,                    ///< Скалярный код.
+        SIMD_SSE,                       ///< SSE2 (4-байтные ключи) или SSE4.2 (8-байтные).
+        SIMD_AVX2                       ///< AVX2.
+    };
+
+    /** \brief Число ключей в узле. */
+    static const std::size_t NODE_KEYS = 16;
+
+    /** \brief Выравнивание узлов. */
+    static const std::size_t CACHE_LINE = 64;
+
+public:
+    /** \brief Создает пустое множество. */
+    SimdFrozenSet();
+
+    /** \brief Строит множество из \c n ключей, перечисляемых итератором \c first
+     *  в строго возрастающем порядке.
+     *
+     *  \param maxLevel Наибольший допустимый вариант поиска; фактический — не выше
+     *  поддерживаемого процессором.
+     */
+    template<typename InputIt>
+    SimdFrozenSet(InputIt first, std::size_t n, SimdLevel maxLevel = SIMD_AVX2);
+
+    SimdFrozenSet(SimdFrozenSet &&other);               ///< Перемещающий конструктор.
+    SimdFrozenSet &operator=(SimdFrozenSet &&other);    ///< Перемещающее присваивание.
+
+    ~SimdFrozenSet();                                   ///< Деструктор.
+
+public:
+    /** \brief Возвращает истину, если \c key содержится в множестве. */
+    bool contains(T key) const;
+
+    /** \brief Ищет наименьший ключ, не меньший \c key, и кладет его в \c out.
+     *  \returns ложь, если такого ключа нет.
+     */
+    bool lowerBound(T key, T &out) const;
+
+    /** \brief Возвращает число ключей. */
+    std::size_t getSize() const { return _size; }
+
+    /** \brief Возвращает истину, если множество пусто. */
+    bool isEmpty() const { return _size == 0; }
+
+    /** \brief Возвращает вариант поиска, выбранный при построении. */
+    SimdLevel getSimdLevel() const { return _level; }
+
+    /** \brief Возвращает наилучший вариант поиска, поддерживаемый процессором. */
+    static SimdLevel detectSimdLevel();
+
+protected:
+    SimdFrozenSet(const SimdFrozenSet &);               ///< КК не доступен.
+    SimdFrozenSet &operator=(const SimdFrozenSet &);    ///< Оператор присваивания недоступен.
+
+protected:
+    /** \brief Тип функции, возвращающей число ключей узла, меньших \c x. */
+    typedef std::size_t (*RankFn)(const TStored *node, TStored x);
+
+    /** \brief Переводит ключ во внутреннее (знаковое) представление. */
+    static TStored toStored(T key);
+
+    /** \brief Переводит ключ из внутреннего представления обратно. */
+    static T fromStored(TStored key);
+
+    /** \brief Номер \c i-го сына узла \c k. */
+    static std::size_t child(std::size_t k, std::size_t i) { return k * (NODE_KEYS + 1) + i + 1; }
+
+    /** \brief Рекурсивно заполняет поддерево узла \c k очередными ключами \c it. */
+    template<typename InputIt>
+    void fill(std::size_t k, InputIt &it, std::size_t &taken);
+
+    /** \brief Возвращает указатель на нижнюю грань \c x во внутреннем представлении
+     *  (возможно, на ключ-заполнитель) или \c nullptr.
+     */
+    const TStored *lowerBoundStored(TStored x) const;
+
+    /** \brief Освобождает память. */
+    void release();
+
+protected:
+    void *_mem;                                 ///< Сырой (невыровненный) блок памяти.
+    TStored *_nodes;                            ///< Узлы подряд, по NODE_KEYS ключей.
+    std::size_t _nodesNum;                      ///< Число узлов.
+    std::size_t _size;                          ///< Число ключей.
+    TStored _maxKey;                            ///< Наибольший настоящий ключ (хвост заполнен максимумом типа).
+
+    SimdLevel _level;                           ///< Выбранный вариант поиска.
+    RankFn _rank;                               ///< Функция поиска внутри узла.
+}; // class SimdFrozenSet
+
+
+/** \brief Строит SIMD-снимок целочисленного дерева. */
+template<typename T>
+SimdFrozenSet<T> freezeSimd(const RBTree<T, std::less<T> > &tree);
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "simd_frozen_set.hpp"
+
+#endif // RBTREE_SIMD_FROZEN_SET_H_
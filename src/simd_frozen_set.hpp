@@ -0,0 +1,337 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация множества целых чисел со SIMD-поиском по узлам B-дерева
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" (шаблонов) методов, описанных в файле simd_frozen_set.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <new>              // operator new
+#include <cstdint>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define XI_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+namespace xi
+{
+
+/** \brief Функции ранга ключа внутри узла из 16 ключей: число ключей узла, меньших \c x. */
+namespace simd_detail
+{
+
+template<typename TStored>
+std::size_t rankScalar(const TStored *node, TStored x)
+{
+    std::size_t r = 0;
+    for (std::size_t i = 0; i < 16; ++i)
+        r += static_cast<std::size_t>(node[i] < x);
+    return r;
+}
+
+#ifdef XI_SIMD_X86
+
+// Функции собираются под нужный набор инструкций атрибутом target, поэтому весь
+// проект компилируется без -mavx2, а вызываются они только после проверки процессора.
+
+__attribute__((target("sse2")))
+inline std::size_t rankSse(const std::int32_t *node, std::int32_t x)
+{
+    __m128i vx = _mm_set1_epi32(x);
+    unsigned m = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i keys = _mm_load_si128(reinterpret_cast<const __m128i *>(node + 4 * i));
+        __m128i lt = _mm_cmpgt_epi32(vx, keys);
+        m |= static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(lt))) << (4 * i);
+    }
+    return static_cast<std::size_t>(__builtin_popcount(m));
+}
+
+__attribute__((target("avx2")))
+inline std::size_t rankAvx2(const std::int32_t *node, std::int32_t x)
+{
+    __m256i vx = _mm256_set1_epi32(x);
+    __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i *>(node));
+    __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i *>(node + 8));
+    unsigned mlo = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vx, lo))));
+    unsigned mhi = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vx, hi))));
+    return static_cast<std::size_t>(__builtin_popcount(mlo | (mhi << 8)));
+}
+
+__attribute__((target("sse4.2")))
+inline std::size_t rankSse(const std::int64_t *node, std::int64_t x)
+{
+    __m128i vx = _mm_set1_epi64x(x);
+    unsigned m = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        __m128i keys = _mm_load_si128(reinterpret_cast<const __m128i *>(node + 2 * i));
+        __m128i lt = _mm_cmpgt_epi64(vx, keys);
+        m |= static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(lt))) << (2 * i);
+    }
+    return static_cast<std::size_t>(__builtin_popcount(m));
+}
+
+__attribute__((target("avx2")))
+inline std::size_t rankAvx2(const std::int64_t *node, std::int64_t x)
+{
+    __m256i vx = _mm256_set1_epi64x(x);
+    unsigned m = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        __m256i keys = _mm256_load_si256(reinterpret_cast<const __m256i *>(node + 4 * i));
+        __m256i lt = _mm256_cmpgt_epi64(vx, keys);
+        m |= static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(lt))) << (4 * i);
+    }
+    return static_cast<std::size_t>(__builtin_popcount(m));
+}
+
+#endif // XI_SIMD_X86
+
+} // namespace simd_detail
+
+
+//==============================================================================
+// class SimdFrozenSet
+//==============================================================================
+
+template<typename T>
+SimdFrozenSet<T>::SimdFrozenSet()
+        : _mem(nullptr)
+        , _nodes(nullptr)
+        , _nodesNum(0)
+        , _size(0)
+        , _maxKey(0)
+        , _level(SIMD_SCALAR)
+        , _rank(&simd_detail::rankScalar<TStored>)
+{
+}
+
+
+template<typename T>
+template<typename InputIt>
+SimdFrozenSet<T>::SimdFrozenSet(InputIt first, std::size_t n, SimdLevel maxLevel)
+        : _mem(nullptr)
+        , _nodes(nullptr)
+        , _nodesNum(0)
+        , _size(n)
+        , _maxKey(0)
+        , _level(SIMD_SCALAR)
+        , _rank(&simd_detail::rankScalar<TStored>)
+{
+    static_assert(NODE_KEYS == 16, "rank functions are written for 16-key nodes");
+
+    // выбираем вариант поиска
+    _level = detectSimdLevel();
+    if (maxLevel < _level)
+        _level = maxLevel;
+#ifdef XI_SIMD_X86
+    if (_level == SIMD_AVX2)
+        _rank = static_cast<RankFn>(&simd_detail::rankAvx2);
+    else if (_level == SIMD_SSE)
+        _rank = static_cast<RankFn>(&simd_detail::rankSse);
+#endif // XI_SIMD_X86
+
+    if (n == 0)
+        return;
+
+    _nodesNum = (n + NODE_KEYS - 1) / NODE_KEYS;
+    _mem = ::operator new(_nodesNum * NODE_KEYS * sizeof(TStored) + CACHE_LINE);
+    std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(_mem);
+    addr = (addr + CACHE_LINE - 1) & ~static_cast<std::uintptr_t>(CACHE_LINE - 1);
+    _nodes = reinterpret_cast<TStored *>(addr);
+
+    std::size_t taken = 0;
+    fill(0, first, taken);
+}
+
+
+template<typename T>
+SimdFrozenSet<T>::SimdFrozenSet(SimdFrozenSet &&other)
+        : _mem(other._mem)
+        , _nodes(other._nodes)
+        , _nodesNum(other._nodesNum)
+        , _size(other._size)
+        , _maxKey(other._maxKey)
+        , _level(other._level)
+        , _rank(other._rank)
+{
+    other._mem = nullptr;
+    other._nodes = nullptr;
+    other._nodesNum = 0;
+    other._size = 0;
+}
+
+
+template<typename T>
+SimdFrozenSet<T> &SimdFrozenSet<T>::operator=(SimdFrozenSet &&other)
+{
+    if (this == &other)
+        return *this;
+
+    release();
+
+    _mem = other._mem;
+    _nodes = other._nodes;
+    _nodesNum = other._nodesNum;
+    _size = other._size;
+    _maxKey = other._maxKey;
+    _level = other._level;
+    _rank = other._rank;
+
+    other._mem = nullptr;
+    other._nodes = nullptr;
+    other._nodesNum = 0;
+    other._size = 0;
+
+    return *this;
+}
+
+
+template<typename T>
+SimdFrozenSet<T>::~SimdFrozenSet()
+{
+    release();
+}
+
+
+template<typename T>
+void SimdFrozenSet<T>::release()
+{
+    ::operator delete(_mem);
+    _mem = nullptr;
+    _nodes = nullptr;
+    _nodesNum = 0;
+    _size = 0;
+}
+
+
+template<typename T>
+typename SimdFrozenSet<T>::SimdLevel SimdFrozenSet<T>::detectSimdLevel()
+{
+#ifdef XI_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (sizeof(TStored) == 8 ? __builtin_cpu_supports("sse4.2") : __builtin_cpu_supports("sse2"))
+        return SIMD_SSE;
+#endif // XI_SIMD_X86
+    return SIMD_SCALAR;
+}
+
+
+template<typename T>
+typename SimdFrozenSet<T>::TStored SimdFrozenSet<T>::toStored(T key)
+{
+    // для беззнаковых сдвигаем на знаковый бит: порядок сохраняется при знаковом сравнении
+    typedef typename std::make_unsigned<T>::type TUnsigned;
+    if (std::is_unsigned<T>::value)
+        key = static_cast<T>(static_cast<TUnsigned>(key) ^ (TUnsigned(1) << (sizeof(T) * 8 - 1)));
+    return static_cast<TStored>(key);
+}
+
+
+template<typename T>
+T SimdFrozenSet<T>::fromStored(TStored key)
+{
+    typedef typename std::make_unsigned<T>::type TUnsigned;
+    T res = static_cast<T>(key);
+    if (std::is_unsigned<T>::value)
+        res = static_cast<T>(static_cast<TUnsigned>(res) ^ (TUnsigned(1) << (sizeof(T) * 8 - 1)));
+    return res;
+}
+
+
+template<typename T>
+template<typename InputIt>
+void SimdFrozenSet<T>::fill(std::size_t k, InputIt &it, std::size_t &taken)
+{
+    if (k >= _nodesNum)
+        return;
+
+    // симметричный обход: сын i, ключ i, ..., последний сын
+    TStored *node = _nodes + k * NODE_KEYS;
+    for (std::size_t i = 0; i < NODE_KEYS; ++i)
+    {
+        fill(child(k, i), it, taken);
+        if (taken < _size)
+        {
+            node[i] = toStored(static_cast<T>(*it));
+            _maxKey = node[i];
+            ++it;
+            ++taken;
+        }
+        else
+            node[i] = std::numeric_limits<TStored>::max();
+    }
+    fill(child(k, NODE_KEYS), it, taken);
+}
+
+
+template<typename T>
+const typename SimdFrozenSet<T>::TStored *SimdFrozenSet<T>::lowerBoundStored(TStored x) const
+{
+    const TStored *res = nullptr;
+
+    std::size_t k = 0;
+    while (k < _nodesNum)
+    {
+        const TStored *node = _nodes + k * NODE_KEYS;
+        std::size_t i = _rank(node, x);
+        if (i < NODE_KEYS)
+            res = node + i;
+        k = child(k, i);
+    }
+
+    return res;
+}
+
+
+template<typename T>
+bool SimdFrozenSet<T>::contains(T key) const
+{
+    TStored x = toStored(key);
+
+    // ключи больше наибольшего могли бы совпасть только с заполнителем
+    if (_size == 0 || _maxKey < x)
+        return false;
+
+    const TStored *lb = lowerBoundStored(x);
+    return lb && *lb == x;
+}
+
+
+template<typename T>
+bool SimdFrozenSet<T>::lowerBound(T key, T &out) const
+{
+    TStored x = toStored(key);
+    if (_size == 0 || _maxKey < x)
+        return false;
+
+    const TStored *lb = lowerBoundStored(x);
+    if (!lb)
+        return false;
+
+    out = fromStored(*lb);
+    return true;
+}
+
+
+template<typename T>
+SimdFrozenSet<T> freezeSimd(const RBTree<T, std::less<T> > &tree)
+{
+    std::size_t n = 0;
+    for (typename RBTree<T, std::less<T> >::ConstIterator it = tree.begin(); it != tree.end(); ++it)
+        ++n;
+
+    return SimdFrozenSet<T>(tree.begin(), n);
+}
+
+
+} // namespace xi
@@ -0,0 +1,152 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Пул потоков для рекурсивного параллелизма "разделяй и властвуй"
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Основная операция — \c invoke(f1, f2): выполнить две независимые половины
+/// работы, по возможности параллельно. Вторая половина выставляется в очередь пула,
+/// первая выполняется вызывающим потоком. Если к моменту окончания первой половины
+/// вторую еще никто не взял, вызывающий забирает ее обратно и выполняет сам; если взял,
+/// вызывающий, ожидая, выполняет другие задачи. Поэтому вложенные \c invoke()
+/// не блокируют потоки пула и не приводят к взаимоблокировке.
+///
+/// Очереди — по одной на поток пула (и одна общая для сторонних потоков). Поток кладет
+/// и берет свои задачи с конца очереди, а оставшись без работы, крадет из начала чужих:
+/// там лежат самые крупные, раньше всех отщепленные половины.
+///
+/// "Реализация" соответствующих методов располагается в файле task_pool.hpp.
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_TASK_POOL_H_
+#define RBTREE_TASK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>        // std::exception_ptr
+#include <functional>       // std::function
+#include <memory>           // std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace xi
+{
+
+
+/** \brief Пул потоков с fork-join вызовом \c invoke() и кражей работы. */
+class TaskPool
+{
+public:
+    /** \brief Куски меньше этого \c sort() сортирует одним потоком. */
+    static const std::size_t SORT_GRAIN = 1 << 14;
+
+public:
+    /** \brief Создает пул из \c threadsNum потоков (вместе с вызывающим работают
+     *  \c threadsNum + 1). 0 — по числу аппаратных потоков минус один.
+     */
+    explicit TaskPool(std::size_t threadsNum = 0);
+
+    /** \brief Деструктор. Дожидается завершения потоков; задач в очереди быть не должно. */
+    ~TaskPool();
+
+public:
+    /** \brief Выполняет \c f1() и \c f2(), возможно, параллельно, и возвращается, когда обе завершились.
+     *
+     *  Исключение из любой половины пробрасывается вызывающему (после завершения обеих).
+     */
+    template<typename F1, typename F2>
+    void invoke(F1 &&f1, F2 &&f2);
+
+    /** \brief Сортирует [\c first, \c last) по \c comp слиянием: половины сортируются
+     *  через \c invoke(), куски меньше \c SORT_GRAIN — \c std::sort().
+     */
+    template<typename RandomIt, typename Compar>
+    void sort(RandomIt first, RandomIt last, Compar comp);
+
+    /** \brief Возвращает число потоков пула (без вызывающих). */
+    std::size_t getThreadsNum() const { return _threads.size(); }
+
+    /** \brief Возвращает, на сколько уровней стоит делить рекурсивную работу, чтобы кусков
+     *  было с запасом больше, чем потоков: ceil(log2(потоки + 1)) + \c SPLIT_SLACK.
+     */
+    int getSplitDepth() const;
+
+public:
+    /** \brief Лишние уровни деления сверх числа потоков: куски разного размера выравниваются кражей. */
+    static const int SPLIT_SLACK = 3;
+
+protected:
+    TaskPool(const TaskPool &);                 ///< КК не доступен.
+    TaskPool &operator=(const TaskPool &);      ///< Присваивание недоступно.
+
+protected:
+    /** \brief Задача в очереди; живет на стеке вызвавшего \c invoke(). */
+    struct Task
+    {
+        std::function<void()> fn;               ///< Работа.
+        std::atomic<bool> done;                 ///< Выполнена.
+        std::exception_ptr error;               ///< Исключение из работы.
+    };
+
+    /** \brief Очередь задач одного потока. */
+    struct alignas(64) Queue
+    {
+        std::mutex lock;                        ///< Блокировка очереди.
+        std::deque<Task *> tasks;               ///< Задачи: свои — с конца, краденые — с начала.
+    };
+
+    /** \brief Пул и номер очереди, к которым привязан текущий поток. */
+    struct ThreadSlot
+    {
+        const TaskPool *pool;
+        std::size_t queue;
+    };
+
+    /** \brief Возвращает привязку текущего потока. */
+    static ThreadSlot &threadSlot();
+
+    /** \brief Возвращает номер очереди текущего потока: свой у потоков пула, общий у остальных. */
+    std::size_t myQueue() const;
+
+    /** \brief Выполняет задачу и отмечает ее выполненной. */
+    static void run(Task *task);
+
+    /** \brief Выставляет задачу в очередь текущего потока. */
+    void push(Task *task);
+
+    /** \brief Забирает задачу из очереди обратно, если ее еще никто не взял. */
+    bool reclaim(Task *task);
+
+    /** \brief Берет задачу: с конца своей очереди, иначе — из начала чужой. */
+    Task *take(std::size_t own);
+
+    /** \brief Выполняет одну задачу, если она есть. */
+    bool runOne();
+
+    /** \brief Цикл потока пула с очередью \c idx. */
+    void workerLoop(std::size_t idx);
+
+protected:
+    std::vector<std::thread> _threads;          ///< Потоки пула.
+    std::vector<std::unique_ptr<Queue> > _queues; ///< Очереди потоков пула и последняя — общая для сторонних.
+    std::atomic<std::size_t> _pending;          ///< Число задач во всех очередях.
+    std::atomic<std::size_t> _sleeping;         ///< Число спящих потоков пула.
+
+    std::mutex _lock;                           ///< Блокировка ожидания работы.
+    std::condition_variable _cv;                ///< Сигнал о новой задаче или остановке.
+    bool _stop;                                 ///< Пора останавливаться (под \c _lock).
+}; // class TaskPool
+
+
+} // namespace xi
+
+
+// Подключаем "реализационную" часть
+#include "task_pool.hpp"
+
+#endif // RBTREE_TASK_POOL_H_
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Реализация пула потоков для рекурсивного параллелизма
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// "Реализация" методов, описанных в файле task_pool.h
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>        // std::find, std::sort, std::inplace_merge
+#include <iterator>         // std::next
+
+
+namespace xi
+{
+
+
+inline TaskPool::TaskPool(std::size_t threadsNum)
+        : _pending(0), _sleeping(0), _stop(false)
+{
+    if (threadsNum == 0)
+    {
+        unsigned hw = std::thread::hardware_concurrency();
+        threadsNum = (hw > 1) ? hw - 1 : 1;
+    }
+
+    // очереди создаются до потоков: потоки только читают этот вектор
+    for (std::size_t i = 0; i <= threadsNum; ++i)
+        _queues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+    for (std::size_t i = 0; i < threadsNum; ++i)
+        _threads.push_back(std::thread(&TaskPool::workerLoop, this, i));
+}
+
+
+inline TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _cv.notify_all();
+
+    for (std::size_t i = 0; i < _threads.size(); ++i)
+        _threads[i].join();
+}
+
+
+inline int TaskPool::getSplitDepth() const
+{
+    int depth = 0;
+    while ((std::size_t(1) << depth) < _threads.size() + 1)
+        ++depth;
+    return depth + SPLIT_SLACK;
+}
+
+
+template<typename F1, typename F2>
+void TaskPool::invoke(F1 &&f1, F2 &&f2)
+{
+    Task task;
+    task.fn = [&f2]() { f2(); };
+    task.done.store(false);
+    push(&task);
+
+    // задача лежит на нашем стеке: до выхода она обязана быть выполнена или забрана
+    std::exception_ptr error;
+    try
+    {
+        f1();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    if (reclaim(&task))
+        run(&task);
+    else
+        while (!task.done.load())
+            if (!runOne())
+                std::this_thread::yield();
+
+    if (error)
+        std::rethrow_exception(error);
+    if (task.error)
+        std::rethrow_exception(task.error);
+}
+
+
+template<typename RandomIt, typename Compar>
+void TaskPool::sort(RandomIt first, RandomIt last, Compar comp)
+{
+    std::size_t n = static_cast<std::size_t>(last - first);
+    if (n <= SORT_GRAIN)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    RandomIt mid = first + n / 2;
+    invoke([&]() { sort(first, mid, comp); },
+           [&]() { sort(mid, last, comp); });
+    std::inplace_merge(first, mid, last, comp);
+}
+
+
+inline TaskPool::ThreadSlot &TaskPool::threadSlot()
+{
+    thread_local ThreadSlot slot = { nullptr, 0 };
+    return slot;
+}
+
+
+inline std::size_t TaskPool::myQueue() const
+{
+    const ThreadSlot &slot = threadSlot();
+    return (slot.pool == this) ? slot.queue : _queues.size() - 1;
+}
+
+
+inline void TaskPool::run(Task *task)
+{
+    try
+    {
+        task->fn();
+    }
+    catch (...)
+    {
+        task->error = std::current_exception();
+    }
+    task->done.store(true);
+}
+
+
+inline void TaskPool::push(Task *task)
+{
+    Queue &q = *_queues[myQueue()];
+    {
+        std::lock_guard<std::mutex> lock(q.lock);
+        q.tasks.push_back(task);
+        ++_pending;
+    }
+
+    // спящий поток проверяет _pending под _lock после того, как отметился в _sleeping,
+    // поэтому либо он увидит задачу, либо мы увидим его и разбудим
+    if (_sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _cv.notify_one();
+    }
+}
+
+
+inline bool TaskPool::reclaim(Task *task)
+{
+    Queue &q = *_queues[myQueue()];
+    std::lock_guard<std::mutex> lock(q.lock);
+
+    // своя задача обычно последняя: после нее вложенные invoke() уже все забрали;
+    // в общей очереди сторонних потоков после нее могут лежать чужие
+    std::deque<Task *>::reverse_iterator it = std::find(q.tasks.rbegin(), q.tasks.rend(), task);
+    if (it == q.tasks.rend())
+        return false;
+
+    q.tasks.erase(std::next(it).base());
+    --_pending;
+    return true;
+}
+
+
+inline TaskPool::Task *TaskPool::take(std::size_t own)
+{
+    if (_pending.load() == 0)
+        return nullptr;
+
+    {
+        Queue &q = *_queues[own];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (!q.tasks.empty())
+        {
+            Task *task = q.tasks.back();
+            q.tasks.pop_back();
+            --_pending;
+            return task;
+        }
+    }
+
+    // своих нет — крадем самую старую (крупную) задачу у соседей по кругу
+    for (std::size_t i = 1; i < _queues.size(); ++i)
+    {
+        Queue &q = *_queues[(own + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if (!q.tasks.empty())
+        {
+            Task *task = q.tasks.front();
+            q.tasks.pop_front();
+            --_pending;
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+
+inline bool TaskPool::runOne()
+{
+    Task *task = take(myQueue());
+    if (!task)
+        return false;
+
+    run(task);
+    return true;
+}
+
+
+inline void TaskPool::workerLoop(std::size_t idx)
+{
+    threadSlot().pool = this;
+    threadSlot().queue = idx;
+
+    for (;;)
+    {
+        Task *task = take(idx);
+        if (task)
+        {
+            run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_lock);
+        ++_sleeping;
+        _cv.wait(lock, [this]() { return _stop || _pending.load() > 0; });
+        --_sleeping;
+        if (_stop && _pending.load() == 0)
+            return;                             // работы не осталось
+    }
+}
+
+
+} // namespace xi
@@ -0,0 +1,119 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::ConcurrentRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "concurrent_rbtree.h"
+
+
+using namespace xi;
+
+typedef ConcurrentRBTree<int> ConcurrentInt;
+
+
+// записи видны после набора пакета или flush()
+TEST(ConcurrentRBTreeTest, batches1)
+{
+    ConcurrentInt tree(4, std::chrono::hours(1));   // задержка не успевает истечь
+
+    tree.insert(1);
+    tree.insert(2);
+    tree.insert(3);
+    EXPECT_FALSE(tree.contains(1));         // пакет еще не набран
+
+    tree.insert(3);                         // дубликат молча пропускается
+    EXPECT_TRUE(tree.contains(1));
+    EXPECT_TRUE(tree.contains(3));
+
+#ifdef RBTREE_WITH_DELETION
+    tree.remove(2);
+    tree.remove(100);                       // отсутствующий тоже
+    tree.insert(2);                         // порядок операций над одним ключом сохраняется
+    tree.remove(2);
+    tree.flush();
+    EXPECT_FALSE(tree.contains(2));
+#endif // RBTREE_WITH_DELETION
+
+    std::vector<int> all;
+    tree.forEach([&all](int k) { all.push_back(k); });
+    ASSERT_EQ(2u, all.size());
+    EXPECT_EQ(1, all[0]);
+    EXPECT_EQ(3, all[1]);
+}
+
+
+// недобранный пакет применяется по истечении задержки, даже если записи прекратились
+TEST(ConcurrentRBTreeTest, maxDelay1)
+{
+    ConcurrentInt tree(1000, std::chrono::milliseconds(2));
+
+    tree.insert(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_TRUE(tree.contains(1));          // чтение застало очередь старой
+
+    // и запись, заставшая очередь старой, применяет ее вместе с собой
+    tree.insert(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    tree.insert(3);
+    std::vector<int> all;
+    tree.forEach([&all](int k) { all.push_back(k); });
+    EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), all);
+}
+
+
+TEST(ConcurrentRBTreeTest, range1)
+{
+    ConcurrentInt tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(i * 10);
+    tree.flush();
+
+    std::vector<int> got;
+    tree.forEachInRange(15, 55, [&got](int k) { got.push_back(k); });
+    ASSERT_EQ(4u, got.size());
+    EXPECT_EQ(20, got[0]);
+    EXPECT_EQ(50, got[3]);
+}
+
+
+// писатели и читатели одновременно
+TEST(ConcurrentRBTreeTest, threads1)
+{
+    ConcurrentInt tree(16);
+    const int WRITERS = 4;
+    const int PER_WRITER = 2000;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w)
+        threads.push_back(std::thread([&tree, w]() {
+            for (int i = 0; i < PER_WRITER; ++i)
+                tree.insert(w * PER_WRITER + i);
+        }));
+    for (int r = 0; r < 4; ++r)
+        threads.push_back(std::thread([&tree]() {
+            for (int i = 0; i < 5000; ++i)
+                tree.contains(i);
+        }));
+    for (std::size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    tree.flush();
+    int num = 0;
+    int prev = -1;
+    tree.forEach([&num, &prev](int k) { EXPECT_LT(prev, k); prev = k; ++num; });
+    EXPECT_EQ(WRITERS * PER_WRITER, num);
+}
@@ -242,6 +242,8 @@ protected:
         static const char* INFOS_REC1   = "Recolor 1";
         static const char* INFOS_ROT3D  = "Recolor 3 dad";
         static const char* INFOS_ROT3G  = "Recolor 3 grandpa";
+        static const char* INFOS_BSTREM = "BST Remove";
+        static const char* INFOS_REMOVE = "RBT Remove";
 
 
         // повороты
@@ -263,6 +265,14 @@ protected:
         if (ev == IRBTreeDumper<Element, Compar>::DE_AFTER_INSERT)
             return INFOS_INSERT;
 
+#ifdef RBTREE_WITH_DELETION
+        // удаление до и после балансировки
+        if (ev == IRBTreeDumper<Element, Compar>::DE_AFTER_BST_REMOVE)
+            return INFOS_BSTREM;
+        if (ev == IRBTreeDumper<Element, Compar>::DE_AFTER_REMOVE)
+            return INFOS_REMOVE;
+#endif // RBTREE_WITH_DELETION
+
         // NB: в принципе, в следующем if-е нет необходимости, т.к. это единственная
         // возможная ветка, однако, если вдруг будут свдиги вверх/вниз или появятся новые
         // секции, обработать этот момент будет проще.
@@ -0,0 +1,221 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::DurableRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "durable_rbtree.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef DurableRBTree<int> DurableInt;
+
+
+// содержимое дерева по возрастанию
+static std::vector<int> contents(const DurableInt& tree)
+{
+    std::vector<int> out;
+    tree.snapshot().forEach([&out](int x) { out.push_back(x); });
+    return out;
+}
+
+
+// число сегментов журнала в каталоге
+static int segmentsNum(const std::string& dir)
+{
+    int n = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(dir))
+        if (entry.path().filename().string().compare(0, 4, "wal-") == 0)
+            ++n;
+    return n;
+}
+
+
+// ошибка файла под потоком контрольной точки доходит до вызывающего с исходным текстом
+TEST(DurableRBTreeTest, fileOutBufError1)
+{
+    if (!std::filesystem::exists("/dev/full"))
+        return;                             // негде получить ENOSPC
+
+    durable::AppendFile file;
+    file.open("/dev/full", false);
+    durable::FileOutBuf buf(file);
+    std::ostream os(&buf);
+
+    std::vector<char> data(1 << 17, 'x');
+    os.write(data.data(), static_cast<std::streamsize>(data.size()));
+    os.flush();
+    EXPECT_FALSE(os);
+
+    try
+    {
+        buf.checkError();
+        ADD_FAILURE() << "no error stored";
+    }
+    catch (const std::runtime_error &e)
+    {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("/dev/full"));
+    }
+}
+
+
+// состояние восстанавливается из журнала и из контрольной точки с хвостом журнала
+TEST(DurableRBTreeTest, recover1)
+{
+    std::string dir = freshDir("durable_rbtree", "recover1");
+    std::vector<int> expected;
+
+    {
+        DurableInt tree(dir, 0, 256);
+        for (int i = 0; i < 200; ++i)
+            EXPECT_TRUE(tree.insert(i));
+        EXPECT_FALSE(tree.insert(5));
+        for (int i = 0; i < 200; i += 2)
+            EXPECT_TRUE(tree.remove(i));
+        EXPECT_FALSE(tree.remove(0));
+        expected = contents(tree);
+    }
+    EXPECT_GT(segmentsNum(dir), 1);
+
+    {
+        DurableInt tree(dir, 0, 256);
+        EXPECT_EQ(expected, contents(tree));
+
+        tree.checkpoint();
+        EXPECT_EQ(0, segmentsNum(dir));
+
+        for (int i = 1000; i < 1010; ++i)
+            tree.insert(i);
+        tree.remove(1);
+        expected = contents(tree);
+    }
+
+    {
+        DurableInt tree(dir, 0, 256);
+        EXPECT_EQ(expected, contents(tree));
+        EXPECT_EQ(100u + 10 - 1, tree.snapshot().getSize());
+
+        // контрольная точка без изменений после нее
+        tree.checkpoint();
+    }
+
+    {
+        DurableInt tree(dir, 0, 256);
+        EXPECT_EQ(expected, contents(tree));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+
+// недописанная при падении запись отбрасывается, дальше журнал пишется как обычно
+TEST(DurableRBTreeTest, tornTail1)
+{
+    std::string dir = freshDir("durable_rbtree", "torn1");
+
+    {
+        DurableInt tree(dir, 0);
+        for (int i = 0; i < 10; ++i)
+            tree.insert(i);
+    }
+
+    // имитируем падение посреди записи: хвост из половины записи
+    std::string last;
+    for (const auto& entry : std::filesystem::directory_iterator(dir))
+        last = std::max(last, entry.path().string());
+    {
+        std::ofstream out(last, std::ios::binary | std::ios::app);
+        out.write("\x0b\0\0\0\0\0\0\0\x01\x07", 10);
+    }
+
+    {
+        DurableInt tree(dir, 0);
+        EXPECT_EQ(10u, tree.snapshot().getSize());
+        tree.insert(10);
+    }
+
+    {
+        DurableInt tree(dir, 0);
+        EXPECT_EQ(11u, tree.snapshot().getSize());
+        EXPECT_TRUE(tree.contains(10));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+
+// писатели из многих потоков; записи не теряются, сбросов не больше, чем операций
+TEST(DurableRBTreeTest, groupCommit1)
+{
+    std::string dir = freshDir("durable_rbtree", "group1");
+    const int THREADS = 8;
+    const int PER_THREAD = 100;
+
+    {
+        DurableInt tree(dir, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t)
+            threads.push_back(std::thread([&tree, t]() {
+                for (int i = 0; i < 100; ++i)
+                    tree.insert(t * 100 + i);
+            }));
+        for (std::thread& th : threads)
+            th.join();
+
+        EXPECT_LE(tree.getSyncsNum(), static_cast<std::uint64_t>(THREADS * PER_THREAD));
+    }
+
+    {
+        DurableInt tree(dir, 0);
+        EXPECT_EQ(static_cast<std::size_t>(THREADS * PER_THREAD), tree.snapshot().getSize());
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+
+// фоновая контрольная точка по размеру журнала
+TEST(DurableRBTreeTest, backgroundCheckpoint1)
+{
+    std::string dir = freshDir("durable_rbtree", "background1");
+
+    {
+        DurableInt tree(dir, 1024, 512);
+        for (int i = 0; i < 500; ++i)
+            tree.insert(i);
+
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (tree.getCheckpointsNum() == 0 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        EXPECT_GT(tree.getCheckpointsNum(), 0u);
+
+        for (int i = 500; i < 600; ++i)
+            tree.insert(i);
+    }
+
+    EXPECT_TRUE(std::filesystem::exists(dir + "/checkpoint"));
+    {
+        DurableInt tree(dir, 0);
+        EXPECT_EQ(600u, tree.snapshot().getSize());
+    }
+
+    std::filesystem::remove_all(dir);
+}
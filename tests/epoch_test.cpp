@@ -0,0 +1,120 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::EpochManager
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+#include "rbtree.h"
+
+
+using namespace xi;
+
+
+static int freedNum = 0;
+
+static void countFree(void *obj)
+{
+    ++freedNum;
+    delete static_cast<int *>(obj);
+}
+
+
+// пока читатель активен, вынутые при нем объекты не освобождаются
+TEST(EpochManagerTest, retire1)
+{
+    freedNum = 0;
+    {
+        EpochManager em;
+        std::atomic<bool> entered(false);
+        std::atomic<bool> release(false);
+
+        std::thread reader([&em, &entered, &release]()
+        {
+            EpochManager::ReaderGuard guard(em);
+            entered.store(true);
+            while (!release.load())
+                std::this_thread::yield();
+        });
+        while (!entered.load())
+            std::this_thread::yield();
+
+        for (std::size_t i = 0; i < 10 * EpochManager::ADVANCE_PERIOD; ++i)
+            em.retire(new int(0), &countFree);
+
+        // эпоха продвинулась не больше чем на одну, ничего не освобождено
+        EXPECT_EQ(0, freedNum);
+        EXPECT_EQ(10 * EpochManager::ADVANCE_PERIOD, em.getRetiredNum());
+
+        release.store(true);
+        reader.join();
+
+        em.synchronize();
+        EXPECT_EQ(static_cast<int>(10 * EpochManager::ADVANCE_PERIOD), freedNum);
+        EXPECT_EQ(0u, em.getRetiredNum());
+
+        // оставшееся освобождает деструктор
+        em.retire(new int(0), &countFree);
+    }
+    EXPECT_EQ(static_cast<int>(10 * EpochManager::ADVANCE_PERIOD) + 1, freedNum);
+}
+
+
+// читатели ищут, пока писатель удаляет и вставляет узлы (ошибки ловит ASan)
+TEST(EpochManagerTest, treeReaders1)
+{
+    const int KEYS = 2000;
+
+    EpochManager em;
+    RBTree<int> tree;
+    tree.setReclaimer(&em);
+    for (int i = 0; i < KEYS; ++i)
+        tree.insert(i);
+
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r)
+        readers.emplace_back([&em, &tree, &done]()
+        {
+            while (!done.load())
+            {
+                EpochManager::ReaderGuard guard(em);
+                for (int k = 0; k < KEYS; k += 7)
+                {
+                    const RBTree<int>::Node *nd = tree.find(k);
+                    if (nd)
+                    {
+                        EXPECT_EQ(k, nd->getKey());
+                    }
+                }
+            }
+        });
+
+    for (int round = 0; round < 5; ++round)
+    {
+        for (int i = 0; i < KEYS; i += 2)
+            tree.remove(i);
+        for (int i = 0; i < KEYS; i += 2)
+            tree.insert(i);
+    }
+    done.store(true);
+
+    for (std::thread &t : readers)
+        t.join();
+
+    for (int i = 0; i < KEYS; ++i)
+        EXPECT_NE(nullptr, tree.find(i));
+}
@@ -0,0 +1,124 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::ExternalLoader
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "external_loader.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef ExternalLoader<int> LoaderInt;
+
+
+// много отрезков (больше, чем сливается за проход), повторы внутри отрезков и между ними
+TEST(ExternalLoaderTest, manyRuns1)
+{
+    std::string dir = freshDir("external_loader", "many1");
+    std::set<int> expected;
+    RBTreeInt tree;
+
+    {
+        LoaderInt loader(dir, 50 * sizeof(int));
+        unsigned x = 12345;
+        for (int i = 0; i < 10000; ++i)
+        {
+            x = x * 1103515245u + 12345u;
+            int key = static_cast<int>((x >> 8) % 3000);
+            loader.add(key);
+            expected.insert(key);
+        }
+        EXPECT_GT(loader.getRunsNum(), std::size_t(LoaderInt::MAX_FAN_IN));
+
+        loader.build(tree);
+        EXPECT_EQ(0u, loader.getRunsNum());
+        EXPECT_TRUE(std::filesystem::is_empty(dir));
+    }
+
+    EXPECT_EQ(std::vector<int>(expected.begin(), expected.end()), std::vector<int>(tree.begin(), tree.end()));
+    EXPECT_TRUE(tree.getRoot()->isBlack());
+    checkRB(tree.getRoot());
+
+    // дерево обычное: его можно менять
+    tree.insert(-1);
+    tree.remove(*expected.begin());
+    checkRB(tree.getRoot());
+
+    std::filesystem::remove_all(dir);
+}
+
+
+// все помещается в буфер; пустой загрузчик; загрузчик после build() снова пригоден
+TEST(ExternalLoaderTest, inMemory1)
+{
+    std::string dir = freshDir("external_loader", "memory1");
+    LoaderInt loader(dir);
+
+    RBTreeInt empty;
+    loader.build(empty);
+    EXPECT_TRUE(empty.isEmpty());
+
+    std::vector<int> keys = { 5, 1, 5, 3, 1 };
+    loader.add(keys.begin(), keys.end());
+    RBTreeInt tree;
+    loader.build(tree);
+    EXPECT_EQ(0u, loader.getRunsNum());
+    EXPECT_EQ(std::vector<int>({ 1, 3, 5 }), std::vector<int>(tree.begin(), tree.end()));
+
+    // в непустое дерево строить нельзя
+    loader.add(7);
+    EXPECT_THROW(loader.build(tree), std::invalid_argument);
+
+    RBTreeInt again;
+    loader.build(again);
+    EXPECT_EQ(std::vector<int>({ 7 }), std::vector<int>(again.begin(), again.end()));
+
+    std::filesystem::remove_all(dir);
+}
+
+
+// строки из текстового потока
+TEST(ExternalLoaderTest, strings1)
+{
+    std::string dir = freshDir("external_loader", "strings1");
+
+    std::stringstream text;
+    std::set<std::string> expected;
+    for (int i = 0; i < 500; ++i)
+    {
+        std::string word = "w" + std::to_string(i * 7 % 211);
+        text << word << ' ';
+        expected.insert(word);
+    }
+
+    RBTree<std::string> tree;
+    ExternalLoader<std::string> loader(dir, 20 * sizeof(std::string));
+    loader.add(std::istream_iterator<std::string>(text), std::istream_iterator<std::string>());
+    EXPECT_GT(loader.getRunsNum(), 1u);
+    loader.build(tree);
+
+    EXPECT_EQ(std::vector<std::string>(expected.begin(), expected.end()),
+              std::vector<std::string>(tree.begin(), tree.end()));
+
+    std::filesystem::remove_all(dir);
+}
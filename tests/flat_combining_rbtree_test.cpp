@@ -0,0 +1,111 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::FlatCombiningRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "flat_combining_rbtree.h"
+
+
+using namespace xi;
+
+typedef FlatCombiningRBTree<int> FCInt;
+
+
+// одиночный поток: семантика как у RBTree
+TEST(FlatCombiningRBTreeTest, basic1)
+{
+    FCInt tree;
+    for (int i = 0; i < 100; ++i)
+        tree.insert((i * 37) % 100);
+
+    EXPECT_THROW(tree.insert(5), std::invalid_argument);
+    EXPECT_TRUE(tree.contains(99));
+    EXPECT_FALSE(tree.contains(100));
+
+#ifdef RBTREE_WITH_DELETION
+    tree.remove(5);
+    EXPECT_FALSE(tree.contains(5));
+    EXPECT_THROW(tree.remove(5), std::invalid_argument);
+#endif // RBTREE_WITH_DELETION
+
+    int count = 0;
+    int prev = -1;
+    tree.forEach([&](int k) { EXPECT_LT(prev, k); prev = k; ++count; });
+    EXPECT_EQ(tree.contains(5) ? 100 : 99, count);
+}
+
+
+// писатели и читатели одновременно; каждая операция выполнена ровно один раз
+TEST(FlatCombiningRBTreeTest, concurrent1)
+{
+    const int PER_THREAD = 3000;
+    const int THREADS = 8;
+    FCInt tree;
+    std::atomic<int> duplicates(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+        threads.emplace_back([&tree, &duplicates, t]()
+        {
+            for (int i = 0; i < PER_THREAD; ++i)
+            {
+                tree.insert(i * THREADS + t);
+                EXPECT_TRUE(tree.contains(i * THREADS + t));
+
+                // все потоки пытаются вставить общий ключ — удается только одному
+                try
+                {
+                    tree.insert(-1 - i);
+                }
+                catch (const std::invalid_argument &)
+                {
+                    ++duplicates;
+                }
+#ifdef RBTREE_WITH_DELETION
+                if (i % 2)
+                    tree.remove(i * THREADS + t);
+#endif // RBTREE_WITH_DELETION
+            }
+        });
+    for (std::thread &th : threads)
+        th.join();
+
+    EXPECT_EQ(PER_THREAD * (THREADS - 1), duplicates.load());
+
+    int expected = -PER_THREAD;
+    tree.forEach([&expected](int k)
+    {
+        EXPECT_EQ(expected, k);
+        if (expected < -1)
+            ++expected;
+        else if (expected == -1)
+            expected = 0;
+        else
+        {
+#ifdef RBTREE_WITH_DELETION
+            // удалены ключи нечетных итераций i: переход к следующему четному i
+            ++expected;
+            if ((expected / THREADS) % 2)
+                expected += THREADS;
+#else
+            ++expected;
+#endif // RBTREE_WITH_DELETION
+        }
+    });
+    EXPECT_EQ(PER_THREAD * THREADS, expected);
+}
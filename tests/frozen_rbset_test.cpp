@@ -0,0 +1,94 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::FrozenRBSet
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "rbtree.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef FrozenRBSet<int> FrozenInt;
+
+
+// поиск и нижняя грань по всему диапазону, включая промежутки и края
+TEST(FrozenRBSetTest, find1)
+{
+    RBTreeInt tree;
+    for (int i = 0; i < 1000; i += 3)
+        tree.insert(i);
+
+    FrozenInt fr = tree.freeze();
+    EXPECT_EQ(334u, fr.getSize());
+
+    for (int i = -5; i < 1005; ++i)
+    {
+        EXPECT_EQ(i >= 0 && i < 1000 && i % 3 == 0, fr.contains(i));
+
+        const int* lb = fr.lowerBound(i);
+        if (i > 999)
+            EXPECT_EQ(nullptr, lb);
+        else
+        {
+            ASSERT_NE(nullptr, lb);
+            int expected = (i < 0) ? 0 : (i + 2) / 3 * 3;
+            EXPECT_EQ(expected, *lb);
+        }
+    }
+
+    // снимок не зависит от дерева
+    tree.insert(1);
+    EXPECT_FALSE(fr.contains(1));
+}
+
+
+// размеры, не являющиеся 2^k - 1, и пустое множество
+TEST(FrozenRBSetTest, sizes1)
+{
+    for (int n = 0; n < 70; ++n)
+    {
+        RBTreeInt tree;
+        for (int i = 0; i < n; ++i)
+            tree.insert(i * 2);
+
+        FrozenInt fr = tree.freeze();
+        EXPECT_EQ(static_cast<std::size_t>(n), fr.getSize());
+        for (int i = 0; i < n; ++i)
+        {
+            EXPECT_TRUE(fr.contains(i * 2));
+            EXPECT_FALSE(fr.contains(i * 2 + 1));
+        }
+        EXPECT_FALSE(fr.contains(-1));
+    }
+}
+
+
+// нетривиальный тип элементов и перемещение
+TEST(FrozenRBSetTest, strings1)
+{
+    std::vector<std::string> src;
+    for (char c = 'a'; c <= 'z'; ++c)
+        src.push_back(std::string(3, c));
+
+    FrozenRBSet<std::string> fr(src.begin(), src.size());
+    FrozenRBSet<std::string> moved(std::move(fr));
+
+    EXPECT_TRUE(fr.isEmpty());
+    EXPECT_TRUE(moved.contains("kkk"));
+    EXPECT_FALSE(moved.contains("kk"));
+    EXPECT_EQ(std::string("lll"), *moved.lowerBound("kkl"));
+}
@@ -0,0 +1,128 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::LockFreeSkipList
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "lock_free_skiplist.h"
+
+
+using namespace xi;
+
+typedef LockFreeSkipList<int> SkipListInt;
+
+
+// одиночный поток: совпадает с std::set
+TEST(LockFreeSkipListTest, basic1)
+{
+    SkipListInt list;
+    std::set<int> ref;
+    EXPECT_TRUE(list.isEmpty());
+
+    for (int i = 0; i < 3000; ++i)
+    {
+        int k = (i * 7919) % 1000;
+        if (i % 3 == 2)
+            EXPECT_EQ(ref.erase(k) == 1, list.tryRemove(k));
+        else
+            EXPECT_EQ(ref.insert(k).second, list.tryInsert(k));
+    }
+    EXPECT_EQ(ref.size(), list.getSize());
+
+    for (int k = -1; k <= 1000; ++k)
+    {
+        EXPECT_EQ(ref.count(k) == 1, list.contains(k));
+
+        int found = 0;
+        std::set<int>::const_iterator it = ref.lower_bound(k);
+        EXPECT_EQ(it != ref.end(), list.lowerBound(k, found));
+        if (it != ref.end())
+        {
+            EXPECT_EQ(*it, found);
+        }
+    }
+
+    std::vector<int> all;
+    list.forEach([&all](int k) { all.push_back(k); });
+    EXPECT_EQ(std::vector<int>(ref.begin(), ref.end()), all);
+
+    std::vector<int> range;
+    list.forEachInRange(100, 200, [&range](int k) { range.push_back(k); });
+    EXPECT_EQ(std::vector<int>(ref.lower_bound(100), ref.lower_bound(200)), range);
+
+    int present = *ref.begin();
+    EXPECT_THROW(list.insert(present), std::invalid_argument);
+    list.remove(present);
+    EXPECT_THROW(list.remove(present), std::invalid_argument);
+}
+
+
+// писатели вставляют и удаляют свои и общие ключи, читатели ищут
+TEST(LockFreeSkipListTest, concurrent1)
+{
+    const int PER_THREAD = 4000;
+    const int WRITERS = 4;
+    SkipListInt list;
+    std::atomic<bool> stop(false);
+    std::atomic<int> sharedInserted(0);
+
+    std::thread reader([&list, &stop]()
+    {
+        while (!stop.load())
+        {
+            int prev = -1000000;
+            list.forEach([&prev](int k) { EXPECT_LT(prev, k); prev = k; });
+            list.contains(0);
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < WRITERS; ++t)
+        writers.emplace_back([&list, &sharedInserted, t]()
+        {
+            for (int i = 0; i < PER_THREAD; ++i)
+            {
+                list.insert(i * WRITERS + t);
+
+                // общий ключ вставляет ровно один из писателей
+                if (list.tryInsert(-1 - i % 100))
+                    ++sharedInserted;
+                if (i % 3 == 0)
+                    list.remove(i * WRITERS + t);
+            }
+        });
+    for (std::thread &w : writers)
+        w.join();
+    stop.store(true);
+    reader.join();
+
+    EXPECT_EQ(100, sharedInserted.load());
+
+    std::set<int> ref;
+    for (int i = 0; i < PER_THREAD; ++i)
+        for (int t = 0; t < WRITERS; ++t)
+            if (i % 3 != 0)
+                ref.insert(i * WRITERS + t);
+    for (int i = 1; i <= 100; ++i)
+        ref.insert(-i);
+
+    std::vector<int> all;
+    list.forEach([&all](int k) { all.push_back(k); });
+    EXPECT_EQ(std::vector<int>(ref.begin(), ref.end()), all);
+    EXPECT_EQ(ref.size(), list.getSize());
+}
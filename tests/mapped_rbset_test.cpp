@@ -0,0 +1,148 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::MappedRBSet
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mapped_rbset.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef MappedRBSet<int> MappedInt;
+
+
+// путь к временному файлу теста
+static std::string tempPath(const char* name)
+{
+    return testing::TempDir() + "mapped_rbset_" + name + ".bin";
+}
+
+
+// поиск, нижняя грань и диапазоны по файлу, записанному из дерева
+TEST(MappedRBSetTest, find1)
+{
+    std::string path = tempPath("find1");
+
+    RBTreeInt tree;
+    for (int i = 0; i < 1000; i += 3)
+        tree.insert(i);
+    writeMapped(tree, path);
+
+    {
+        MappedInt set(path);
+        EXPECT_EQ(334u, set.getSize());
+
+        for (int i = -5; i < 1005; ++i)
+        {
+            EXPECT_EQ(i >= 0 && i < 1000 && i % 3 == 0, set.contains(i));
+
+            const int* lb = set.lowerBound(i);
+            if (i > 999)
+                EXPECT_EQ(nullptr, lb);
+            else
+            {
+                ASSERT_NE(nullptr, lb);
+                EXPECT_EQ((i < 0) ? 0 : (i + 2) / 3 * 3, *lb);
+            }
+        }
+
+        std::vector<int> all;
+        set.forEach([&all](int x) { all.push_back(x); });
+        EXPECT_EQ(std::vector<int>(tree.begin(), tree.end()), all);
+
+        std::vector<int> range;
+        set.forEachInRange(10, 20, [&range](int x) { range.push_back(x); });
+        EXPECT_EQ(std::vector<int>({ 12, 15, 18 }), range);
+
+        // перемещение передает отображение
+        MappedInt moved(std::move(set));
+        EXPECT_TRUE(set.isEmpty());
+        EXPECT_TRUE(moved.contains(999));
+    }
+
+    std::remove(path.c_str());
+}
+
+
+// размеры, не являющиеся 2^k - 1, и пустое множество; перезапись существующего файла
+TEST(MappedRBSetTest, sizes1)
+{
+    std::string path = tempPath("sizes1");
+
+    for (std::uint64_t n = 0; n < 40; ++n)
+    {
+        std::vector<std::uint64_t> keys;
+        for (std::uint64_t i = 0; i < n; ++i)
+            keys.push_back(i * 2);
+        MappedRBSet<std::uint64_t>::write(path, keys.begin(), keys.size());
+
+        MappedRBSet<std::uint64_t> set(path);
+        EXPECT_EQ(n, set.getSize());
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+            EXPECT_TRUE(set.contains(i * 2));
+            EXPECT_FALSE(set.contains(i * 2 + 1));
+        }
+
+        std::size_t seen = 0;
+        set.forEach([&seen](std::uint64_t) { ++seen; });
+        EXPECT_EQ(n, seen);
+    }
+
+    std::remove(path.c_str());
+}
+
+
+// файлы не того формата отвергаются
+TEST(MappedRBSetTest, badFile1)
+{
+    std::string path = tempPath("bad1");
+
+    EXPECT_THROW(MappedInt("/nonexistent/dir/file.bin"), std::runtime_error);
+
+    std::vector<int> keys = { 1, 2, 3, 4, 5 };
+    MappedInt::write(path, keys.begin(), keys.size());
+
+    // не тот размер элемента
+    EXPECT_THROW(MappedRBSet<std::uint64_t> wrong(path), std::runtime_error);
+
+    // обрезан
+    std::string data;
+    {
+        std::ifstream in(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size() - 1);
+    }
+    EXPECT_THROW(MappedInt trunc(path), std::runtime_error);
+
+    // не та сигнатура
+    data[0] = 'X';
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+    }
+    EXPECT_THROW(MappedInt sig(path), std::runtime_error);
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,153 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::PersistentRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "persistent_rbtree.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef PersistentRBTree<int> PersistentInt;
+
+
+static void checkSnapshot(const PersistentInt::Snapshot &snap, const std::set<int> &model)
+{
+    if (snap.getRoot())
+    {
+        EXPECT_EQ(PersistentInt::BLACK, snap.getRoot()->getColor());
+    }
+    checkRB(snap.getRoot().get(), false);
+
+    std::vector<int> all;
+    snap.forEach([&all](int k) { all.push_back(k); });
+    EXPECT_EQ(std::vector<int>(model.begin(), model.end()), all);
+    EXPECT_EQ(model.size(), snap.getSize());
+}
+
+
+TEST(PersistentRBTreeTest, insertRemove1)
+{
+    PersistentInt tree;
+    std::set<int> model;
+
+    std::srand(32);
+    for (int i = 0; i < 3000; ++i)
+    {
+        int k = std::rand() % 500;
+        if (std::rand() % 3)
+            EXPECT_EQ(model.insert(k).second, tree.insert(k));
+        else
+            EXPECT_EQ(model.erase(k) == 1, tree.remove(k));
+
+        if (i % 100 == 0)
+            checkSnapshot(tree.snapshot(), model);
+    }
+    checkSnapshot(tree.snapshot(), model);
+
+    for (int k = 0; k < 500; ++k)
+        EXPECT_EQ(model.count(k) == 1, tree.contains(k));
+}
+
+
+// старые версии не меняются, а неизмененные поддеревья разделяются
+TEST(PersistentRBTreeTest, snapshots1)
+{
+    PersistentInt tree;
+    std::set<int> model;
+    for (int i = 0; i < 256; ++i)
+    {
+        tree.insert(i * 2);
+        model.insert(i * 2);
+    }
+
+    PersistentInt::Snapshot before = tree.snapshot();
+    std::set<int> modelBefore = model;
+
+    tree.insert(1001);
+    tree.remove(0);
+    model.insert(1001);
+    model.erase(0);
+
+    PersistentInt::Snapshot after = tree.snapshot();
+    checkSnapshot(before, modelBefore);
+    checkSnapshot(after, model);
+
+    // вставка справа и удаление слева не трогают середину дерева
+    const PersistentInt::Node *mid = before.find(256);
+    ASSERT_NE(nullptr, mid);
+    EXPECT_EQ(mid, after.find(256));
+}
+
+
+TEST(PersistentRBTreeTest, assignSorted1)
+{
+    for (int n = 0; n < 70; ++n)
+    {
+        std::vector<int> keys;
+        for (int i = 0; i < n; ++i)
+            keys.push_back(i * 3);
+
+        PersistentInt tree;
+        tree.assignSorted(keys.begin(), keys.size());
+        checkSnapshot(tree.snapshot(), std::set<int>(keys.begin(), keys.end()));
+
+        // построенное дерево остается корректным и после изменений
+        tree.insert(1);
+        tree.remove(0);
+        std::set<int> model(keys.begin(), keys.end());
+        model.insert(1);
+        model.erase(0);
+        checkSnapshot(tree.snapshot(), model);
+    }
+}
+
+
+// читатели видят только целые версии: каждая версия содержит префикс вставок
+TEST(PersistentRBTreeTest, concurrentReaders1)
+{
+    const int KEYS = 20000;
+    PersistentInt tree;
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r)
+        readers.emplace_back([&tree, &done]()
+        {
+            while (!done.load())
+            {
+                PersistentInt::Snapshot snap = tree.snapshot();
+                int expected = 0;
+                bool ok = true;
+                snap.forEach([&expected, &ok](int k) { ok = ok && k == expected++; });
+                EXPECT_TRUE(ok);
+                EXPECT_EQ(snap.getSize(), static_cast<std::size_t>(expected));
+            }
+        });
+
+    for (int i = 0; i < KEYS; ++i)
+        tree.insert(i);
+    done.store(true);
+
+    for (std::thread &t : readers)
+        t.join();
+
+    EXPECT_EQ(static_cast<std::size_t>(KEYS), tree.snapshot().getSize());
+}
@@ -0,0 +1,114 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTree diff and delta application
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rbtree.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef RBTreeDelta<int> DeltaInt;
+
+
+// разница переводит одно дерево в другое, в том числе через сериализацию
+TEST(RBTreeDeltaTest, diffApply1)
+{
+    RBTreeInt primary;
+    RBTreeInt replica;
+    for (int i = 0; i < 2000; ++i)
+    {
+        if (i % 3 != 0)
+            primary.insert(i);
+        if (i % 5 != 0)
+            replica.insert(i);
+    }
+
+    DeltaInt delta;
+    replica.diff(primary, delta);
+    for (int x : delta.removes)
+        EXPECT_TRUE(x % 3 == 0 && x % 5 != 0);
+    for (int x : delta.inserts)
+        EXPECT_TRUE(x % 5 == 0 && x % 3 != 0);
+
+    std::stringstream wire;
+    delta.serialize(wire);
+    DeltaInt received;
+    received.deserialize(wire);
+    EXPECT_EQ(delta.removes, received.removes);
+    EXPECT_EQ(delta.inserts, received.inserts);
+
+    replica.applyDelta(received);
+    EXPECT_EQ(std::vector<int>(primary.begin(), primary.end()), std::vector<int>(replica.begin(), replica.end()));
+    checkRB(replica.getRoot());
+
+    // повторное применение ничего не меняет; разница совпадающих деревьев пуста
+    replica.applyDelta(received);
+    replica.diff(primary, delta);
+    EXPECT_TRUE(delta.isEmpty());
+    EXPECT_EQ(std::vector<int>(primary.begin(), primary.end()), std::vector<int>(replica.begin(), replica.end()));
+}
+
+
+// объем передачи зависит от числа изменений, а не от размера дерева
+TEST(RBTreeDeltaTest, compact1)
+{
+    RBTreeInt primary;
+    RBTreeInt replica;
+    for (int i = 0; i < 10000; ++i)
+    {
+        primary.insert(i);
+        replica.insert(i);
+    }
+    primary.remove(17);
+    primary.insert(20000);
+    primary.insert(-5);
+
+    DeltaInt delta;
+    replica.diff(primary, delta);
+    EXPECT_EQ(std::vector<int>({ 17 }), delta.removes);
+    EXPECT_EQ(std::vector<int>({ -5, 20000 }), delta.inserts);
+
+    std::ostringstream wire;
+    delta.serialize(wire);
+    EXPECT_LT(wire.str().size(), 100u);
+
+    // пустые деревья с обеих сторон
+    RBTreeInt empty;
+    empty.diff(replica, delta);
+    EXPECT_EQ(10000u, delta.inserts.size());
+    replica.diff(empty, delta);
+    EXPECT_EQ(10000u, delta.removes.size());
+    empty.applyDelta(delta);
+    EXPECT_TRUE(empty.isEmpty());
+}
+
+
+// неупорядоченный список в потоке отвергается
+TEST(RBTreeDeltaTest, corrupted1)
+{
+    DeltaInt delta;
+    delta.inserts = { 3, 1 };
+    std::stringstream wire;
+    delta.serialize(wire);
+
+    DeltaInt received;
+    EXPECT_THROW(received.deserialize(wire), std::runtime_error);
+}
@@ -0,0 +1,85 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTree finger search
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "rbtree.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+
+
+// от любого пальца к любому ключу — тот же ответ, что и от корня
+TEST(RBTreeFingerTest, random1)
+{
+    RBTreeInt tree;
+    std::vector<int> keys;
+    for (int i = 0; i < 3000; ++i)
+    {
+        tree.insert(i * 2);
+        keys.push_back(i * 2);
+    }
+    // удаления оставляют дерево неидеальной формы
+    for (int i = 0; i < 6000; i += 6)
+        tree.remove(i);
+
+    std::mt19937 rng(5);
+    for (int i = 0; i < 20000; ++i)
+    {
+        RBTreeInt::ConstIterator finger = tree.lowerBound(static_cast<int>(rng() % 6100));
+        int key = static_cast<int>(rng() % 6100) - 50;
+
+        EXPECT_TRUE(tree.lowerBound(key) == tree.lowerBound(finger, key));
+
+        RBTreeInt::ConstIterator found = tree.find(finger, key);
+        const RBTreeInt::Node *nd = tree.find(key);
+        EXPECT_EQ(nd, found.getNode());
+    }
+}
+
+
+// курсор по возрастанию, как в слиянии, и обратно
+TEST(RBTreeFingerTest, cursor1)
+{
+    RBTreeInt tree;
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i * 3);
+
+    RBTreeInt::ConstIterator finger = tree.begin();
+    for (int key = 0; key <= 2997; ++key)
+    {
+        finger = tree.lowerBound(finger, key);
+        ASSERT_TRUE(finger != tree.end());
+        EXPECT_EQ((key + 2) / 3 * 3, *finger);
+    }
+    EXPECT_TRUE(tree.lowerBound(finger, 2998) == tree.end());
+
+    for (int key = 2997; key >= 0; key -= 3)
+    {
+        finger = tree.find(finger, key);
+        ASSERT_TRUE(finger != tree.end());
+        EXPECT_EQ(key, *finger);
+    }
+    EXPECT_TRUE(tree.find(finger, 1) == tree.end());
+
+    // палец end() — поиск от корня
+    EXPECT_EQ(300, *tree.find(tree.end(), 300));
+
+    RBTreeInt empty;
+    EXPECT_TRUE(empty.lowerBound(empty.end(), 5) == empty.end());
+}
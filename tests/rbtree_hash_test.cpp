@@ -0,0 +1,218 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTree subtree hashes
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "rbtree.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef RBTreeDelta<int> DeltaInt;
+
+
+static void checkTree(const RBTreeInt &tree)
+{
+    std::uint64_t sum = checkHashes(tree.getRoot());
+    EXPECT_EQ(sum, tree.contentHash());
+}
+
+
+// вставки и удаления с вращениями в обе стороны
+TEST(RBTreeHashTest, insertRemove1)
+{
+    RBTreeInt tree;
+    EXPECT_EQ(0u, tree.contentHash());
+
+    std::mt19937 rng(7);
+    std::set<int> model;
+    for (int i = 0; i < 3000; ++i)
+    {
+        int key = static_cast<int>(rng() % 500);
+        if (model.count(key))
+        {
+            tree.remove(key);
+            model.erase(key);
+        }
+        else
+        {
+            tree.insert(key);
+            model.insert(key);
+        }
+
+        if (i % 100 == 0)
+            checkTree(tree);
+    }
+    checkTree(tree);
+
+    for (std::set<int>::const_iterator it = model.begin(); it != model.end(); ++it)
+        tree.remove(*it);
+    EXPECT_EQ(0u, tree.contentHash());
+}
+
+
+// операции над множествами, разрезание, склейка, уплотнение
+TEST(RBTreeHashTest, bulkOps1)
+{
+    RBTreeInt a;
+    RBTreeInt b;
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (i % 2 == 0)
+            a.insert(i);
+        if (i % 3 == 0)
+            b.insert(i);
+    }
+
+    RBTreeInt c;
+    std::vector<int> keys;
+    for (int i = 0; i < 1000; i += 5)
+        keys.push_back(i);
+    c.assignSorted(keys.begin(), keys.size());
+    checkTree(c);
+
+    a.unionWith(b);
+    checkTree(a);
+    a.difference(c);
+    checkTree(a);
+
+    RBTreeInt d;
+    for (int i = 0; i < 1000; i += 7)
+        d.insert(i);
+    a.intersect(d);
+    checkTree(a);
+
+    RBTreeInt left;
+    RBTreeInt right;
+    c.split(500, left, right);
+    checkTree(left);
+    checkTree(right);
+
+    c.join(left, right);
+    checkTree(c);
+    c.compact();
+    checkTree(c);
+
+    RBTreeInt e;
+    e.insert(2000);
+    e.insert(2001);
+    RBTreeInt f;
+    f.join(c, 1500, e);
+    checkTree(f);
+}
+
+
+// хеш зависит только от множества элементов
+TEST(RBTreeHashTest, shapeIndependent1)
+{
+    std::vector<int> keys;
+    for (int i = 0; i < 500; ++i)
+        keys.push_back(i * 3);
+
+    RBTreeInt ascending;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        ascending.insert(keys[i]);
+
+    RBTreeInt shuffled;
+    std::vector<int> order(keys);
+    std::shuffle(order.begin(), order.end(), std::mt19937(3));
+    for (std::size_t i = 0; i < order.size(); ++i)
+        shuffled.insert(order[i]);
+
+    RBTreeInt built;
+    built.assignSorted(keys.begin(), keys.size());
+
+    EXPECT_EQ(ascending.contentHash(), shuffled.contentHash());
+    EXPECT_EQ(ascending.contentHash(), built.contentHash());
+    EXPECT_TRUE(ascending.isEqual(shuffled));
+    EXPECT_TRUE(ascending.isEqual(built));
+
+    shuffled.remove(300);
+    EXPECT_NE(ascending.contentHash(), shuffled.contentHash());
+    EXPECT_FALSE(ascending.isEqual(shuffled));
+
+    shuffled.insert(301);
+    EXPECT_NE(ascending.contentHash(), shuffled.contentHash());
+    EXPECT_FALSE(ascending.isEqual(shuffled));
+
+    shuffled.remove(301);
+    shuffled.insert(300);
+    EXPECT_TRUE(ascending.isEqual(shuffled));
+}
+
+
+// разница с отсечением совпадающих поддеревьев совпадает с прямым сравнением
+TEST(RBTreeHashTest, diffPruned1)
+{
+    RBTreeInt primary;
+    RBTreeInt replica;
+    std::set<int> p;
+    std::set<int> r;
+    for (int i = 0; i < 20000; ++i)
+    {
+        primary.insert(i);
+        replica.insert(i);
+        p.insert(i);
+        r.insert(i);
+    }
+
+    DeltaInt delta;
+    primary.diff(replica, delta);
+    EXPECT_TRUE(delta.isEmpty());
+
+    // несколько точечных изменений и хвост, которого у реплики нет
+    int changed[] = { 0, 17, 9999, 10000, 19999 };
+    for (int key : changed)
+    {
+        replica.remove(key);
+        r.erase(key);
+    }
+    for (int key = 20000; key < 20010; ++key)
+    {
+        replica.insert(key);
+        r.insert(key);
+    }
+    replica.insert(-5);
+    r.insert(-5);
+
+    primary.diff(replica, delta);
+
+    std::vector<int> removes;
+    std::vector<int> inserts;
+    std::set_difference(p.begin(), p.end(), r.begin(), r.end(), std::back_inserter(removes));
+    std::set_difference(r.begin(), r.end(), p.begin(), p.end(), std::back_inserter(inserts));
+    EXPECT_EQ(removes, delta.removes);
+    EXPECT_EQ(inserts, delta.inserts);
+
+    primary.applyDelta(delta);
+    checkTree(primary);
+    EXPECT_TRUE(primary.isEqual(replica));
+
+    // пустые деревья с обеих сторон
+    RBTreeInt empty;
+    empty.diff(replica, delta);
+    EXPECT_EQ(r.size(), delta.inserts.size());
+    EXPECT_TRUE(delta.removes.empty());
+    replica.diff(empty, delta);
+    EXPECT_EQ(r.size(), delta.removes.size());
+    EXPECT_TRUE(delta.inserts.empty());
+}
@@ -0,0 +1,137 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTree hot key cache
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rbtree.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+
+
+TEST(RBTreeHotCacheTest, simple1)
+{
+    RBTreeInt tree;
+    EXPECT_EQ(0u, tree.getHotCacheSize());
+    tree.setHotCacheSize(100);
+    EXPECT_EQ(128u, tree.getHotCacheSize());
+
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i);
+
+    // повторный поиск — из кэша, тот же узел
+    for (int round = 0; round < 2; ++round)
+        for (int i = 0; i < 1000; ++i)
+        {
+            const RBTreeInt::Node *nd = tree.find(i);
+            ASSERT_NE(nullptr, nd);
+            EXPECT_EQ(i, nd->getKey());
+        }
+    EXPECT_EQ(nullptr, tree.find(5000));
+
+    // удаленный узел из кэша выбрасывается
+    tree.find(10);
+    tree.remove(10);
+    EXPECT_EQ(nullptr, tree.find(10));
+    tree.insert(10);
+    ASSERT_NE(nullptr, tree.find(10));
+
+    tree.setHotCacheSize(0);
+    EXPECT_EQ(0u, tree.getHotCacheSize());
+    EXPECT_EQ(11, tree.find(11)->getKey());
+}
+
+
+// узлы, переезжающие или уходящие из дерева, в кэше не остаются
+TEST(RBTreeHotCacheTest, bulkOps1)
+{
+    RBTreeInt tree;
+    tree.setHotCacheSize(64);
+    for (int i = 0; i < 500; ++i)
+        tree.insert(i);
+    for (int i = 0; i < 500; ++i)
+        tree.find(i);
+
+    tree.compact();
+    for (int i = 0; i < 500; ++i)
+        ASSERT_EQ(i, tree.find(i)->getKey());
+
+    RBTreeInt odd;
+    for (int i = 1; i < 500; i += 2)
+        odd.insert(i);
+    tree.difference(odd);
+    for (int i = 0; i < 500; ++i)
+        EXPECT_EQ(i % 2 == 0, tree.find(i) != nullptr);
+
+    RBTreeInt left;
+    RBTreeInt right;
+    tree.split(250, left, right);
+    EXPECT_EQ(nullptr, tree.find(100));
+    EXPECT_EQ(nullptr, tree.find(300));
+    EXPECT_NE(nullptr, left.find(100));
+}
+
+
+// читатели ищут горячие ключи через кэш, пока писатель их удаляет и вставляет заново:
+// устаревший указатель в кэше после освобождения узла поймал бы ASan
+TEST(RBTreeHotCacheTest, concurrentReaders1)
+{
+    EpochManager epochs;
+    RBTreeInt tree;
+    tree.setReclaimer(&epochs);
+    tree.setHotCacheSize(16);
+    for (int i = 0; i < 2000; ++i)
+        tree.insert(i);
+
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+        readers.push_back(std::thread([&, t]() {
+            while (!stop.load())
+            {
+                for (int i = 0; i < 64; ++i)
+                {
+                    EpochManager::ReaderGuard guard(epochs);
+                    const RBTreeInt::Node *nd = tree.find((i * 7 + t) % 64);
+                    if (nd)
+                    {
+                        EXPECT_EQ((i * 7 + t) % 64, nd->getKey());
+                    }
+                }
+            }
+        }));
+
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int i = round % 2; i < 64; i += 2)
+            tree.remove(i);
+        for (int i = round % 2; i < 64; i += 2)
+            tree.insert(i);
+    }
+    for (int i = 1999; i >= 1000; --i)
+        tree.remove(i);
+
+    stop.store(true);
+    for (std::size_t t = 0; t < readers.size(); ++t)
+        readers[t].join();
+
+    for (int i = 0; i < 64; ++i)
+        EXPECT_NE(nullptr, tree.find(i));
+    EXPECT_EQ(nullptr, tree.find(1500));
+}
@@ -21,3 +21,189 @@
 /// https://github.com/google/googletest/blob/master/googletest/docs/AdvancedGuide.md#testing-private-code
 ///
 ////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <vector>
+
+#include "rbtree.h"
+
+
+namespace xi
+{
+
+/** \brief Доступ тестов к закрытой реализации \c RBTree. */
+template<typename Element, typename Compar>
+class RBTreeTest
+{
+public:
+    typedef RBTree<Element, Compar> Tree;
+
+    /** \brief Возвращает число блоков узлов, которые держит дерево (пустые выбрасываются). */
+    static std::size_t getArenasNum(Tree &tree)
+    {
+        tree.pruneArenas();
+        return tree._arenas.size();
+    }
+
+    /** \brief Возвращает истину, если узел с ключом \c key лежит в блоке дерева. */
+    static bool isInArena(const Tree &tree, const Element &key) { return tree.findArena(tree.find(key)) != nullptr; }
+}; // class RBTreeTest
+
+} // namespace xi
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef RBTreeTest<int, std::less<int> > RBTreeIntTest;
+
+
+// узлы пачек выделяются по одному: блоков не появляется
+TEST(RBTreePrvTest, insertBatchArenas1)
+{
+    RBTreeInt tree;
+    for (int round = 0; round < 50; ++round)
+    {
+        std::vector<int> batch;
+        for (int i = 0; i < 200; ++i)
+            batch.push_back((round * 137 + i * 31) % 3000);
+        tree.insertBatch(batch.begin(), batch.end());
+    }
+    EXPECT_EQ(0u, RBTreeIntTest::getArenasNum(tree));
+
+    for (int i = 0; i < 3000; i += 2)
+        if (tree.find(i))
+            tree.remove(i);
+    EXPECT_EQ(0u, RBTreeIntTest::getArenasNum(tree));
+}
+
+
+// блоки разных деревьев после слияний ищутся двоичным поиском
+TEST(RBTreePrvTest, findArena1)
+{
+    RBTreeInt trees[4];
+    for (int t = 0; t < 4; ++t)
+    {
+        for (int i = t; i < 400; i += 4)
+            trees[t].insert(i);
+        trees[t].compact();
+    }
+    trees[0].insert(1000);
+
+    for (int t = 1; t < 4; ++t)
+        trees[0].unionWith(trees[t]);
+    EXPECT_EQ(4u, RBTreeIntTest::getArenasNum(trees[0]));
+
+    for (int i = 0; i < 400; ++i)
+        EXPECT_TRUE(RBTreeIntTest::isInArena(trees[0], i));
+    EXPECT_FALSE(RBTreeIntTest::isInArena(trees[0], 1000));
+
+    // узлы из блоков разрушаются на месте, отдельные — удаляются (проверяет ASan)
+    for (int i = 0; i < 400; i += 3)
+        trees[0].remove(i);
+    trees[0].remove(1000);
+}
+
+
+// блоки аргумента, чьи узлы все выброшены операцией, освобождаются и не задерживаются в дереве
+TEST(RBTreePrvTest, setOpArenas1)
+{
+    RBTreeInt tree;
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i);
+    tree.compact();
+
+    RBTreeInt evens;
+    for (int i = 0; i < 1000; i += 2)
+        evens.insert(i);
+    evens.compact();
+    tree.difference(evens);
+    EXPECT_EQ(1u, RBTreeIntTest::getArenasNum(tree));
+
+    RBTreeInt some;
+    for (int i = 1; i < 1000; i += 6)
+        some.insert(i);
+    some.compact();
+    tree.intersect(some);
+    EXPECT_EQ(1u, RBTreeIntTest::getArenasNum(tree));
+
+    // последний узел собственного блока уносит и его
+    for (int i = 1; i < 1000; i += 6)
+        tree.remove(i);
+    EXPECT_EQ(0u, RBTreeIntTest::getArenasNum(tree));
+}
+
+
+// при разрезании блок достается обеим частям и освобождается, когда уйдут узлы из обеих;
+// с менеджером эпох — после отложенного разрушения последнего узла
+TEST(RBTreePrvTest, splitArenas1)
+{
+    EpochManager epochs;
+    RBTreeInt tree;
+    tree.setReclaimer(&epochs);
+    for (int i = 0; i < 500; ++i)
+        tree.insert(i);
+    tree.compact();
+
+    RBTreeInt left;
+    RBTreeInt right;
+    left.setReclaimer(&epochs);
+    tree.split(250, left, right);
+    EXPECT_EQ(1u, RBTreeIntTest::getArenasNum(left));
+    EXPECT_EQ(1u, RBTreeIntTest::getArenasNum(right));
+
+    for (int i = 0; i < 250; ++i)
+        left.remove(i);
+    epochs.synchronize();
+    EXPECT_EQ(1u, RBTreeIntTest::getArenasNum(right));
+
+    for (int i = 250; i < 500; ++i)
+        right.remove(i);
+    EXPECT_EQ(0u, RBTreeIntTest::getArenasNum(left));
+    EXPECT_EQ(0u, RBTreeIntTest::getArenasNum(right));
+
+    // адрес освобожденного блока может достаться новым узлам: они не должны приниматься за блочные
+    for (int i = 0; i < 100; ++i)
+        left.insert(i);
+    for (int i = 0; i < 100; ++i)
+        EXPECT_FALSE(RBTreeIntTest::isInArena(left, i));
+}
+
+
+// реплика, применяющая разницы цикл за циклом, не копит блоков; удаления идут без узлов
+TEST(RBTreePrvTest, applyDeltaArenas1)
+{
+    TaskPool pool(2);
+    RBTreeInt replica;
+    std::set<int> model;
+    for (int i = 0; i < 100000; ++i)
+    {
+        replica.insert(i);
+        model.insert(i);
+    }
+    replica.compact();
+
+    for (int round = 0; round < 20; ++round)
+    {
+        RBTreeDelta<int> delta;
+        for (int i = round; i < 100000; i += 7 + round)
+            if (model.count(i))
+            {
+                delta.removes.push_back(i);
+                model.erase(i);
+            }
+        for (int i = 100000 + round * 1000; i < 100000 + round * 1000 + 500; ++i)
+        {
+            delta.inserts.push_back(i);
+            model.insert(i);
+        }
+
+        replica.applyDelta(delta, round % 2 ? &pool : nullptr);
+        EXPECT_LE(RBTreeIntTest::getArenasNum(replica), 1u);
+    }
+
+    EXPECT_EQ(std::vector<int>(model.begin(), model.end()), std::vector<int>(replica.begin(), replica.end()));
+}
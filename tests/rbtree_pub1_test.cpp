@@ -19,8 +19,16 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "rbtree.h"
 #include "def_dumper.h"
+#include "test_utils.h"
 
 
 
@@ -133,6 +141,475 @@ TEST_F(RBTreePubTest, find2)
 }
 
 
+// обход в порядке возрастания
+TEST_F(RBTreePubTest, iterate1)
+{
+    RBTreeInt tree;
+    EXPECT_TRUE(tree.begin() == tree.end());
+
+    for (int i = 0; i < STRUCT2_SEQ_NUM; ++i)
+        tree.insert(STRUCT2_SEQ[i]);
+
+    int prev = -1;
+    int num = 0;
+    for (RBTreeInt::const_iterator it = tree.begin(); it != tree.end(); ++it, ++num)
+    {
+        EXPECT_LT(prev, *it);
+        prev = *it;
+    }
+    EXPECT_EQ(STRUCT2_SEQ_NUM, num);
+}
+
+
+// уплотнение узлов в порядке ван Эмде Боаса
+TEST_F(RBTreePubTest, compact1)
+{
+    RBTreeInt tree;
+    tree.compact();                                     // пустое дерево
+    EXPECT_TRUE(tree.isEmpty());
+
+    const int NUM = 1000;
+    for (int i = 0; i < NUM; ++i)
+        tree.insert((i * 7919) % NUM);
+
+    tree.compact();
+
+    // корень — первый в блоке, все узлы — в пределах блока, связи согласованы
+    const RBTreeInt::Node* root = tree.getRoot();
+    EXPECT_EQ(nullptr, root->getParent());
+    int num = 0;
+    for (RBTreeInt::const_iterator it = tree.begin(); it != tree.end(); ++it, ++num)
+    {
+        const RBTreeInt::Node* nd = it.getNode();
+        EXPECT_EQ(num, nd->getKey());
+        EXPECT_TRUE(nd >= root && nd < root + NUM);
+        if (nd->getLeft())
+        {
+            EXPECT_EQ(nd, nd->getLeft()->getParent());
+        }
+        if (nd->getRight())
+        {
+            EXPECT_EQ(nd, nd->getRight()->getParent());
+        }
+    }
+    EXPECT_EQ(NUM, num);
+
+    // после уплотнения дерево остается обычным: вставки и повторное уплотнение
+    for (int i = NUM; i < 2 * NUM; ++i)
+        tree.insert(i);
+    tree.compact();
+    for (int i = 0; i < 2 * NUM; ++i)
+        EXPECT_NE(nullptr, tree.find(i));
+    EXPECT_EQ(nullptr, tree.find(2 * NUM));
+}
+
+
+// пакетный поиск
+TEST_F(RBTreePubTest, findBatch1)
+{
+    RBTreeInt tree;
+
+    for (int i = 0; i < STRUCT2_SEQ_NUM; ++i)
+        tree.insert(STRUCT2_SEQ[i]);
+
+    // больше одной группы, вперемешку присутствующие и отсутствующие ключи
+    const int KEYS_NUM = 40;
+    int keys[KEYS_NUM];
+    const RBTreeInt::Node* out[KEYS_NUM];
+    for (int i = 0; i < KEYS_NUM; ++i)
+        keys[i] = (i % 2) ? STRUCT2_SEQ[i % STRUCT2_SEQ_NUM] : 1000 + i;
+
+    tree.findBatch(keys, KEYS_NUM, out);
+    for (int i = 0; i < KEYS_NUM; ++i)
+        EXPECT_EQ(tree.find(keys[i]), out[i]);
+
+    // пустое дерево
+    RBTreeInt empty;
+    empty.findBatch(keys, KEYS_NUM, out);
+    for (int i = 0; i < KEYS_NUM; ++i)
+        EXPECT_EQ(nullptr, out[i]);
+}
+
+// проверяет свойства дерева и что в нем ровно ключи [from, to)
+static void checkRange(const RBTreeInt& tree, int from, int to)
+{
+    if (tree.getRoot())
+    {
+        EXPECT_TRUE(tree.getRoot()->isBlack());
+        EXPECT_EQ(nullptr, tree.getRoot()->getParent());
+    }
+    checkRB(tree.getRoot());
+
+    int expected = from;
+    for (RBTreeInt::const_iterator it = tree.begin(); it != tree.end(); ++it)
+        EXPECT_EQ(expected++, *it);
+    EXPECT_EQ(to, expected);
+}
+
+
+// разрезание по каждому ключу и вне диапазона
+TEST_F(RBTreePubTest, split1)
+{
+    const int NUM = 300;
+    for (int key = -1; key <= NUM + 1; key += 7)
+    {
+        RBTreeInt tree;
+        for (int i = 0; i < NUM; ++i)
+            tree.insert((i * 7919) % NUM);
+
+        RBTreeInt left, right;
+        tree.split(key, left, right);
+
+        EXPECT_TRUE(tree.isEmpty());
+        int mid = key < 0 ? 0 : (key > NUM ? NUM : key);
+        checkRange(left, 0, mid);
+        checkRange(right, mid, NUM);
+    }
+
+    // результат можно оставить в самом дереве
+    RBTreeInt tree, right;
+    for (int i = 0; i < 100; ++i)
+        tree.insert(i);
+    tree.split(40, tree, right);
+    checkRange(tree, 0, 40);
+    checkRange(right, 40, 100);
+
+    EXPECT_THROW(tree.split(10, right, right), std::invalid_argument);
+}
+
+
+// склейка деревьев разной высоты через разделитель и без него
+TEST_F(RBTreePubTest, join1)
+{
+    const int SIZES[] = { 0, 1, 2, 5, 17, 100, 1000 };
+    const int SIZES_NUM = sizeof(SIZES) / sizeof(SIZES[0]);
+
+    for (int a = 0; a < SIZES_NUM; ++a)
+        for (int b = 0; b < SIZES_NUM; ++b)
+        {
+            int ln = SIZES[a];
+            int rn = SIZES[b];
+
+            RBTreeInt left, right, joined;
+            for (int i = 0; i < ln; ++i)
+                left.insert(i);
+            for (int i = 0; i < rn; ++i)
+                right.insert(ln + 1 + i);
+
+            joined.join(left, ln, right);
+            EXPECT_TRUE(left.isEmpty());
+            EXPECT_TRUE(right.isEmpty());
+            checkRange(joined, 0, ln + rn + 1);
+
+            // без разделителя: в одно из исходных деревьев
+            RBTreeInt tail;
+            for (int i = 0; i < rn; ++i)
+                tail.insert(ln + rn + 1 + i);
+            joined.join(joined, tail);
+            checkRange(joined, 0, ln + 2 * rn + 1);
+        }
+
+    // порядок нарушен
+    RBTreeInt left, right, joined;
+    left.insert(5);
+    right.insert(3);
+    EXPECT_THROW(joined.join(left, 4, right), std::invalid_argument);
+    EXPECT_THROW(joined.join(left, right), std::invalid_argument);
+    EXPECT_FALSE(left.isEmpty());
+}
+
+
+// узлы блока compact() переживают разрезание и склейку
+TEST_F(RBTreePubTest, splitCompact1)
+{
+    RBTreeInt tree;
+    for (int i = 0; i < 500; ++i)
+        tree.insert(i);
+    tree.compact();
+
+    RBTreeInt left, right;
+    tree.split(250, left, right);
+    {
+        RBTreeInt l2, r2;
+        right.split(400, l2, r2);
+        right.join(l2, r2);
+    }
+    for (int i = 250; i < 300; ++i)
+        right.remove(i);
+    tree.join(left, right);
+
+    int expected = 0;
+    for (RBTreeInt::const_iterator it = tree.begin(); it != tree.end(); ++it)
+    {
+        EXPECT_EQ(expected, *it);
+        expected = (expected == 249) ? 300 : expected + 1;
+    }
+    EXPECT_EQ(500, expected);
+    checkRB(tree.getRoot());
+}
+
+// заполняет дерево и множество-образец ключами i * step % mod для i из [0, num)
+static void fillSet(RBTreeInt& tree, std::set<int>& ref, int num, int step, int mod)
+{
+    for (int i = 0; i < num; ++i)
+    {
+        int k = static_cast<int>((static_cast<long long>(i) * step) % mod);
+        if (ref.insert(k).second)
+            tree.insert(k);
+    }
+}
+
+
+// проверяет свойства дерева и что в нем ровно ключи ref
+static void checkSet(const RBTreeInt& tree, const std::set<int>& ref)
+{
+    if (tree.getRoot())
+    {
+        EXPECT_TRUE(tree.getRoot()->isBlack());
+        EXPECT_EQ(nullptr, tree.getRoot()->getParent());
+    }
+    checkRB(tree.getRoot());
+
+    std::vector<int> keys(tree.begin(), tree.end());
+    EXPECT_EQ(std::vector<int>(ref.begin(), ref.end()), keys);
+}
+
+
+// объединение, пересечение и разность сверяются с std::set; с пулом и без
+TEST_F(RBTreePubTest, setOps1)
+{
+    const int SIZES[] = { 0, 1, 7, 300, 20000 };
+    const int SIZES_NUM = sizeof(SIZES) / sizeof(SIZES[0]);
+    TaskPool pool(3);
+
+    for (int withPool = 0; withPool < 2; ++withPool)
+        for (int a = 0; a < SIZES_NUM; ++a)
+            for (int b = 0; b < SIZES_NUM; ++b)
+                for (int op = 0; op < 3; ++op)
+                {
+                    RBTreeInt t1, t2;
+                    std::set<int> s1, s2;
+                    fillSet(t1, s1, SIZES[a], 7919, 3 * SIZES[a] + 1);
+                    fillSet(t2, s2, SIZES[b], 104729, 2 * SIZES[b] + 1);
+                    if (a == SIZES_NUM - 1 && b == SIZES_NUM - 1)
+                        t1.compact();
+
+                    std::set<int> expected;
+                    TaskPool* p = withPool ? &pool : nullptr;
+                    if (op == 0)
+                    {
+                        t1.unionWith(t2, p);
+                        std::set_union(s1.begin(), s1.end(), s2.begin(), s2.end(),
+                                       std::inserter(expected, expected.end()));
+                    }
+                    else if (op == 1)
+                    {
+                        t1.intersect(t2, p);
+                        std::set_intersection(s1.begin(), s1.end(), s2.begin(), s2.end(),
+                                              std::inserter(expected, expected.end()));
+                    }
+                    else
+                    {
+                        t1.difference(t2, p);
+                        std::set_difference(s1.begin(), s1.end(), s2.begin(), s2.end(),
+                                            std::inserter(expected, expected.end()));
+                    }
+
+                    EXPECT_TRUE(t2.isEmpty());
+                    checkSet(t1, expected);
+
+                    // дерево после операции остается рабочим
+                    t1.insert(-1);
+                    EXPECT_NE(nullptr, t1.find(-1));
+                }
+
+    RBTreeInt tree;
+    EXPECT_THROW(tree.unionWith(tree), std::invalid_argument);
+}
+
+
+// пачка с повторами вливается в непустое дерево; с пулом и без
+TEST_F(RBTreePubTest, insertBatch1)
+{
+    TaskPool pool(3);
+
+    for (int withPool = 0; withPool < 2; ++withPool)
+    {
+        RBTreeInt tree;
+        std::set<int> ref;
+        for (int i = 0; i < 1000; i += 3)
+        {
+            tree.insert(i);
+            ref.insert(i);
+        }
+
+        std::vector<int> batch;
+        for (int i = 0; i < 100000; ++i)
+            batch.push_back(static_cast<int>((i * 7919LL) % 50000));
+        ref.insert(batch.begin(), batch.end());
+
+        tree.insertBatch(batch.begin(), batch.end(), withPool ? &pool : nullptr);
+        checkSet(tree, ref);
+
+        // пустая пачка и пачка из одного элемента
+        tree.insertBatch(batch.begin(), batch.begin());
+        tree.insertBatch(batch.begin(), batch.begin() + 1);
+        checkSet(tree, ref);
+    }
+
+    // пачки всех малых размеров в пустое дерево
+    for (int n = 1; n < 70; ++n)
+    {
+        std::vector<int> batch;
+        for (int i = n; i-- > 0; )
+            batch.push_back(i);
+
+        RBTreeInt tree;
+        tree.insertBatch(batch.begin(), batch.end());
+        checkRange(tree, 0, n);
+    }
+}
+
+
+// число элементов, посчитанное обходом
+static std::size_t countKeys(const RBTreeInt& tree)
+{
+    return static_cast<std::size_t>(std::distance(tree.begin(), tree.end()));
+}
+
+
+// размер ведется всеми изменяющими операциями
+TEST_F(RBTreePubTest, getSize1)
+{
+    RBTreeInt tree;
+    EXPECT_EQ(0u, tree.getSize());
+
+    for (int i = 0; i < 100; ++i)
+        tree.insert(i);
+    tree.remove(50);
+    EXPECT_EQ(99u, tree.getSize());
+
+    // части split() считаются при первом запросе, дальше размер снова ведется
+    RBTreeInt right;
+    tree.split(60, tree, right);
+    EXPECT_EQ(countKeys(tree), tree.getSize());
+    EXPECT_EQ(countKeys(right), right.getSize());
+    right.insert(1000);
+    EXPECT_EQ(41u, right.getSize());
+
+    tree.join(tree, right);
+    EXPECT_EQ(100u, tree.getSize());
+    EXPECT_EQ(0u, right.getSize());
+
+    RBTreeInt other;
+    for (int i = 90; i < 120; ++i)
+        other.insert(i);
+    tree.unionWith(other);                  // + 100..119, кроме 1000 — уже был
+    EXPECT_EQ(countKeys(tree), tree.getSize());
+    EXPECT_EQ(0u, other.getSize());
+
+    for (int i = 0; i < 10; ++i)
+        other.insert(i * 3);
+    tree.difference(other);
+    EXPECT_EQ(countKeys(tree), tree.getSize());
+
+    for (int i = 0; i < 200; i += 2)
+        other.insert(i);
+    tree.intersect(other);
+    EXPECT_EQ(countKeys(tree), tree.getSize());
+
+    std::vector<int> batch = { 7, 7, 9, 2000, 2001 };
+    tree.insertBatch(batch.begin(), batch.end());
+    EXPECT_EQ(countKeys(tree), tree.getSize());
+
+    RBTreeDelta<int> delta;
+    delta.removes = { 2000, 3000 };
+    delta.inserts = { 5000 };
+    tree.applyDelta(delta);
+    EXPECT_EQ(countKeys(tree), tree.getSize());
+}
+
+
+// построение из последовательности, длина которой известна лишь сверху
+TEST_F(RBTreePubTest, assignSortedBounded1)
+{
+    for (int n = 0; n < 70; ++n)
+    {
+        std::vector<int> keys;
+        for (int i = 0; i < n; ++i)
+            keys.push_back(i);
+
+        RBTreeInt tree;
+        tree.assignSorted(keys.begin(), keys.end(), n + n / 2);
+        checkRange(tree, 0, n);
+
+        // узлы недозаполненного блока удаляются и добавляются как обычные
+        if (n > 0)
+        {
+            tree.remove(0);
+            tree.insert(n);
+            checkRange(tree, 1, n + 1);
+        }
+    }
+
+    // несколько блоков узлов, граница сильно завышена
+    {
+        const int n = 3 * (1 << 16) + 5;
+        std::vector<int> keys;
+        for (int i = 0; i < n; ++i)
+            keys.push_back(i);
+
+        RBTreeInt tree;
+        tree.assignSorted(keys.begin(), keys.end(), std::size_t(10) * n);
+        checkRange(tree, 0, n);
+    }
+
+    // элементов больше обещанного — дерево остается пустым
+    std::vector<int> keys = { 1, 2, 3 };
+    RBTreeInt tree;
+    EXPECT_THROW(tree.assignSorted(keys.begin(), keys.end(), 2), std::invalid_argument);
+    EXPECT_TRUE(tree.isEmpty());
+    tree.assignSorted(keys.begin(), keys.end(), 3);
+    checkRange(tree, 1, 4);
+}
+
+
+// параллельный обход видит каждый элемент один раз, свертка идет в порядке ключей
+TEST_F(RBTreePubTest, parallelReduce1)
+{
+    TaskPool pool(3);
+    const int SIZES[] = { 0, 1, 2, 100, 20000 };
+
+    for (int n : SIZES)
+        for (int withPool = 0; withPool < 2; ++withPool)
+        {
+            TaskPool* p = withPool ? &pool : nullptr;
+            RBTreeInt tree;
+            for (int i = 0; i < n; ++i)
+                tree.insert((i * 7919) % n);
+
+            std::atomic<long long> sum(0);
+            std::atomic<int> visited(0);
+            tree.parallelForEach([&](int k) { sum += k; ++visited; }, p);
+            EXPECT_EQ(n, visited.load());
+            EXPECT_EQ(static_cast<long long>(n) * (n - 1) / 2, sum.load());
+
+            EXPECT_EQ(static_cast<long long>(n) * (n - 1) / 2,
+                      tree.parallelReduce(0LL, [](int k) { return static_cast<long long>(k); },
+                                          [](long long a, long long b) { return a + b; }, p));
+
+            // некоммутативная свертка: склейка строк должна сохранить порядок
+            std::string expected;
+            for (int i = 0; i < n; ++i)
+                expected += static_cast<char>('a' + i % 26);
+            EXPECT_EQ(expected,
+                      tree.parallelReduce(std::string(),
+                                          [](int k) { return std::string(1, static_cast<char>('a' + k % 26)); },
+                                          [](const std::string& a, const std::string& b) { return a + b; }, p));
+        }
+}
+
+
 #ifdef RBTREE_WITH_DELETION
 
 class RemoveTest : public RBTreePubTest {};
@@ -158,4 +635,37 @@ TEST_F(RemoveTest, delete1)
        tree.remove(STRUCT2_SEQ[i]);
 
 }
+
+
+// случайные вставки и удаления сохраняют свойства дерева
+TEST_F(RemoveTest, delete2)
+{
+    RBTreeInt tree;
+    std::vector<int> keys;
+    for (int i = 0; i < 500; ++i)
+        keys.push_back((i * 7919) % 500);
+
+    for (int k : keys)
+        tree.insert(k);
+
+    for (int i = 0; i < 500; ++i)
+    {
+        tree.remove(keys[i]);
+        if (tree.getRoot())
+        {
+            EXPECT_TRUE(tree.getRoot()->isBlack());
+            EXPECT_EQ(nullptr, tree.getRoot()->getParent());
+        }
+        if (i % 25 == 0)
+        {
+            checkRB(tree.getRoot());
+            EXPECT_EQ(nullptr, tree.find(keys[i]));
+            for (int j = i + 1; j < 500; ++j)
+                EXPECT_NE(nullptr, tree.find(keys[j]));
+        }
+    }
+    EXPECT_TRUE(tree.isEmpty());
+
+    EXPECT_THROW(tree.remove(1), std::invalid_argument);
+}
 #endif // RBTREE_WITH_DELETION
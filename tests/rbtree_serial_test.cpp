@@ -0,0 +1,124 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTree serialization
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rbtree.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+
+
+// сериализует дерево из ключей [0, n) с шагом 3
+static std::string makeStream(int n)
+{
+    RBTreeInt tree;
+    for (int i = 0; i < n; ++i)
+        tree.insert((i * 7919 % n) * 3);
+
+    std::ostringstream os;
+    tree.serialize(os);
+    return os.str();
+}
+
+
+// запись и восстановление сохраняют элементы; восстановленное дерево — рабочее
+TEST(RBTreeSerialTest, roundTrip1)
+{
+    const int SIZES[] = { 0, 1, 2, 3, 100, 5000 };
+    for (int n : SIZES)
+    {
+        std::istringstream is(makeStream(n));
+        RBTreeInt tree;
+        tree.deserialize(is);
+
+        if (tree.getRoot())
+        {
+            EXPECT_TRUE(tree.getRoot()->isBlack());
+        }
+        checkRB(tree.getRoot());
+
+        int expected = 0;
+        for (RBTreeInt::const_iterator it = tree.begin(); it != tree.end(); ++it, expected += 3)
+            EXPECT_EQ(expected, *it);
+        EXPECT_EQ(3 * n, expected);
+
+        tree.insert(-1);
+        if (n > 0)
+            tree.remove(0);
+        checkRB(tree.getRoot());
+
+        // в непустое дерево восстанавливать нельзя
+        std::istringstream again(makeStream(n));
+        EXPECT_THROW(tree.deserialize(again), std::invalid_argument);
+    }
+}
+
+
+// строки кодируются своей специализацией
+TEST(RBTreeSerialTest, strings1)
+{
+    RBTree<std::string> tree;
+    tree.insert("");
+    tree.insert("alpha");
+    tree.insert(std::string(100000, 'z'));
+    tree.insert(std::string("with\0zero", 9));
+
+    std::stringstream ss;
+    tree.serialize(ss);
+
+    RBTree<std::string> copy;
+    copy.deserialize(ss);
+
+    std::vector<std::string> a(tree.begin(), tree.end());
+    std::vector<std::string> b(copy.begin(), copy.end());
+    EXPECT_EQ(a, b);
+}
+
+
+// поврежденные потоки отвергаются, дерево остается пустым
+TEST(RBTreeSerialTest, corrupted1)
+{
+    std::string good = makeStream(100);
+    const std::size_t HEADER = 16;
+
+    // не та сигнатура
+    std::string bad = good;
+    bad[0] = 'X';
+    // испорчен элемент — не сходится сумма (порядок тот же: меняем старший байт последнего)
+    std::string flipped = good;
+    flipped[HEADER + 99 * sizeof(int) + sizeof(int) - 1] ^= 0x40;
+    // обрезан
+    std::string truncated = good.substr(0, good.size() - 12);
+    // нарушен порядок: два первых элемента поменяны местами
+    std::string unordered = good;
+    for (std::size_t i = 0; i < sizeof(int); ++i)
+        std::swap(unordered[HEADER + i], unordered[HEADER + sizeof(int) + i]);
+
+    const std::string* streams[] = { &bad, &flipped, &truncated, &unordered };
+    for (const std::string* s : streams)
+    {
+        std::istringstream is(*s);
+        RBTreeInt tree;
+        EXPECT_THROW(tree.deserialize(is), std::runtime_error);
+        EXPECT_TRUE(tree.isEmpty());
+    }
+}
@@ -0,0 +1,137 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTree top-down insertion
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+#include "rbtree.h"
+#include "test_utils.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+
+
+// проверяет свойства дерева и что в нем ровно ключи model
+static void checkTree(const RBTreeInt &tree, const std::set<int> &model)
+{
+    if (tree.getRoot())
+    {
+        EXPECT_TRUE(tree.getRoot()->isBlack());
+        EXPECT_EQ(nullptr, tree.getRoot()->getParent());
+    }
+    checkRB(tree.getRoot());
+#ifdef RBTREE_WITH_HASHING
+    checkHashes(tree.getRoot());
+#endif // RBTREE_WITH_HASHING
+
+    std::set<int>::const_iterator m = model.begin();
+    for (RBTreeInt::const_iterator it = tree.begin(); it != tree.end(); ++it, ++m)
+    {
+        ASSERT_TRUE(m != model.end());
+        EXPECT_EQ(*m, *it);
+    }
+    EXPECT_TRUE(m == model.end());
+}
+
+
+// по возрастанию, по убыванию и вперемешку с удалениями
+TEST(RBTreeTopDownTest, insert1)
+{
+    RBTreeInt tree;
+    EXPECT_EQ(RBTreeInt::INSERT_BOTTOM_UP, tree.getInsertMode());
+    tree.setInsertMode(RBTreeInt::INSERT_TOP_DOWN);
+    EXPECT_EQ(RBTreeInt::INSERT_TOP_DOWN, tree.getInsertMode());
+
+    std::set<int> model;
+    for (int i = 0; i < 1000; ++i)
+    {
+        tree.insert(i);
+        model.insert(i);
+    }
+    checkTree(tree, model);
+
+    for (int i = -1; i >= -1000; --i)
+    {
+        tree.insert(i);
+        model.insert(i);
+    }
+    checkTree(tree, model);
+
+    std::mt19937 rng(11);
+    for (int i = 0; i < 20000; ++i)
+    {
+        int key = static_cast<int>(rng() % 5000) - 2500;
+        if (model.count(key))
+        {
+            tree.remove(key);
+            model.erase(key);
+        }
+        else
+        {
+            tree.insert(key);
+            model.insert(key);
+        }
+
+        if (i % 500 == 0)
+            checkTree(tree, model);
+    }
+    checkTree(tree, model);
+}
+
+
+// дубликат выбрасывается из корректного дерева, режимы можно чередовать
+TEST(RBTreeTopDownTest, duplicates1)
+{
+    RBTreeInt tree;
+    tree.setInsertMode(RBTreeInt::INSERT_TOP_DOWN);
+    std::set<int> model;
+    for (int i = 0; i < 300; ++i)
+    {
+        tree.insert(i * 2);
+        model.insert(i * 2);
+    }
+
+    // спуск к каждому ключу проходит свои разделения до исключения
+    for (int i = 299; i >= 0; --i)
+    {
+        EXPECT_THROW(tree.insert(i * 2), std::invalid_argument);
+        checkTree(tree, model);
+    }
+
+    tree.setInsertMode(RBTreeInt::INSERT_BOTTOM_UP);
+    for (int i = 0; i < 300; i += 2)
+    {
+        tree.insert(i * 2 + 1);
+        model.insert(i * 2 + 1);
+    }
+    tree.setInsertMode(RBTreeInt::INSERT_TOP_DOWN);
+    for (int i = 1; i < 300; i += 2)
+    {
+        tree.insert(i * 2 + 1);
+        model.insert(i * 2 + 1);
+    }
+    checkTree(tree, model);
+
+    RBTreeInt one;
+    one.setInsertMode(RBTreeInt::INSERT_TOP_DOWN);
+    one.insert(5);
+    EXPECT_THROW(one.insert(5), std::invalid_argument);
+    EXPECT_TRUE(one.getRoot()->isBlack());
+    EXPECT_EQ(5, one.find(5)->getKey());
+}
@@ -0,0 +1,224 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::RBTreeTraceRecorder and xi::RBTreeTraceReplayer
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>       // std::remove
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "rbtree_trace.h"
+
+
+using namespace xi;
+
+typedef RBTree<int> RBTreeInt;
+typedef RBTreeTraceRecorder<int, std::less<int>> RecorderInt;
+typedef RBTreeTraceReplayer<int, std::less<int>> ReplayerInt;
+
+
+static const char* TRACE_FILE = "../../out/trace.bin";
+
+
+// со всеми событиями журнал содержит по записи на каждое событие дерева
+TEST(RBTreeTraceTest, record1)
+{
+    std::uint64_t evNum;
+    {
+        RBTreeInt tree;
+        RecorderInt rec(TRACE_FILE, 4, RecorderInt::ALL_EVENTS);    // маленький буфер — сброс по заполнению
+        tree.setDumper(&rec);
+
+        for (int i = 0; i < 20; ++i)
+            tree.insert(i);
+
+        evNum = rec.getEventsNum();
+        EXPECT_LE(40u, evNum);              // минимум BST_INS + INSERT на каждую вставку
+
+        // после flush() фоновый поток дописал в файл все записи
+        rec.flush();
+        std::ifstream in(TRACE_FILE, std::ios::binary | std::ios::ate);
+        EXPECT_EQ(16 + evNum * (8 + 1 + sizeof(int)), static_cast<std::uint64_t>(in.tellg()));
+    }
+
+    ReplayerInt rpl(TRACE_FILE);
+    ReplayerInt::Record r;
+    std::uint64_t read = 0;
+    std::uint64_t lastTs = 0;
+    int inserted = 0;
+    while (rpl.next(r))
+    {
+        ++read;
+        EXPECT_LE(lastTs, r.timestamp);
+        lastTs = r.timestamp;
+        if (r.event == ReplayerInt::TDumper::DE_AFTER_INSERT)
+        {
+            EXPECT_EQ(inserted++, r.key);
+        }
+    }
+    EXPECT_EQ(evNum, read);
+    EXPECT_EQ(20, inserted);
+
+    std::remove(TRACE_FILE);
+}
+
+
+// по умолчанию пишутся только вставки и удаления, у каждой своя метка времени
+TEST(RBTreeTraceTest, defaultMask1)
+{
+    {
+        RBTreeInt tree;
+        RecorderInt rec(TRACE_FILE);
+        EXPECT_EQ(RecorderInt::DEF_EVENT_MASK, rec.getEventMask());
+        tree.setDumper(&rec);
+
+        for (int i = 0; i < 50; ++i)
+            tree.insert(i);
+        EXPECT_EQ(50u, rec.getEventsNum());
+    }
+
+    ReplayerInt rpl(TRACE_FILE);
+    ReplayerInt::Record r;
+    int read = 0;
+    while (rpl.next(r))
+    {
+        EXPECT_EQ(ReplayerInt::TDumper::DE_AFTER_INSERT, r.event);
+        EXPECT_EQ(read++, r.key);
+    }
+    EXPECT_EQ(50, read);
+
+    std::remove(TRACE_FILE);
+}
+
+
+// ошибка записи блока не теряется: ее сообщает flush()
+TEST(RBTreeTraceTest, writeError1)
+{
+    if (!std::filesystem::exists("/dev/full"))
+        return;                             // негде получить ENOSPC
+
+    RBTreeInt tree;
+    RecorderInt rec("/dev/full", 4);
+    tree.setDumper(&rec);
+    for (int i = 0; i < 20; ++i)
+        tree.insert(i);
+
+    EXPECT_THROW(rec.flush(), std::runtime_error);
+    tree.resetDumper();
+}
+
+
+// восстановление промежуточных состояний
+TEST(RBTreeTraceTest, replay1)
+{
+    std::uint64_t afterInserts;
+    {
+        RBTreeInt tree;
+        RecorderInt rec(TRACE_FILE);
+        tree.setDumper(&rec);
+
+        for (int i = 0; i < 100; ++i)
+            tree.insert(i);
+        afterInserts = rec.getEventsNum();
+
+#ifdef RBTREE_WITH_DELETION
+        for (int i = 0; i < 100; i += 2)
+            tree.remove(i);
+#endif // RBTREE_WITH_DELETION
+    }
+
+    ReplayerInt rpl(TRACE_FILE);
+
+    // состояние сразу после всех вставок
+    RBTreeInt t1;
+    EXPECT_EQ(afterInserts, rpl.replayTo(t1, afterInserts));
+    for (int i = 0; i < 100; ++i)
+        EXPECT_NE(nullptr, t1.find(i));
+
+    // конечное состояние: просим больше событий, чем есть
+    RBTreeInt t2;
+    std::uint64_t all = rpl.replayTo(t2, UINT64_MAX);
+    EXPECT_LE(afterInserts, all);
+#ifdef RBTREE_WITH_DELETION
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(i % 2 != 0, t2.find(i) != nullptr);
+#endif // RBTREE_WITH_DELETION
+
+    // в непустое дерево воспроизводить нельзя
+    EXPECT_THROW(rpl.replayTo(t2, 1), std::invalid_argument);
+
+    std::remove(TRACE_FILE);
+}
+
+
+// массовые операции пишут итог вставками и удалениями — журнал воспроизводит их результат
+TEST(RBTreeTraceTest, replayBulk1)
+{
+    std::vector<int> expected;
+    {
+        RBTreeInt tree;
+        RecorderInt rec(TRACE_FILE);
+        tree.setDumper(&rec);
+
+        std::vector<int> keys;
+        for (int i = 0; i < 100; ++i)
+            keys.push_back(i * 2);
+        tree.assignSorted(keys.begin(), keys.size());           // 0, 2, ..., 198
+
+        // отрезаем правую часть и склеиваем обратно через разделитель
+        RBTreeInt right;
+        tree.split(150, tree, right);
+        tree.join(tree, 149, right);                            // + 149
+
+        RBTreeInt other;
+        for (int i = 1; i < 40; i += 2)
+            other.insert(i);
+        tree.unionWith(other);                                  // + 1, 3, ..., 39
+
+        RBTreeInt cut;
+        for (int i = 0; i < 20; ++i)
+            cut.insert(i);
+        tree.difference(cut);                                   // - 0..19
+
+        std::vector<int> batch = { 500, 501, 20, 502 };
+        tree.insertBatch(batch.begin(), batch.end());           // + 500, 501, 502
+
+        RBTreeDelta<int> delta;
+        delta.removes = { 22, 24 };
+        delta.inserts = { 600 };
+        tree.applyDelta(delta);                                 // - 22, 24; + 600
+
+        for (RBTreeInt::ConstIterator it = tree.begin(); it != tree.end(); ++it)
+            expected.push_back(*it);
+        tree.resetDumper();
+    }
+
+    ReplayerInt rpl(TRACE_FILE);
+    RBTreeInt replayed;
+    rpl.replayTo(replayed, UINT64_MAX);
+
+    std::vector<int> actual;
+    for (RBTreeInt::ConstIterator it = replayed.begin(); it != replayed.end(); ++it)
+        actual.push_back(*it);
+    EXPECT_EQ(expected, actual);
+
+    std::remove(TRACE_FILE);
+}
+
+
+TEST(RBTreeTraceTest, badFile)
+{
+    EXPECT_THROW(ReplayerInt("../../out/no_such_trace.bin"), std::invalid_argument);
+}
@@ -0,0 +1,241 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::ShardedRBTree
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "sharded_rbtree.h"
+
+
+namespace xi
+{
+
+/** \brief Доступ тестов к закрытой реализации \c ShardedRBTree. */
+template<typename Element, typename Compar>
+class ShardedRBTreeTest
+{
+public:
+    typedef ShardedRBTree<Element, Compar> Tree;
+
+    /** \brief Возвращает число шардов, чей счетчик размера расходится с числом ключей в дереве. */
+    static std::size_t getBadSizesNum(const Tree &tree)
+    {
+        const typename Tree::ShardMap *map = tree._map.load();
+        std::size_t bad = 0;
+        for (std::size_t i = 0; i < map->shards.size(); ++i)
+        {
+            std::size_t n = 0;
+            const typename Tree::TTree &t = map->shards[i]->tree;
+            for (typename Tree::TTree::ConstIterator it = t.begin(); it != t.end(); ++it)
+                ++n;
+            if (n != map->shards[i]->size)
+                ++bad;
+        }
+        return bad;
+    }
+}; // class ShardedRBTreeTest
+
+} // namespace xi
+
+
+using namespace xi;
+
+typedef ShardedRBTree<int> ShardedInt;
+typedef ShardedRBTreeTest<int, std::less<int> > ShardedIntTest;
+
+
+// переполненные шарды делятся, порядок обхода глобальный
+TEST(ShardedRBTreeTest, split1)
+{
+    ShardedInt tree(100);
+
+    const int NUM = 2000;
+    for (int i = 0; i < NUM; ++i)
+        tree.insert((i * 7919) % NUM);
+
+    EXPECT_THROW(tree.insert(5), std::invalid_argument);
+    EXPECT_EQ(static_cast<std::size_t>(NUM), tree.getSize());
+    EXPECT_GE(tree.getShardsNum(), static_cast<std::size_t>(NUM / 100));
+
+    std::vector<int> splitters = tree.getSplitters();
+    for (std::size_t i = 1; i < splitters.size(); ++i)
+        EXPECT_LT(splitters[i - 1], splitters[i]);
+
+    int expected = 0;
+    tree.forEach([&expected](int k) { EXPECT_EQ(expected++, k); });
+    EXPECT_EQ(NUM, expected);
+
+    // диапазон через границы нескольких шардов
+    std::vector<int> range;
+    tree.forEachInRange(150, 1234, [&range](int k) { range.push_back(k); });
+    ASSERT_EQ(1234u - 150u, range.size());
+    EXPECT_EQ(150, range.front());
+    EXPECT_EQ(1233, range.back());
+
+    for (int i = 0; i < NUM; ++i)
+        EXPECT_TRUE(tree.contains(i));
+    EXPECT_FALSE(tree.contains(NUM));
+}
+
+
+#ifdef RBTREE_WITH_DELETION
+
+// опустевшие холодные шарды сливаются
+TEST(ShardedRBTreeTest, merge1)
+{
+    ShardedInt tree(100);
+
+    const int NUM = 2000;
+    for (int i = 0; i < NUM; ++i)
+        tree.insert(i);
+    std::size_t shardsBefore = tree.getShardsNum();
+
+    for (int i = 0; i < NUM - 10; ++i)
+        tree.remove(i);
+
+    EXPECT_THROW(tree.remove(0), std::invalid_argument);
+    EXPECT_EQ(10u, tree.getSize());
+    EXPECT_LT(tree.getShardsNum(), shardsBefore);
+
+    int expected = NUM - 10;
+    tree.forEach([&expected](int k) { EXPECT_EQ(expected++, k); });
+    EXPECT_EQ(NUM, expected);
+}
+
+
+// размеры половин при делении считаются, пока писатели меняют шард
+TEST(ShardedRBTreeTest, concurrentSplitCount1)
+{
+    const int PER_THREAD = 20000;
+    const int THREADS = 4;
+    ShardedInt tree(8192);
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; ++t)
+        writers.emplace_back([&tree, t]()
+        {
+            // ключи потока вперемешку; каждый третий сразу удаляется
+            for (int i = 0; i < PER_THREAD; ++i)
+            {
+                int key = ((i * 7919) % PER_THREAD) * THREADS + t;
+                tree.insert(key);
+                if (i % 3 == 0)
+                    tree.remove(key);
+            }
+        });
+    for (std::thread &w : writers)
+        w.join();
+
+    std::vector<int> keys;
+    tree.forEach([&keys](int k) { keys.push_back(k); });
+    EXPECT_EQ(keys.size(), tree.getSize());
+    EXPECT_GT(tree.getShardsNum(), 4u);
+    EXPECT_EQ(0u, ShardedIntTest::getBadSizesNum(tree));
+
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        tree.remove(keys[i]);
+    EXPECT_EQ(0u, tree.getSize());
+    EXPECT_EQ(1u, tree.getShardsNum());
+}
+
+#endif // RBTREE_WITH_DELETION
+
+
+// один горячий диапазон дробится, даже если шарды не переполнены
+TEST(ShardedRBTreeTest, hotRange1)
+{
+    std::vector<int> splitters;
+    splitters.push_back(1000000);
+    ShardedInt tree(splitters, 1 << 20);
+
+    for (int i = 0; i < 20000; ++i)
+        tree.insert(i);
+
+    EXPECT_GT(tree.getShardsNum(), 2u);
+    EXPECT_EQ(20000u, tree.getSize());
+}
+
+
+TEST(ShardedRBTreeTest, concurrentInsert1)
+{
+    const int PER_THREAD = 5000;
+    const int THREADS = 4;
+    ShardedInt tree(256);
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < THREADS; ++t)
+        writers.emplace_back([&tree, t]()
+        {
+            for (int i = 0; i < PER_THREAD; ++i)
+                tree.insert(i * THREADS + t);
+        });
+    for (std::thread &w : writers)
+        w.join();
+
+    EXPECT_EQ(static_cast<std::size_t>(PER_THREAD * THREADS), tree.getSize());
+    int expected = 0;
+    tree.forEach([&expected](int k) { EXPECT_EQ(expected++, k); });
+    EXPECT_EQ(PER_THREAD * THREADS, expected);
+}
+
+
+// читатели во время делений: вставленное видно, обход упорядочен и без повторов
+TEST(ShardedRBTreeTest, concurrentRead1)
+{
+    const int NUM = 40000;
+    ShardedInt tree(128);
+    std::atomic<int> inserted(0);
+
+    std::thread writer([&tree, &inserted]()
+    {
+        for (int i = 0; i < NUM; ++i)
+        {
+            tree.insert(i);
+            inserted.store(i + 1);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+        readers.emplace_back([&tree, &inserted, t]()
+        {
+            while (inserted.load() < NUM)
+            {
+                int upto = inserted.load();
+                if (t == 0)
+                {
+                    for (int k = 0; k < upto; k += 97)
+                    {
+                        ASSERT_TRUE(tree.contains(k));
+                    }
+                    continue;
+                }
+
+                // ключи вставляются по возрастанию: обход видит [0, upto) и, может быть, больше
+                int expected = 0;
+                tree.forEach([&expected](int k) { EXPECT_EQ(expected++, k); });
+                EXPECT_LE(upto, expected);
+            }
+        });
+
+    writer.join();
+    for (std::thread &r : readers)
+        r.join();
+
+    EXPECT_GT(tree.getShardsNum(), 100u);
+    EXPECT_EQ(static_cast<std::size_t>(NUM), tree.getSize());
+}
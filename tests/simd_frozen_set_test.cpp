@@ -0,0 +1,114 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::SimdFrozenSet
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "simd_frozen_set.h"
+
+
+using namespace xi;
+
+
+/** \brief Проверяет снимок целочисленного дерева на всех вариантах поиска, доступных процессору. */
+template<typename T>
+void checkAllLevels(const std::vector<T>& keys, const std::vector<T>& probes)
+{
+    RBTree<T> tree;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        tree.insert(keys[i]);
+
+    typedef SimdFrozenSet<T> TSet;
+    typename TSet::SimdLevel best = TSet::detectSimdLevel();
+
+    for (int lvl = TSet::SIMD_SCALAR; lvl <= best; ++lvl)
+    {
+        TSet fr(tree.begin(), keys.size(), static_cast<typename TSet::SimdLevel>(lvl));
+        EXPECT_EQ(lvl, fr.getSimdLevel());
+        EXPECT_EQ(keys.size(), fr.getSize());
+
+        for (std::size_t i = 0; i < probes.size(); ++i)
+        {
+            T p = probes[i];
+            EXPECT_EQ(tree.find(p) != nullptr, fr.contains(p));
+
+            // нижняя грань по дереву
+            typename RBTree<T>::ConstIterator it = tree.begin();
+            while (it != tree.end() && *it < p)
+                ++it;
+
+            T lb = 0;
+            bool found = fr.lowerBound(p, lb);
+            EXPECT_EQ(it != tree.end(), found);
+            if (found)
+            {
+                EXPECT_EQ(*it, lb);
+            }
+        }
+    }
+}
+
+
+TEST(SimdFrozenSetTest, int32)
+{
+    std::vector<int> keys;
+    std::vector<int> probes;
+    for (int i = -300; i < 300; i += 7)
+        keys.push_back(i);
+    for (int i = -310; i < 310; ++i)
+        probes.push_back(i);
+
+    checkAllLevels(keys, probes);
+
+    // граничные значения типа
+    std::vector<int> edges;
+    edges.push_back(INT32_MIN);
+    edges.push_back(0);
+    edges.push_back(INT32_MAX);
+    checkAllLevels(edges, edges);
+}
+
+
+TEST(SimdFrozenSetTest, uint64)
+{
+    std::vector<std::uint64_t> keys;
+    std::vector<std::uint64_t> probes;
+    for (std::uint64_t i = 0; i < 700; i += 3)
+        keys.push_back(i * 1000003ULL);
+    keys.push_back(UINT64_MAX - 1);
+    for (std::uint64_t i = 0; i < 700; ++i)
+        probes.push_back(i * 1000003ULL);
+    probes.push_back(UINT64_MAX - 1);
+    probes.push_back(UINT64_MAX);
+
+    checkAllLevels(keys, probes);
+}
+
+
+TEST(SimdFrozenSetTest, freezeSimd1)
+{
+    RBTree<int> tree;
+    SimdFrozenSet<int> empty = freezeSimd(tree);
+    EXPECT_TRUE(empty.isEmpty());
+    EXPECT_FALSE(empty.contains(0));
+
+    for (int i = 0; i < 1000; ++i)
+        tree.insert(i * 2);
+
+    SimdFrozenSet<int> fr = freezeSimd(tree);
+    EXPECT_EQ(1000u, fr.getSize());
+    for (int i = 0; i < 2000; ++i)
+        EXPECT_EQ(i % 2 == 0, fr.contains(i));
+}
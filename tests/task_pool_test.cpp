@@ -0,0 +1,115 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Unit tests for xi::TaskPool
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Gtest-based unit test.
+/// The naming conventions imply the name of a unit-test module is the same as
+/// the name of the corresponding tested module with _test suffix
+///
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "task_pool.h"
+
+
+using namespace xi;
+
+
+// сумма 1..n рекурсивным делением пополам
+static long long parallelSum(TaskPool &pool, long long lo, long long hi)
+{
+    if (hi - lo <= 16)
+    {
+        long long s = 0;
+        for (long long i = lo; i < hi; ++i)
+            s += i;
+        return s;
+    }
+
+    long long mid = lo + (hi - lo) / 2;
+    long long left = 0;
+    long long right = 0;
+    pool.invoke([&]() { left = parallelSum(pool, lo, mid); },
+                [&]() { right = parallelSum(pool, mid, hi); });
+    return left + right;
+}
+
+
+// вложенные invoke() не блокируются даже на одном потоке пула
+TEST(TaskPoolTest, invoke1)
+{
+    for (std::size_t threads = 1; threads <= 4; threads *= 2)
+    {
+        TaskPool pool(threads);
+        EXPECT_EQ(threads, pool.getThreadsNum());
+        EXPECT_EQ(100000LL * 99999LL / 2, parallelSum(pool, 0, 100000));
+    }
+}
+
+
+// несколько сторонних потоков делят один пул; потоки пула крадут работу друг у друга
+TEST(TaskPoolTest, sharedPool1)
+{
+    TaskPool pool(3);
+    EXPECT_EQ(2 + TaskPool::SPLIT_SLACK, pool.getSplitDepth());
+
+    std::vector<long long> sums(4, 0);
+    std::vector<std::thread> callers;
+    for (std::size_t t = 0; t < sums.size(); ++t)
+        callers.emplace_back([&pool, &sums, t]() { sums[t] = parallelSum(pool, 0, 50000); });
+    for (std::thread& c : callers)
+        c.join();
+
+    for (long long s : sums)
+        EXPECT_EQ(50000LL * 49999LL / 2, s);
+}
+
+
+// исключение любой половины доходит до вызывающего, когда обе завершились
+TEST(TaskPoolTest, exception1)
+{
+    TaskPool pool(2);
+    std::atomic<int> finished(0);
+
+    EXPECT_THROW(pool.invoke([&]() { ++finished; },
+                             [&]() { ++finished; throw std::runtime_error("f2"); }),
+                 std::runtime_error);
+    EXPECT_EQ(2, finished.load());
+
+    EXPECT_THROW(pool.invoke([&]() { throw std::logic_error("f1"); },
+                             [&]() { ++finished; }),
+                 std::logic_error);
+    EXPECT_EQ(3, finished.load());
+}
+
+
+// параллельная сортировка слиянием совпадает с std::sort
+TEST(TaskPoolTest, sort1)
+{
+    TaskPool pool(3);
+
+    const std::size_t SIZES[] = { 0, 1, 100, TaskPool::SORT_GRAIN + 1, 10 * TaskPool::SORT_GRAIN + 7 };
+    for (std::size_t n : SIZES)
+    {
+        std::vector<int> v;
+        for (std::size_t i = 0; i < n; ++i)
+            v.push_back(static_cast<int>((i * 104729) % 1000));
+
+        std::vector<int> expected(v);
+        std::sort(expected.begin(), expected.end(), std::greater<int>());
+
+        pool.sort(v.begin(), v.end(), std::greater<int>());
+        EXPECT_EQ(expected, v);
+    }
+}
@@ -0,0 +1,126 @@
+﻿////////////////////////////////////////////////////////////////////////////////
+/// \file
+/// \brief     Общие проверки и вспомогательные функции unit-тестов
+/// \version   0.1.0
+/// \date      18.10.2026
+///
+/// Проверка свойств красно-черного дерева годится и для узлов \c xi::RBTree
+/// (дети — указатели, есть отец), и для узлов \c xi::PersistentRBTree (дети —
+/// \c std::shared_ptr, отца нет).
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef RBTREE_TESTS_TEST_UTILS_H_
+#define RBTREE_TESTS_TEST_UTILS_H_
+
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#ifdef RBTREE_WITH_HASHING
+#include "rbtree_hash.h"
+#endif // RBTREE_WITH_HASHING
+
+
+/** \brief Возвращает узел по ссылке на ребенка: указателю или \c std::shared_ptr. */
+template<typename Node>
+inline const Node *nodePtr(const Node *nd)
+{
+    return nd;
+}
+
+template<typename Node>
+inline const Node *nodePtr(const std::shared_ptr<const Node> &nd)
+{
+    return nd.get();
+}
+
+
+/** \brief Проверяет, что ребенок \c child ссылается на отца \c nd (для узлов, хранящих отца). */
+template<typename Node>
+inline auto checkParentLink(const Node *nd, const Node *child, int) -> decltype(child->getParent(), void())
+{
+    if (child)
+    {
+        EXPECT_EQ(nd, child->getParent());
+    }
+}
+
+template<typename Node>
+inline void checkParentLink(const Node *, const Node *, long)
+{
+}
+
+
+/** \brief Проверяет свойства красно-черного поддерева \c nd: красный узел не лежит под красным
+ *  \c parentRed, черные высоты детей равны, ключи детей упорядочены относительно узла,
+ *  а дети, хранящие отца, ссылаются на \c nd.
+ *
+ *  \returns Черную высоту поддерева (пустое — 1).
+ */
+template<typename Node>
+int checkRB(const Node *nd, bool parentRed = false)
+{
+    if (!nd)
+        return 1;
+
+    typedef decltype(nd->getColor()) Color;
+    bool red = nd->getColor() == Color::RED;
+    EXPECT_FALSE(red && parentRed);
+
+    const Node *left = nodePtr(nd->getLeft());
+    const Node *right = nodePtr(nd->getRight());
+    if (left)
+    {
+        EXPECT_LT(left->getKey(), nd->getKey());
+    }
+    if (right)
+    {
+        EXPECT_LT(nd->getKey(), right->getKey());
+    }
+    checkParentLink(nd, left, 0);
+    checkParentLink(nd, right, 0);
+
+    int lh = checkRB(left, red);
+    int rh = checkRB(right, red);
+    EXPECT_EQ(lh, rh);
+
+    return lh + (red ? 0 : 1);
+}
+
+
+#ifdef RBTREE_WITH_HASHING
+
+/** \brief Пересчитывает хеши поддерева \c nd с нуля, сверяя с хранимыми; возвращает хеш поддерева. */
+template<typename Node>
+std::uint64_t checkHashes(const Node *nd)
+{
+    if (!nd)
+        return 0;
+
+    typedef typename std::decay<decltype(nd->getKey())>::type Element;
+    std::uint64_t sum = xi::RBTreeKeyHash<Element>()(nd->getKey()) + checkHashes(nd->getLeft())
+                        + checkHashes(nd->getRight());
+    EXPECT_EQ(sum, nd->getHash());
+    return sum;
+}
+
+#endif // RBTREE_WITH_HASHING
+
+
+/** \brief Возвращает путь к пустому каталогу \c prefix_name во временном каталоге тестов. */
+inline std::string freshDir(const std::string &prefix, const char *name)
+{
+    std::string dir = testing::TempDir() + prefix + "_" + name;
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+
+#endif // RBTREE_TESTS_TEST_UTILS_H_